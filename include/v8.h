@@ -147,6 +147,7 @@ template<typename T> class CustomArguments;
 class PropertyCallbackArguments;
 class FunctionCallbackArguments;
 class GlobalHandles;
+class PendingPhantomCallback;
 }
 
 
@@ -445,6 +446,39 @@ class WeakCallbackData {
 };
 
 
+/**
+ * Data passed to the callback of a phantom handle.  The object the handle
+ * referred to is already gone, only the parameter and the first two internal
+ * fields of the object (as set by SetAlignedPointerInInternalField, NULL if
+ * absent) are available.
+ */
+template<class P>
+class PhantomCallbackData {
+ public:
+  typedef void (*Callback)(const PhantomCallbackData<P>& data);
+
+  V8_INLINE Isolate* GetIsolate() const { return isolate_; }
+  V8_INLINE P* GetParameter() const { return parameter_; }
+  V8_INLINE void* GetInternalField1() const { return internal_field1_; }
+  V8_INLINE void* GetInternalField2() const { return internal_field2_; }
+
+ private:
+  friend class internal::PendingPhantomCallback;
+  PhantomCallbackData(Isolate* isolate,
+                      P* parameter,
+                      void* internal_field1,
+                      void* internal_field2)
+    : isolate_(isolate),
+      parameter_(parameter),
+      internal_field1_(internal_field1),
+      internal_field2_(internal_field2) { }
+  Isolate* isolate_;
+  P* parameter_;
+  void* internal_field1_;
+  void* internal_field2_;
+};
+
+
 // TODO(dcarney): Remove this class.
 template<typename T,
          typename P,
@@ -656,6 +690,17 @@ template <class T, class M> class Persistent {
           P* parameter,
           typename WeakReferenceCallbacks<T, P>::Revivable callback));
 
+  /**
+   * Makes the handle phantom weak.  Unlike SetWeak, the object cannot be
+   * resurrected: it is reclaimed by the same garbage collection that finds
+   * it unreachable and the callback only receives the parameter and the
+   * object's first two internal fields.  The callback must Reset the handle.
+   */
+  template<typename P>
+  V8_INLINE void SetPhantom(
+      P* parameter,
+      typename PhantomCallbackData<P>::Callback callback);
+
   V8_INLINE void ClearWeak();
 
   /**
@@ -875,6 +920,11 @@ class V8_EXPORT Data {
  * data can be calculated for a script in advance of actually
  * compiling it, and can be stored between compilations.  When script
  * data is given to the compile method compilation will be faster.
+ *
+ * The data records a hash of the source and of the V8 flags it was
+ * produced with.  Data that does not match the source or flags passed
+ * to the compile method is ignored, so it is safe to keep the data in
+ * a cache on disk across process restarts.
  */
 class V8_EXPORT ScriptData {  // NOLINT
  public:
@@ -927,6 +977,45 @@ class V8_EXPORT ScriptData {  // NOLINT
 };
 
 
+/**
+ * Pre-compiles a script on a background thread while its source is still
+ * arriving, e.g. from the network.  Add the source with AddChunk() as it
+ * becomes available and call Finish() once all of it has been added.  The
+ * resulting ScriptData can be passed to Script::Compile together with the
+ * complete source, so that the main thread skips over function bodies
+ * instead of parsing them.
+ */
+class V8_EXPORT ScriptStreamer {  // NOLINT
+ public:
+  enum Encoding { ONE_BYTE, UTF8 };
+
+  /**
+   * Creates a streamer and starts its background thread.  Can be called
+   * without entering an isolate.
+   */
+  static ScriptStreamer* New(Encoding encoding);
+
+  /**
+   * Stops the background thread if Finish() has not been called.
+   */
+  virtual ~ScriptStreamer() { }
+
+  /**
+   * Adds the next chunk of the source.  The data is copied.  Chunks may
+   * split multi-byte UTF-8 sequences.
+   */
+  virtual void AddChunk(const char* data, int length) = 0;
+
+  /**
+   * Signals the end of the source and waits for the background thread.
+   * Returns the pre-compilation data, which is owned by the caller, or NULL
+   * if the script was nested too deeply to be pre-parsed.  Must be called
+   * at most once.
+   */
+  virtual ScriptData* Finish() = 0;
+};
+
+
 /**
  * The origin, within a file, of a script.
  */
@@ -2557,6 +2646,14 @@ class V8_EXPORT ArrayBuffer : public Object {
      * That memory is guaranteed to be previously allocated by |Allocate|.
      */
     virtual void Free(void* data, size_t length) = 0;
+
+    /**
+     * Returns true if |Free| may be called on a thread other than the one
+     * that uses the isolate.  Only then, and only with
+     * --concurrent-array-buffer-freeing, does V8 free the backing stores of
+     * dead ArrayBuffers on a background thread.
+     */
+    virtual bool IsThreadSafe() { return false; }
   };
 
   /**
@@ -3776,6 +3873,18 @@ class V8_EXPORT ResourceConstraints {
   void set_max_old_space_size(int value) { max_old_space_size_ = value; }
   int max_executable_size() { return max_executable_size_; }
   void set_max_executable_size(int value) { max_executable_size_ = value; }
+  int target_gc_overhead_percent() const {
+    return target_gc_overhead_percent_;
+  }
+  /**
+   * Lets the heap size itself from the observed allocation rate and GC speed
+   * so that roughly the given percentage of time is spent in garbage
+   * collection, instead of growing by fixed factors.  The limits above still
+   * apply.  0 keeps the default.
+   */
+  void set_target_gc_overhead_percent(int value) {
+    target_gc_overhead_percent_ = value;
+  }
   uint32_t* stack_limit() const { return stack_limit_; }
   // Sets an address beyond which the VM's stack may not grow.
   void set_stack_limit(uint32_t* value) { stack_limit_ = value; }
@@ -3784,6 +3893,7 @@ class V8_EXPORT ResourceConstraints {
   int max_young_space_size_;
   int max_old_space_size_;
   int max_executable_size_;
+  int target_gc_overhead_percent_;
   uint32_t* stack_limit_;
 };
 
@@ -3903,6 +4013,35 @@ typedef void (*GCPrologueCallback)(GCType type, GCCallbackFlags flags);
 typedef void (*GCEpilogueCallback)(GCType type, GCCallbackFlags flags);
 
 
+/**
+ * Memory pressure levels for Isolate::MemoryPressureNotification.
+ * kMemoryPressureModerate asks V8 to give back memory that is cheap to
+ * release and to collect garbage incrementally, without long pauses.
+ * kMemoryPressureCritical asks V8 to free as much memory as possible right
+ * away, at the cost of a long garbage collection pause.
+ */
+enum MemoryPressureLevel {
+  kMemoryPressureNone,
+  kMemoryPressureModerate,
+  kMemoryPressureCritical
+};
+
+
+/**
+ * Invoked when the old generation is close to its maximum size: after
+ * several full garbage collections in a row that freed almost nothing, or
+ * when an allocation fails even after a last resort garbage collection.
+ * The heap limits are in bytes.  The callback may capture a heap snapshot,
+ * and it returns the new heap limit.  Returning |current_heap_limit| keeps
+ * the limit, and the process then runs out of memory.  To stop the running
+ * script cleanly, call Isolate::TerminateExecution and raise the limit a
+ * little, so that the script can reach the next interrupt check.
+ */
+typedef size_t (*NearHeapLimitCallback)(void* data,
+                                        size_t current_heap_limit,
+                                        size_t initial_heap_limit);
+
+
 /**
  * Collection of V8 heap information.
  *
@@ -3917,6 +4056,11 @@ class V8_EXPORT HeapStatistics {
   size_t total_physical_size() { return total_physical_size_; }
   size_t used_heap_size() { return used_heap_size_; }
   size_t heap_size_limit() { return heap_size_limit_; }
+  // Freed pages that are kept committed for reuse, not included in
+  // total_heap_size.
+  size_t pooled_memory_size() { return pooled_memory_size_; }
+  // Freed memory that is being returned to the OS in the background.
+  size_t pending_unmap_size() { return pending_unmap_size_; }
 
  private:
   size_t total_heap_size_;
@@ -3924,6 +4068,8 @@ class V8_EXPORT HeapStatistics {
   size_t total_physical_size_;
   size_t used_heap_size_;
   size_t heap_size_limit_;
+  size_t pooled_memory_size_;
+  size_t pending_unmap_size_;
 
   friend class V8;
   friend class Isolate;
@@ -4036,6 +4182,32 @@ class V8_EXPORT Isolate {
    */
   intptr_t AdjustAmountOfExternalAllocatedMemory(intptr_t change_in_bytes);
 
+  /**
+   * Optional notification that the system is running low on memory. Unlike
+   * V8::LowMemoryNotification the response is graded by |level|: moderate
+   * pressure releases unused new space, pooled pages and compilation caches
+   * and schedules an incremental compacting collection, critical pressure
+   * additionally flushes compiled RegExp code and inline caches and
+   * compacts the heap immediately.
+   */
+  void MemoryPressureNotification(MemoryPressureLevel level);
+
+  /**
+   * Adds a callback that is invoked when the heap is close to its limit,
+   * see NearHeapLimitCallback.  Only the most recently added callback is
+   * invoked.
+   */
+  void AddNearHeapLimitCallback(NearHeapLimitCallback callback, void* data);
+
+  /**
+   * Removes a callback added with AddNearHeapLimitCallback.  If |heap_limit|
+   * is not zero, the heap limit is set back to it.  The limit is only
+   * lowered if the old generation is still below |heap_limit|.  Removing a
+   * callback that is not registered does nothing.
+   */
+  void RemoveNearHeapLimitCallback(NearHeapLimitCallback callback,
+                                   size_t heap_limit);
+
   /**
    * Returns heap profiler for this isolate. Will return NULL until the isolate
    * is initialized.
@@ -4710,6 +4882,16 @@ class V8_EXPORT V8 {
    */
   static bool IdleNotification(int hint = 1000);
 
+  /**
+   * Optional notification that the embedder is idle until the given
+   * deadline, specified in seconds since 00:00:00 UTC, January 1, 1970.
+   * V8 uses the time to perform the garbage collection work that is
+   * estimated to finish before the deadline, based on how long recent
+   * collections took.  Returns true if the embedder should stop calling
+   * IdleNotificationDeadline until real work has been done.
+   */
+  static bool IdleNotificationDeadline(double deadline_in_seconds);
+
   /**
    * Optional notification that the system is running low on memory.
    * V8 uses these notifications to attempt to free memory.
@@ -4743,6 +4925,10 @@ class V8_EXPORT V8 {
                        void* data,
                        WeakCallback weak_callback,
                        RevivableCallback weak_reference_callback);
+  typedef PhantomCallbackData<void>::Callback PhantomCallback;
+  static void MakePhantom(internal::Object** global_handle,
+                          void* data,
+                          PhantomCallback phantom_callback);
   static void ClearWeak(internal::Object** global_handle);
   static void Eternalize(Isolate* isolate,
                          Value* handle,
@@ -5418,12 +5604,12 @@ class Internals {
 
   static const int kNodeClassIdOffset = 1 * kApiPointerSize;
   static const int kNodeFlagsOffset = 1 * kApiPointerSize + 3;
-  static const int kNodeStateMask = 0xf;
+  static const int kNodeStateMask = 0x7;
   static const int kNodeStateIsWeakValue = 2;
   static const int kNodeStateIsPendingValue = 3;
   static const int kNodeStateIsNearDeathValue = 4;
-  static const int kNodeIsIndependentShift = 4;
-  static const int kNodeIsPartiallyDependentShift = 5;
+  static const int kNodeIsIndependentShift = 3;
+  static const int kNodeIsPartiallyDependentShift = 4;
 
   static const int kJSObjectType = 0xb2;
   static const int kFirstNonstringType = 0x80;
@@ -5719,6 +5905,18 @@ void Persistent<T, M>::MakeWeak(
 }
 
 
+template <class T, class M>
+template <typename P>
+void Persistent<T, M>::SetPhantom(
+    P* parameter,
+    typename PhantomCallbackData<P>::Callback callback) {
+  typedef typename PhantomCallbackData<void>::Callback Callback;
+  V8::MakePhantom(reinterpret_cast<internal::Object**>(this->val_),
+                  parameter,
+                  reinterpret_cast<Callback>(callback));
+}
+
+
 template <class T, class M>
 void Persistent<T, M>::ClearWeak() {
   V8::ClearWeak(reinterpret_cast<internal::Object**>(this->val_));
@@ -61,6 +61,7 @@
 #include "runtime-profiler.h"
 #include "scanner-character-streams.h"
 #include "snapshot.h"
+#include "streaming-preparser.h"
 #include "unicode-inl.h"
 #include "utils/random-number-generator.h"
 #include "v8threads.h"
@@ -563,6 +564,7 @@ ResourceConstraints::ResourceConstraints()
   : max_young_space_size_(0),
     max_old_space_size_(0),
     max_executable_size_(0),
+    target_gc_overhead_percent_(0),
     stack_limit_(NULL) { }
 
 
@@ -587,6 +589,15 @@ bool SetResourceConstraints(Isolate* v8_isolate,
                                                  max_executable_size);
     if (!result) return false;
   }
+  int target_gc_overhead = constraints->target_gc_overhead_percent();
+  if (target_gc_overhead != 0) {
+    if (target_gc_overhead < 0 ||
+        target_gc_overhead > i::HeapController::kMaxTargetGCOverheadPercent) {
+      return false;
+    }
+    isolate->heap()->heap_controller()->set_target_gc_overhead_percent(
+        target_gc_overhead);
+  }
   if (constraints->stack_limit() != NULL) {
     uintptr_t limit = reinterpret_cast<uintptr_t>(constraints->stack_limit());
     isolate->stack_guard()->SetStackLimit(limit);
@@ -625,6 +636,13 @@ void V8::MakeWeak(i::Object** object,
 }
 
 
+void V8::MakePhantom(i::Object** object,
+                     void* parameters,
+                     PhantomCallback phantom_callback) {
+  i::GlobalHandles::MakePhantom(object, parameters, phantom_callback);
+}
+
+
 void V8::ClearWeak(i::Object** obj) {
   i::GlobalHandles::ClearWeakness(obj);
 }
@@ -1658,22 +1676,34 @@ ScriptData* ScriptData::PreCompile(v8::Isolate* isolate,
                                    int length) {
   i::Utf8ToUtf16CharacterStream stream(
       reinterpret_cast<const unsigned char*>(input), length);
-  return i::PreParserApi::PreParse(
+  i::ScriptDataImpl* data = i::PreParserApi::PreParse(
       reinterpret_cast<i::Isolate*>(isolate), &stream);
+  if (data != NULL) {
+    i::Utf8ToUtf16CharacterStream hash_stream(
+        reinterpret_cast<const unsigned char*>(input), length);
+    data->SetSourceAndFlagHash(&hash_stream);
+  }
+  return data;
 }
 
 
 ScriptData* ScriptData::PreCompile(v8::Handle<String> source) {
   i::Handle<i::String> str = Utils::OpenHandle(*source);
   i::Isolate* isolate = str->GetIsolate();
+  i::ScriptDataImpl* data;
   if (str->IsExternalTwoByteString()) {
     i::ExternalTwoByteStringUtf16CharacterStream stream(
       i::Handle<i::ExternalTwoByteString>::cast(str), 0, str->length());
-    return i::PreParserApi::PreParse(isolate, &stream);
+    data = i::PreParserApi::PreParse(isolate, &stream);
   } else {
     i::GenericStringUtf16CharacterStream stream(str, 0, str->length());
-    return i::PreParserApi::PreParse(isolate, &stream);
+    data = i::PreParserApi::PreParse(isolate, &stream);
+  }
+  if (data != NULL) {
+    i::GenericStringUtf16CharacterStream hash_stream(str, 0, str->length());
+    data->SetSourceAndFlagHash(&hash_stream);
   }
+  return data;
 }
 
 
@@ -1699,6 +1729,16 @@ ScriptData* ScriptData::New(const char* data, int length) {
 }
 
 
+// --- S c r i p t S t r e a m e r ---
+
+
+ScriptStreamer* ScriptStreamer::New(Encoding encoding) {
+  return new i::StreamingPreParser(
+      encoding == ONE_BYTE ? i::StreamingUtf16CharacterStream::ONE_BYTE
+                           : i::StreamingUtf16CharacterStream::UTF8);
+}
+
+
 // --- S c r i p t ---
 
 
@@ -1744,6 +1784,12 @@ Local<Script> Script::New(v8::Handle<String> source,
     if (pre_data_impl != NULL && !pre_data_impl->SanityCheck()) {
       pre_data_impl = NULL;
     }
+    // Pre-data may have been cached by the embedder across runs. Ignore it
+    // if it was produced for a different source or with different flags.
+    if (pre_data_impl != NULL && !pre_data_impl->Matches(str)) {
+      isolate->counters()->total_preparse_data_rejected()->Increment();
+      pre_data_impl = NULL;
+    }
     i::Handle<i::SharedFunctionInfo> result =
       i::Compiler::Compile(str,
                            name_obj,
@@ -5057,7 +5103,9 @@ HeapStatistics::HeapStatistics(): total_heap_size_(0),
                                   total_heap_size_executable_(0),
                                   total_physical_size_(0),
                                   used_heap_size_(0),
-                                  heap_size_limit_(0) { }
+                                  heap_size_limit_(0),
+                                  pooled_memory_size_(0),
+                                  pending_unmap_size_(0) { }
 
 
 void v8::V8::VisitExternalResources(ExternalResourceVisitor* visitor) {
@@ -5114,6 +5162,14 @@ bool v8::V8::IdleNotification(int hint) {
 }
 
 
+bool v8::V8::IdleNotificationDeadline(double deadline_in_seconds) {
+  i::Isolate* isolate = i::Isolate::Current();
+  if (isolate == NULL || !isolate->IsInitialized()) return true;
+  if (!i::FLAG_use_idle_notification) return true;
+  return isolate->heap()->IdleNotificationDeadline(deadline_in_seconds);
+}
+
+
 void v8::V8::LowMemoryNotification() {
   i::Isolate* isolate = i::Isolate::Current();
   if (isolate == NULL || !isolate->IsInitialized()) return;
@@ -5940,6 +5996,7 @@ v8::ArrayBuffer::Contents v8::ArrayBuffer::Externalize() {
   ApiCheck(!obj->is_external(),
             "v8::ArrayBuffer::Externalize",
             "ArrayBuffer already externalized");
+  obj->GetHeap()->array_buffer_tracker()->Unregister(*obj);
   obj->set_is_external(true);
   size_t byte_length = static_cast<size_t>(obj->byte_length()->Number());
   Contents contents;
@@ -6314,6 +6371,27 @@ intptr_t Isolate::AdjustAmountOfExternalAllocatedMemory(
 }
 
 
+void Isolate::MemoryPressureNotification(MemoryPressureLevel level) {
+  i::Isolate* isolate = reinterpret_cast<i::Isolate*>(this);
+  if (!isolate->IsInitialized()) return;
+  isolate->heap()->MemoryPressureNotification(level);
+}
+
+
+void Isolate::AddNearHeapLimitCallback(NearHeapLimitCallback callback,
+                                       void* data) {
+  i::Isolate* isolate = reinterpret_cast<i::Isolate*>(this);
+  isolate->heap()->AddNearHeapLimitCallback(callback, data);
+}
+
+
+void Isolate::RemoveNearHeapLimitCallback(NearHeapLimitCallback callback,
+                                          size_t heap_limit) {
+  i::Isolate* isolate = reinterpret_cast<i::Isolate*>(this);
+  isolate->heap()->RemoveNearHeapLimitCallback(callback, heap_limit);
+}
+
+
 intptr_t V8::AdjustAmountOfExternalAllocatedMemory(intptr_t change_in_bytes) {
   i::Isolate* isolate = i::Isolate::UncheckedCurrent();
   if (isolate == NULL || !isolate->IsInitialized()) {
@@ -6563,6 +6641,8 @@ void Isolate::GetHeapStatistics(HeapStatistics* heap_statistics) {
     heap_statistics->total_physical_size_ = 0;
     heap_statistics->used_heap_size_ = 0;
     heap_statistics->heap_size_limit_ = 0;
+    heap_statistics->pooled_memory_size_ = 0;
+    heap_statistics->pending_unmap_size_ = 0;
     return;
   }
   i::Heap* heap = isolate->heap();
@@ -6572,6 +6652,9 @@ void Isolate::GetHeapStatistics(HeapStatistics* heap_statistics) {
   heap_statistics->total_physical_size_ = heap->CommittedPhysicalMemory();
   heap_statistics->used_heap_size_ = heap->SizeOfObjects();
   heap_statistics->heap_size_limit_ = heap->MaxReserved();
+  i::MemoryAllocator* allocator = isolate->memory_allocator();
+  heap_statistics->pooled_memory_size_ = allocator->PooledSize();
+  heap_statistics->pending_unmap_size_ = allocator->PendingUnmapSize();
 }
 
 
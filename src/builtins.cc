@@ -260,6 +260,8 @@ static FixedArrayBase* LeftTrimFixedArray(Heap* heap,
   // debug mode which iterates through the heap), but to play safer
   // we still do it.
   heap->CreateFillerObjectAt(elms->address(), to_trim * entry_size);
+  heap->ClearRecordedSlotRange(elms->address(),
+                               elms->address() + to_trim * entry_size);
 
   int new_start_index = to_trim * (entry_size / kPointerSize);
   former_start[new_start_index] = map;
@@ -567,6 +567,12 @@ Handle<Code> KeyedLoadFastElementStub::GenerateCode(Isolate* isolate) {
 
 template<>
 HValue* CodeStubGraphBuilder<LoadFieldStub>::BuildCodeStub() {
+  if (casted_stub()->raw_double()) {
+    // The double is stored in the object itself, not in a HeapNumber.
+    return AddLoadNamedField(
+        GetParameter(0),
+        HObjectAccess::ForUnboxedDoubleField(casted_stub()->offset()));
+  }
   Representation rep = casted_stub()->representation();
   HObjectAccess access = casted_stub()->is_inobject() ?
       HObjectAccess::ForJSObjectOffset(casted_stub()->offset(), rep) :
@@ -582,6 +588,12 @@ Handle<Code> LoadFieldStub::GenerateCode(Isolate* isolate) {
 
 template<>
 HValue* CodeStubGraphBuilder<KeyedLoadFieldStub>::BuildCodeStub() {
+  if (casted_stub()->raw_double()) {
+    // The double is stored in the object itself, not in a HeapNumber.
+    return AddLoadNamedField(
+        GetParameter(0),
+        HObjectAccess::ForUnboxedDoubleField(casted_stub()->offset()));
+  }
   Representation rep = casted_stub()->representation();
   HObjectAccess access = casted_stub()->is_inobject() ?
       HObjectAccess::ForJSObjectOffset(casted_stub()->offset(), rep) :
@@ -917,9 +917,12 @@ class HandlerStub: public HICStub {
 
 class LoadFieldStub: public HandlerStub {
  public:
-  LoadFieldStub(bool inobject, int index, Representation representation)
+  LoadFieldStub(bool inobject,
+                int index,
+                Representation representation,
+                bool raw_double = false)
       : HandlerStub() {
-    Initialize(Code::LOAD_IC, inobject, index, representation);
+    Initialize(Code::LOAD_IC, inobject, index, representation, raw_double);
   }
 
   virtual Handle<Code> GenerateCode(Isolate* isolate);
@@ -952,6 +955,11 @@ class LoadFieldStub: public HandlerStub {
     return UnboxedDoubleBits::decode(bit_field_);
   }
 
+  // The field holds a raw double rather than a HeapNumber.
+  bool raw_double() {
+    return RawDoubleBits::decode(bit_field_);
+  }
+
   virtual Code::StubType GetStubType() { return Code::FIELD; }
 
  protected:
@@ -960,12 +968,15 @@ class LoadFieldStub: public HandlerStub {
   void Initialize(Code::Kind kind,
                   bool inobject,
                   int index,
-                  Representation representation) {
+                  Representation representation,
+                  bool raw_double) {
     bool unboxed_double = FLAG_track_double_fields && representation.IsDouble();
+    ASSERT(!raw_double || (unboxed_double && inobject));
     bit_field_ = KindBits::encode(kind)
         | InobjectBits::encode(inobject)
         | IndexBits::encode(index)
-        | UnboxedDoubleBits::encode(unboxed_double);
+        | UnboxedDoubleBits::encode(unboxed_double)
+        | RawDoubleBits::encode(raw_double);
   }
 
  private:
@@ -973,6 +984,7 @@ class LoadFieldStub: public HandlerStub {
   class InobjectBits: public BitField<bool, 4, 1> {};
   class IndexBits: public BitField<int, 5, 11> {};
   class UnboxedDoubleBits: public BitField<bool, 16, 1> {};
+  class RawDoubleBits: public BitField<bool, 17, 1> {};
   virtual CodeStub::Major MajorKey() { return LoadField; }
   virtual int NotMissMinorKey() { return bit_field_; }
 
@@ -982,9 +994,13 @@ class LoadFieldStub: public HandlerStub {
 
 class KeyedLoadFieldStub: public LoadFieldStub {
  public:
-  KeyedLoadFieldStub(bool inobject, int index, Representation representation)
+  KeyedLoadFieldStub(bool inobject,
+                     int index,
+                     Representation representation,
+                     bool raw_double = false)
       : LoadFieldStub() {
-    Initialize(Code::KEYED_LOAD_IC, inobject, index, representation);
+    Initialize(Code::KEYED_LOAD_IC, inobject, index, representation,
+               raw_double);
   }
 
   virtual void InitializeInterfaceDescriptor(
@@ -298,7 +298,8 @@ void RecompileJob::RecordOptimizationStats() {
 // going, not necessarily that we optimized the code.
 static bool MakeCrankshaftCode(CompilationInfo* info) {
   RecompileJob job(info);
-  RecompileJob::Status status = job.CreateGraph();
+  RecompileJob::Status status = job.CheckOptimizationLimits();
+  if (status == RecompileJob::SUCCEEDED) status = job.CreateGraph();
 
   if (status != RecompileJob::SUCCEEDED) {
     return status != RecompileJob::FAILED;
@@ -350,19 +351,7 @@ class HOptimizedGraphBuilderWithPotisions: public HOptimizedGraphBuilder {
 };
 
 
-RecompileJob::Status RecompileJob::CreateGraph() {
-  ASSERT(isolate()->use_crankshaft());
-  ASSERT(info()->IsOptimizing());
-  ASSERT(!info()->IsCompilingForDebugging());
-
-  // We should never arrive here if there is no code object on the
-  // shared function object.
-  ASSERT(info()->shared_info()->code()->kind() == Code::FUNCTION);
-
-  // We should never arrive here if optimization has been disabled on the
-  // shared function info.
-  ASSERT(!info()->shared_info()->optimization_disabled());
-
+RecompileJob::Status RecompileJob::CheckOptimizationLimits() {
   // Fall back to using the full code generator if it's not possible
   // to use the Hydrogen-based optimizing compiler. We already have
   // generated code for this from the shared function object.
@@ -380,6 +369,29 @@ RecompileJob::Status RecompileJob::CreateGraph() {
     return AbortOptimization();
   }
 
+  // Take --hydrogen-filter into account.
+  if (!info()->closure()->PassesFilter(FLAG_hydrogen_filter)) {
+    info()->AbortOptimization();
+    return SetLastStatus(BAILED_OUT);
+  }
+
+  return SetLastStatus(SUCCEEDED);
+}
+
+
+RecompileJob::Status RecompileJob::CreateGraph() {
+  ASSERT(isolate()->use_crankshaft());
+  ASSERT(info()->IsOptimizing());
+  ASSERT(!info()->IsCompilingForDebugging());
+
+  // We should never arrive here if there is no code object on the
+  // shared function object.
+  ASSERT(info()->shared_info()->code()->kind() == Code::FUNCTION);
+
+  // We should never arrive here if optimization has been disabled on the
+  // shared function info.
+  ASSERT(!info()->shared_info()->optimization_disabled());
+
   // Due to an encoding limit on LUnallocated operands in the Lithium
   // language, we cannot optimize functions with too many formal parameters
   // or perform on-stack replacement for function with too many
@@ -401,12 +413,6 @@ RecompileJob::Status RecompileJob::CreateGraph() {
     return AbortOptimization();
   }
 
-  // Take --hydrogen-filter into account.
-  if (!info()->closure()->PassesFilter(FLAG_hydrogen_filter)) {
-    info()->AbortOptimization();
-    return SetLastStatus(BAILED_OUT);
-  }
-
   // Recompile the unoptimized version of the code if the current version
   // doesn't have deoptimization support. Alternatively, we may decide to
   // run the full code generator to get a baseline for the compile-time
@@ -1095,6 +1101,28 @@ bool Compiler::RecompileConcurrent(Handle<JSFunction> closure,
       return true;
     }
 
+    // Graph building has to happen on the main thread since it reads type
+    // feedback, maps and constants straight from the heap.  Keep that part
+    // short by not parsing functions that would bail out anyway.  An
+    // active debugger only postpones optimization.
+    if (AlwaysFullCompiler(isolate)) return false;
+    RecompileJob* job = new(info->zone()) RecompileJob(*info);
+    if (job->CheckOptimizationLimits() != RecompileJob::SUCCEEDED) {
+      // The function was optimized too many times or is excluded by
+      // --hydrogen-filter.  Nothing has been compiled yet, so the
+      // unoptimized code is still the one on the shared function info.
+      // Mark it as not optimizable to keep the runtime profiler from
+      // queueing the function again.
+      shared->code()->set_optimizable(false);
+      if (!compiling_for_osr) closure->ReplaceCode(shared->code());
+      if (FLAG_trace_concurrent_recompilation) {
+        PrintF("  ** Not queueing ");
+        closure->PrintName();
+        PrintF(" for optimization, it is excluded from optimization.\n");
+      }
+      return false;
+    }
+
     if (Parser::Parse(*info)) {
       LanguageMode language_mode = info->function()->language_mode();
       info->SetLanguageMode(language_mode);
@@ -1102,7 +1130,6 @@ bool Compiler::RecompileConcurrent(Handle<JSFunction> closure,
       info->SaveHandles();
 
       if (Rewriter::Rewrite(*info) && Scope::Analyze(*info)) {
-        RecompileJob* job = new(info->zone()) RecompileJob(*info);
         RecompileJob::Status status = job->CreateGraph();
         if (status == RecompileJob::SUCCEEDED) {
           info.Detach();
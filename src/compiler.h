@@ -518,6 +518,10 @@ class RecompileJob: public ZoneObject {
     FAILED, BAILED_OUT, SUCCEEDED
   };
 
+  // Runs the bail-out checks that only depend on the shared function
+  // info, so that callers can give up before parsing.  Must have
+  // succeeded before CreateGraph is called.
+  MUST_USE_RESULT Status CheckOptimizationLimits();
   MUST_USE_RESULT Status CreateGraph();
   MUST_USE_RESULT Status OptimizeGraph();
   MUST_USE_RESULT Status GenerateAndInstallCode();
@@ -539,6 +543,15 @@ class RecompileJob: public ZoneObject {
 
   bool IsWaitingForInstall() { return awaiting_install_; }
 
+  // Latency of concurrent recompilation: the time the job spends in the
+  // input queue, and the time between the end of OptimizeGraph and the
+  // installation of the code.
+  void MarkQueued() { latency_timer_.Start(); }
+  void MarkDequeued() { time_in_queue_ = latency_timer_.Restart(); }
+  void MarkCompiled() { latency_timer_.Restart(); }
+  TimeDelta time_in_queue() const { return time_in_queue_; }
+  TimeDelta time_since_compiled() const { return latency_timer_.Elapsed(); }
+
  private:
   CompilationInfo* info_;
   HOptimizedGraphBuilder* graph_builder_;
@@ -547,6 +560,8 @@ class RecompileJob: public ZoneObject {
   TimeDelta time_taken_to_create_graph_;
   TimeDelta time_taken_to_optimize_;
   TimeDelta time_taken_to_codegen_;
+  ElapsedTimer latency_timer_;
+  TimeDelta time_in_queue_;
   Status last_status_;
   bool awaiting_install_;
 
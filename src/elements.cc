@@ -938,6 +938,8 @@ class FastElementsAccessor
               BackingStore::OffsetOfElementAt(length);
           int filler_size = (old_capacity - length) * ElementSize;
           array->GetHeap()->CreateFillerObjectAt(filler_start, filler_size);
+          array->GetHeap()->ClearRecordedSlotRange(filler_start,
+                                                   filler_start + filler_size);
         }
       } else {
         // Otherwise, fill the unused tail with holes.
@@ -214,6 +214,9 @@ DEFINE_bool(track_fields, true, "track fields with only smi values")
 DEFINE_bool(track_double_fields, true, "track fields with double values")
 DEFINE_bool(track_heap_object_fields, true, "track fields with heap values")
 DEFINE_bool(track_computed_fields, true, "track computed boilerplate fields")
+DEFINE_bool(unbox_double_fields, false,
+            "store in-object double fields unboxed (x64 only)")
+DEFINE_implication(unbox_double_fields, track_double_fields)
 DEFINE_implication(track_double_fields, track_fields)
 DEFINE_implication(track_heap_object_fields, track_fields)
 DEFINE_implication(track_computed_fields, track_fields)
@@ -324,8 +327,11 @@ DEFINE_bool(concurrent_recompilation, true,
             "optimizing hot functions asynchronously on a separate thread")
 DEFINE_bool(trace_concurrent_recompilation, false,
             "track concurrent recompilation")
+DEFINE_int(concurrent_recompilation_threads, 1,
+           "number of threads for concurrent recompilation "
+           "(1 with --trace-hydrogen or --hydrogen-stats)")
 DEFINE_int(concurrent_recompilation_queue_length, 8,
-           "the length of the concurrent compilation queue")
+           "the length of the concurrent compilation queue per thread")
 DEFINE_int(concurrent_recompilation_delay, 0,
            "artificial compilation delay in ms")
 DEFINE_bool(block_concurrent_recompilation, false,
@@ -491,7 +497,13 @@ DEFINE_bool(always_inline_smi_code, false,
 DEFINE_int(max_new_space_size, 0, "max size of the new generation (in kBytes)")
 DEFINE_int(max_old_space_size, 0, "max size of the old generation (in Mbytes)")
 DEFINE_int(max_executable_size, 0, "max size of executable memory (in Mbytes)")
+DEFINE_int(target_gc_overhead, 0,
+           "size the heap from allocation rate and GC speed so that at most "
+           "this percentage of time is spent in GC (0 = fixed growing)")
 DEFINE_bool(gc_global, false, "always perform global GCs")
+DEFINE_bool(heap_cage, false,
+            "allocate the new space and all non-executable pages from one "
+            "4 GB reservation aligned to its size (x64 only)")
 DEFINE_int(gc_interval, -1, "garbage collect after <n> allocations")
 DEFINE_bool(trace_gc, false,
             "print one trace line following each garbage collection")
@@ -530,12 +542,39 @@ DEFINE_bool(incremental_marking, true, "use incremental marking")
 DEFINE_bool(incremental_marking_steps, true, "do incremental marking steps")
 DEFINE_bool(trace_incremental_marking, false,
             "trace progress of the incremental marking")
+DEFINE_bool(concurrent_marking, false,
+            "scan objects for incremental marking on a background thread")
+DEFINE_bool(black_allocation, false,
+            "mark objects allocated in old space during incremental marking "
+            "black")
 DEFINE_bool(track_gc_object_stats, false,
             "track object counts and memory usage")
 DEFINE_bool(parallel_sweeping, true, "enable parallel sweeping")
 DEFINE_bool(concurrent_sweeping, false, "enable concurrent sweeping")
 DEFINE_int(sweeper_threads, 0,
            "number of parallel and concurrent sweeping threads")
+DEFINE_bool(parallel_scavenging, false, "enable parallel scavenging")
+DEFINE_int(scavenges_before_promotion, 1,
+           "number of scavenges an object survives in new space before it "
+           "is promoted")
+DEFINE_int(scavenger_threads, 0,
+           "number of helper threads used for parallel scavenging")
+DEFINE_bool(parallel_marking, false,
+            "mark live objects in parallel during full garbage collections")
+DEFINE_int(marking_threads, 0,
+           "number of helper threads used for parallel marking")
+DEFINE_bool(parallel_compaction, false,
+            "evacuate pages and update slots in parallel during compaction")
+DEFINE_int(compaction_threads, 0,
+           "number of helper threads used for parallel compaction")
+DEFINE_bool(parallel_weak_processing, false,
+            "prune the string table on the compaction threads while other "
+            "weak references are processed after marking")
+DEFINE_bool(concurrent_unmapping, true,
+            "return freed memory chunks to the OS on a background thread")
+DEFINE_bool(concurrent_array_buffer_freeing, false,
+            "free the backing stores of dead array buffers on a background "
+            "thread if the array buffer allocator is thread-safe")
 #ifdef VERIFY_HEAP
 DEFINE_bool(verify_heap, false, "verify heap pointers before and after GC")
 #endif
@@ -549,6 +588,8 @@ DEFINE_bool(heap_profiler_trace_objects, false,
 // v8.cc
 DEFINE_bool(use_idle_notification, true,
             "Use idle notification to reduce memory footprint.")
+DEFINE_bool(trace_idle_notification, false,
+            "print one trace line following each idle notification")
 // ic.cc
 DEFINE_bool(use_ic, true, "use inline caching")
 
@@ -562,6 +603,11 @@ DEFINE_bool(lazy_sweeping, true,
             "Use lazy sweeping for old pointer and data spaces")
 DEFINE_bool(never_compact, false,
             "Never perform compaction on full GC - testing only")
+DEFINE_bool(string_deduplication, false,
+            "merge equal sequential one-byte strings in old data space "
+            "during compaction")
+DEFINE_int(string_deduplication_min_length, 8,
+           "minimum length of strings considered for deduplication")
 DEFINE_bool(compact_code_space, true,
             "Compact code space on full non-incremental collections")
 DEFINE_bool(incremental_code_compaction, true,
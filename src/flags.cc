@@ -285,6 +285,22 @@ List<const char*>* FlagList::argv() {
 }
 
 
+uint32_t FlagList::Hash() {
+  List<const char*>* args = argv();
+  uint32_t hash = 0;
+  for (int i = 0; i < args->length(); i++) {
+    for (const char* c = args->at(i); *c != '\0'; c++) {
+      hash = StringHasher::AddCharacterCore(hash, *c);
+    }
+    // Separate the arguments so that "--a" "b" differs from "--ab".
+    hash = StringHasher::AddCharacterCore(hash, ' ');
+    DeleteArray(args->at(i));
+  }
+  delete args;
+  return StringHasher::GetHashCore(hash);
+}
+
+
 inline char NormalizeChar(char ch) {
   return ch == '_' ? '-' : ch;
 }
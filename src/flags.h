@@ -78,6 +78,9 @@ class FlagList {
 
   // Set flags as consequence of being implied by another flag.
   static void EnforceFlagImplications();
+
+  // Hash of all flags with a value different from the default.
+  static uint32_t Hash();
 };
 
 } }  // namespace v8::internal
@@ -0,0 +1,159 @@
+// Copyright 2013 the V8 project authors. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Google Inc. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "v8.h"
+
+#include "gc-idle-time-handler.h"
+
+namespace v8 {
+namespace internal {
+
+const double GCIdleTimeHandler::kConservativeTimeRatio = 0.9;
+
+
+void GCIdleTimeHandler::SpeedHistory::Add(intptr_t bytes, double time_in_ms) {
+  int index = (start_ + count_) % kSize;
+  bytes_[index] = bytes;
+  time_in_ms_[index] = time_in_ms;
+  if (count_ < kSize) {
+    count_++;
+  } else {
+    start_ = (start_ + 1) % kSize;
+  }
+}
+
+
+intptr_t GCIdleTimeHandler::SpeedHistory::Speed(intptr_t default_speed) const {
+  double bytes = 0;
+  double time_in_ms = 0;
+  for (int i = 0; i < count_; i++) {
+    int index = (start_ + i) % kSize;
+    bytes += bytes_[index];
+    time_in_ms += time_in_ms_[index];
+  }
+  // Collections that were too short to be measured say nothing about the
+  // speed, so fall back to the default instead of assuming infinite speed.
+  if (bytes == 0 || time_in_ms == 0) return default_speed;
+  return Max(static_cast<intptr_t>(bytes / time_in_ms),
+             static_cast<intptr_t>(1));
+}
+
+
+intptr_t GCIdleTimeHandler::EstimateMarkingStepSize(double idle_time_in_ms,
+                                                    intptr_t marking_speed) {
+  ASSERT(idle_time_in_ms > 0);
+  ASSERT(marking_speed > 0);
+  double step_size =
+      idle_time_in_ms * kConservativeTimeRatio * marking_speed;
+  // Avoid overflow when the embedder announces a very long idle period.
+  if (step_size >= static_cast<double>(kMaxInt)) return kMaxInt;
+  return static_cast<intptr_t>(step_size);
+}
+
+
+double GCIdleTimeHandler::EstimateTimeInMs(intptr_t bytes, intptr_t speed) {
+  ASSERT(speed > 0);
+  return static_cast<double>(bytes) / speed;
+}
+
+
+bool GCIdleTimeHandler::ShouldDoScavenge(double idle_time_in_ms,
+                                         const HeapState& state) {
+  if (state.new_space_size * 100 <
+      state.new_space_capacity * kScavengeNewSpaceFullPercent) {
+    return false;
+  }
+  return EstimateTimeInMs(state.new_space_size, ScavengeSpeedInBytesPerMs()) <=
+         idle_time_in_ms * kConservativeTimeRatio;
+}
+
+
+// The decision proceeds from the cheapest to the most expensive work: a
+// scavenge of a nearly full new space avoids a scavenge during the next
+// allocation burst, sweeping left over from the last GC has to finish before
+// a new marking cycle, and a full GC is only scheduled if its estimated
+// pause fits.  Otherwise the idle time is spent on incremental marking.
+GCIdleTimeAction GCIdleTimeHandler::Compute(double idle_time_in_ms,
+                                            const HeapState& state) {
+  if (idle_time_in_ms <= 0) {
+    if (state.incremental_marking_stopped &&
+        state.remaining_mark_sweeps_in_idle_round <= 0) {
+      return GCIdleTimeAction::Done();
+    }
+    return GCIdleTimeAction::Nothing();
+  }
+
+  if (ShouldDoScavenge(idle_time_in_ms, state)) {
+    return GCIdleTimeAction::Scavenge();
+  }
+
+  double available_time = idle_time_in_ms * kConservativeTimeRatio;
+
+  if (state.incremental_marking_complete) {
+    if (EstimateTimeInMs(state.size_of_objects,
+                         FinalizeMarkCompactSpeedInBytesPerMs()) <=
+        available_time) {
+      return GCIdleTimeAction::FullGC();
+    }
+    return GCIdleTimeAction::Nothing();
+  }
+
+  if (state.incremental_marking_stopped) {
+    if (state.remaining_mark_sweeps_in_idle_round <= 0 &&
+        state.contexts_disposed == 0) {
+      return GCIdleTimeAction::Done();
+    }
+    if (state.sweeping_in_progress) {
+      intptr_t step_size = EstimateMarkingStepSize(
+          idle_time_in_ms, MarkCompactSpeedInBytesPerMs());
+      return GCIdleTimeAction::FinalizeSweeping(step_size);
+    }
+    // Towards the end of an idle round, or after contexts were disposed,
+    // a non-incremental GC can compact the heap to reduce its footprint.
+    bool wants_full_gc = state.contexts_disposed > 0 ||
+                         state.remaining_mark_sweeps_in_idle_round <= 2 ||
+                         !state.can_start_incremental_marking;
+    if (wants_full_gc &&
+        EstimateTimeInMs(state.size_of_objects,
+                         MarkCompactSpeedInBytesPerMs()) <= available_time) {
+      return GCIdleTimeAction::FullGC();
+    }
+    if (!state.can_start_incremental_marking) {
+      return GCIdleTimeAction::Nothing();
+    }
+  }
+
+  intptr_t step_size =
+      EstimateMarkingStepSize(idle_time_in_ms, MarkingSpeedInBytesPerMs());
+  if (step_size < kMinimumMarkingStepSize) {
+    return GCIdleTimeAction::Nothing();
+  }
+  return GCIdleTimeAction::IncrementalMarking(step_size);
+}
+
+} }  // namespace v8::internal
@@ -0,0 +1,202 @@
+// Copyright 2013 the V8 project authors. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Google Inc. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef V8_GC_IDLE_TIME_HANDLER_H_
+#define V8_GC_IDLE_TIME_HANDLER_H_
+
+#include "globals.h"
+
+namespace v8 {
+namespace internal {
+
+// A piece of GC work that the idle time handler expects to fit into the
+// remaining idle time.
+class GCIdleTimeAction {
+ public:
+  enum Type {
+    // Nothing is left to do in this idle round.
+    DONE,
+    // Some work is pending but none of it fits into the idle time.
+    DO_NOTHING,
+    // Perform an incremental marking step of |parameter| bytes.
+    DO_INCREMENTAL_MARKING,
+    DO_SCAVENGE,
+    // Perform a full GC, either finalizing incremental marking or, when
+    // marking is stopped, a memory reducing mark-compact.
+    DO_FULL_GC,
+    // Sweep up to |parameter| bytes of pages left over by the last GC.
+    DO_FINALIZE_SWEEPING
+  };
+
+  static GCIdleTimeAction Done() {
+    return GCIdleTimeAction(DONE, 0);
+  }
+
+  static GCIdleTimeAction Nothing() {
+    return GCIdleTimeAction(DO_NOTHING, 0);
+  }
+
+  static GCIdleTimeAction IncrementalMarking(intptr_t step_size) {
+    return GCIdleTimeAction(DO_INCREMENTAL_MARKING, step_size);
+  }
+
+  static GCIdleTimeAction Scavenge() {
+    return GCIdleTimeAction(DO_SCAVENGE, 0);
+  }
+
+  static GCIdleTimeAction FullGC() {
+    return GCIdleTimeAction(DO_FULL_GC, 0);
+  }
+
+  static GCIdleTimeAction FinalizeSweeping(intptr_t step_size) {
+    return GCIdleTimeAction(DO_FINALIZE_SWEEPING, step_size);
+  }
+
+  Type type() const { return type_; }
+  intptr_t parameter() const { return parameter_; }
+
+ private:
+  GCIdleTimeAction(Type type, intptr_t parameter)
+      : type_(type), parameter_(parameter) { }
+
+  Type type_;
+  intptr_t parameter_;
+};
+
+
+// Keeps a short history of how fast recent collections, as reported by the
+// GCTracer, processed the heap and uses it to pick the GC work that fits
+// into an idle period announced by the embedder.
+class GCIdleTimeHandler {
+ public:
+  // The parts of the heap state the decision is based on.
+  struct HeapState {
+    intptr_t size_of_objects;
+    intptr_t new_space_size;
+    intptr_t new_space_capacity;
+    int contexts_disposed;
+    int remaining_mark_sweeps_in_idle_round;
+    bool incremental_marking_stopped;
+    bool incremental_marking_complete;
+    bool can_start_incremental_marking;
+    bool sweeping_in_progress;
+  };
+
+  // Speeds used as long as no GC of the corresponding kind was observed.
+  static const intptr_t kInitialConservativeMarkingSpeed = 100 * KB;
+  static const intptr_t kInitialConservativeMarkCompactSpeed = 2 * MB;
+  static const intptr_t kInitialConservativeFinalizeSpeed = 8 * MB;
+  static const intptr_t kInitialConservativeScavengeSpeed = 100 * KB;
+
+  // Only the given fraction of the idle time is planned with, to leave some
+  // slack for mispredictions.
+  static const double kConservativeTimeRatio;
+
+  // Marking steps smaller than this are not worth starting.
+  static const intptr_t kMinimumMarkingStepSize = 16 * KB;
+
+  // A scavenge is only scheduled once the new space is this full (percent).
+  static const int kScavengeNewSpaceFullPercent = 80;
+
+  GCIdleTimeHandler() { }
+
+  void NotifyScavenge(intptr_t bytes, double time_in_ms) {
+    scavenges_.Add(bytes, time_in_ms);
+  }
+
+  void NotifyMarkCompact(intptr_t bytes, double time_in_ms) {
+    mark_compacts_.Add(bytes, time_in_ms);
+  }
+
+  // A mark-compact that finished incremental marking.
+  void NotifyFinalizeMarkCompact(intptr_t bytes, double time_in_ms) {
+    finalize_mark_compacts_.Add(bytes, time_in_ms);
+  }
+
+  void NotifyIncrementalMarkingStep(intptr_t bytes, double time_in_ms) {
+    marking_steps_.Add(bytes, time_in_ms);
+  }
+
+  GCIdleTimeAction Compute(double idle_time_in_ms, const HeapState& state);
+
+  // Observed speeds in bytes per millisecond, or the conservative initial
+  // speed if nothing was observed yet.
+  intptr_t MarkingSpeedInBytesPerMs() const {
+    return marking_steps_.Speed(kInitialConservativeMarkingSpeed);
+  }
+
+  intptr_t MarkCompactSpeedInBytesPerMs() const {
+    return mark_compacts_.Speed(kInitialConservativeMarkCompactSpeed);
+  }
+
+  intptr_t FinalizeMarkCompactSpeedInBytesPerMs() const {
+    return finalize_mark_compacts_.Speed(kInitialConservativeFinalizeSpeed);
+  }
+
+  intptr_t ScavengeSpeedInBytesPerMs() const {
+    return scavenges_.Speed(kInitialConservativeScavengeSpeed);
+  }
+
+  static intptr_t EstimateMarkingStepSize(double idle_time_in_ms,
+                                          intptr_t marking_speed);
+
+  static double EstimateTimeInMs(intptr_t bytes, intptr_t speed);
+
+  // A ring buffer of the last kSize (bytes, time) samples.
+  class SpeedHistory {
+   public:
+    static const int kSize = 10;
+
+    SpeedHistory() : start_(0), count_(0) { }
+
+    void Add(intptr_t bytes, double time_in_ms);
+
+    // Returns the combined speed of all samples in bytes per millisecond.
+    intptr_t Speed(intptr_t default_speed) const;
+
+   private:
+    intptr_t bytes_[kSize];
+    double time_in_ms_[kSize];
+    int start_;
+    int count_;
+  };
+
+ private:
+  bool ShouldDoScavenge(double idle_time_in_ms, const HeapState& state);
+
+  SpeedHistory marking_steps_;
+  SpeedHistory mark_compacts_;
+  SpeedHistory finalize_mark_compacts_;
+  SpeedHistory scavenges_;
+
+  DISALLOW_COPY_AND_ASSIGN(GCIdleTimeHandler);
+};
+
+} }  // namespace v8::internal
+
+#endif  // V8_GC_IDLE_TIME_HANDLER_H_
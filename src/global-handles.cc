@@ -59,6 +59,13 @@ class GlobalHandles::Node {
     NEAR_DEATH  // Callback has informed the handle is near death.
   };
 
+  // Kind of callback registered for a weak handle.
+  enum WeaknessType {
+    NORMAL_WEAK,     // Callback receives a handle to the dying object.
+    REVIVABLE_WEAK,  // Callback receives the persistent and may revive it.
+    PHANTOM_WEAK     // Object is gone, callback receives internal fields.
+  };
+
   // Maps handle location (slot) to the containing node.
   static Node* FromLocation(Object** location) {
     ASSERT(OFFSET_OF(Node, object_) == 0);
@@ -77,6 +84,9 @@ class GlobalHandles::Node {
                   Internals::kNodeIsIndependentShift);
     STATIC_ASSERT(static_cast<int>(IsPartiallyDependent::kShift) ==
                   Internals::kNodeIsPartiallyDependentShift);
+    STATIC_ASSERT(static_cast<int>(NodeState::kShift) == 0);
+    STATIC_ASSERT(static_cast<int>(NodeState::kSize) ==
+                  static_cast<int>(IsIndependent::kShift));
   }
 
 #ifdef ENABLE_HANDLE_ZAPPING
@@ -169,11 +179,11 @@ class GlobalHandles::Node {
     flags_ = IsInNewSpaceList::update(flags_, v);
   }
 
-  bool is_revivable_callback() {
-    return IsRevivableCallback::decode(flags_);
+  WeaknessType weakness_type() const {
+    return NodeWeaknessType::decode(flags_);
   }
-  void set_revivable_callback(bool v) {
-    flags_ = IsRevivableCallback::update(flags_, v);
+  void set_weakness_type(WeaknessType weakness_type) {
+    flags_ = NodeWeaknessType::update(flags_, weakness_type);
   }
 
   bool IsNearDeath() const {
@@ -243,14 +253,55 @@ class GlobalHandles::Node {
     set_parameter(parameter);
     if (weak_callback != NULL) {
       weak_callback_ = weak_callback;
-      set_revivable_callback(false);
+      set_weakness_type(NORMAL_WEAK);
     } else {
       weak_callback_ =
           reinterpret_cast<WeakCallback>(revivable_callback);
-      set_revivable_callback(true);
+      set_weakness_type(REVIVABLE_WEAK);
     }
   }
 
+  void MakePhantom(void* parameter, PhantomCallback phantom_callback) {
+    ASSERT(phantom_callback != NULL);
+    ASSERT(state() != FREE);
+    set_state(WEAK);
+    set_parameter(parameter);
+    weak_callback_ = reinterpret_cast<WeakCallback>(phantom_callback);
+    set_weakness_type(PHANTOM_WEAK);
+  }
+
+  // Clears a dead phantom handle and queues its callback together with the
+  // internal fields of the object, which has to be read before it is gone.
+  void CollectPhantomCallbackData(
+      Isolate* isolate,
+      List<PendingPhantomCallback>* pending_phantom_callbacks) {
+    ASSERT(state() == WEAK && weakness_type() == PHANTOM_WEAK);
+    void* internal_fields[PendingPhantomCallback::kInternalFieldsInCallback] =
+        { NULL, NULL };
+    if (object_->IsJSObject()) {
+      JSObject* jsobject = JSObject::cast(object_);
+      int field_count = Min(jsobject->GetInternalFieldCount(),
+                            PendingPhantomCallback::kInternalFieldsInCallback);
+      for (int i = 0; i < field_count; ++i) {
+        // Only aligned pointers are handed out, these look like smis.
+        Object* field = jsobject->GetInternalField(i);
+        if (field->IsSmi()) internal_fields[i] = field;
+      }
+    }
+    pending_phantom_callbacks->Add(PendingPhantomCallback(
+        location(),
+        reinterpret_cast<PhantomCallback>(weak_callback_),
+        parameter(),
+        internal_fields[0],
+        internal_fields[1]));
+    // The handle no longer keeps anything alive and must not be reported
+    // to the embedder as a wrapper.
+    object_ = isolate->heap()->undefined_value();
+    class_id_ = v8::HeapProfiler::kPersistentHandleNoClassId;
+    set_state(NEAR_DEATH);
+    set_parameter(NULL);
+  }
+
   void ClearWeakness() {
     ASSERT(state() != FREE);
     set_state(NORMAL);
@@ -278,7 +329,8 @@ class GlobalHandles::Node {
       // Leaving V8.
       VMState<EXTERNAL> state(isolate);
       HandleScope handle_scope(isolate);
-      if (is_revivable_callback()) {
+      ASSERT(weakness_type() != PHANTOM_WEAK);
+      if (weakness_type() == REVIVABLE_WEAK) {
         RevivableCallback revivable =
             reinterpret_cast<RevivableCallback>(weak_callback_);
         revivable(reinterpret_cast<v8::Isolate*>(isolate),
@@ -320,16 +372,17 @@ class GlobalHandles::Node {
   uint8_t index_;
 
   // This stores three flags (independent, partially_dependent and
-  // in_new_space_list) and a State.
-  class NodeState:            public BitField<State, 0, 4> {};
-  class IsIndependent:        public BitField<bool,  4, 1> {};
-  class IsPartiallyDependent: public BitField<bool,  5, 1> {};
-  class IsInNewSpaceList:     public BitField<bool,  6, 1> {};
-  class IsRevivableCallback:  public BitField<bool,  7, 1> {};
+  // in_new_space_list), a State and a WeaknessType.
+  class NodeState:            public BitField<State, 0, 3> {};
+  class IsIndependent:        public BitField<bool,  3, 1> {};
+  class IsPartiallyDependent: public BitField<bool,  4, 1> {};
+  class IsInNewSpaceList:     public BitField<bool,  5, 1> {};
+  class NodeWeaknessType:     public BitField<WeaknessType, 6, 2> {};
 
   uint8_t flags_;
 
-  // Handle specific callback - might be a weak reference in disguise.
+  // Handle specific callback - might be a weak reference or a phantom
+  // callback in disguise, see weakness_type().
   WeakCallback weak_callback_;
 
   // Provided data for callback.  In FREE state, this is used for
@@ -529,6 +582,13 @@ void GlobalHandles::MakeWeak(Object** location,
 }
 
 
+void GlobalHandles::MakePhantom(Object** location,
+                                void* parameter,
+                                PhantomCallback phantom_callback) {
+  Node::FromLocation(location)->MakePhantom(parameter, phantom_callback);
+}
+
+
 void GlobalHandles::ClearWeakness(Object** location) {
   Node::FromLocation(location)->ClearWeakness();
 }
@@ -569,7 +629,12 @@ void GlobalHandles::IterateWeakRoots(ObjectVisitor* v) {
 void GlobalHandles::IdentifyWeakHandles(WeakSlotCallback f) {
   for (NodeIterator it(this); !it.done(); it.Advance()) {
     if (it.node()->IsWeak() && f(it.node()->location())) {
-      it.node()->MarkPending();
+      if (it.node()->weakness_type() == Node::PHANTOM_WEAK) {
+        it.node()->CollectPhantomCallbackData(isolate_,
+                                              &pending_phantom_callbacks_);
+      } else {
+        it.node()->MarkPending();
+      }
     }
   }
 }
@@ -594,7 +659,12 @@ void GlobalHandles::IdentifyNewSpaceWeakIndependentHandles(
     ASSERT(node->is_in_new_space_list());
     if ((node->is_independent() || node->is_partially_dependent()) &&
         node->IsWeak() && f(isolate_->heap(), node->location())) {
-      node->MarkPending();
+      if (node->weakness_type() == Node::PHANTOM_WEAK) {
+        node->CollectPhantomCallbackData(isolate_,
+                                         &pending_phantom_callbacks_);
+      } else {
+        node->MarkPending();
+      }
     }
   }
 }
@@ -664,6 +734,9 @@ bool GlobalHandles::PostGarbageCollectionProcessing(
   // GC is completely done, because the callbacks may invoke arbitrary
   // API functions.
   ASSERT(isolate_->heap()->gc_state() == Heap::NOT_IN_GC);
+  // Phantom handles were already cleared during the collection, their
+  // callbacks cannot resurrect anything and are simply run in bulk.
+  DispatchPendingPhantomCallbacks();
   const int initial_post_gc_processing_count = ++post_gc_processing_count_;
   bool next_gc_likely_to_collect_more = false;
   if (collector == SCAVENGER) {
@@ -737,6 +810,33 @@ bool GlobalHandles::PostGarbageCollectionProcessing(
 }
 
 
+void GlobalHandles::DispatchPendingPhantomCallbacks() {
+  // A callback may trigger another collection which queues more callbacks,
+  // so take them off the end of the list one at a time.
+  while (!pending_phantom_callbacks_.is_empty()) {
+    PendingPhantomCallback callback = pending_phantom_callbacks_.RemoveLast();
+    callback.Invoke(isolate_);
+  }
+}
+
+
+void PendingPhantomCallback::Invoke(Isolate* isolate) {
+  {
+    // Leaving V8.
+    VMState<EXTERNAL> state(isolate);
+    HandleScope handle_scope(isolate);
+    v8::PhantomCallbackData<void> data(
+        reinterpret_cast<v8::Isolate*>(isolate),
+        parameter_,
+        internal_field1_,
+        internal_field2_);
+    callback_(data);
+  }
+  // The callback is expected to dispose of the handle, otherwise it leaks.
+  ASSERT(!GlobalHandles::IsNearDeath(location_));
+}
+
+
 void GlobalHandles::IterateStrongRoots(ObjectVisitor* v) {
   for (NodeIterator it(this); !it.done(); it.Advance()) {
     if (it.node()->IsStrongRetainer()) {
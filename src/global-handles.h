@@ -121,6 +121,36 @@ struct ObjectGroupRetainerInfo {
 };
 
 
+// A phantom weak callback collected during the atomic pause, to be invoked
+// once the garbage collection is over.
+class PendingPhantomCallback {
+ public:
+  typedef PhantomCallbackData<void>::Callback Callback;
+
+  static const int kInternalFieldsInCallback = 2;
+
+  PendingPhantomCallback(Object** location,
+                         Callback callback,
+                         void* parameter,
+                         void* internal_field1,
+                         void* internal_field2)
+      : location_(location),
+        callback_(callback),
+        parameter_(parameter),
+        internal_field1_(internal_field1),
+        internal_field2_(internal_field2) {}
+
+  void Invoke(Isolate* isolate);
+
+ private:
+  Object** location_;
+  Callback callback_;
+  void* parameter_;
+  void* internal_field1_;
+  void* internal_field2_;
+};
+
+
 class GlobalHandles {
  public:
   ~GlobalHandles();
@@ -136,6 +166,7 @@ class GlobalHandles {
 
   typedef WeakCallbackData<v8::Value, void>::Callback WeakCallback;
   typedef WeakReferenceCallbacks<v8::Value, void>::Revivable RevivableCallback;
+  typedef PhantomCallbackData<void>::Callback PhantomCallback;
 
   // Make the global handle weak and set the callback parameter for the
   // handle.  When the garbage collector recognizes that only weak global
@@ -154,6 +185,16 @@ class GlobalHandles {
     MakeWeak(location, parameter, NULL, revivable_callback);
   }
 
+  // Make the global handle phantom weak.  Unlike ordinary weak handles the
+  // object cannot be resurrected: once the garbage collector finds it only
+  // weakly reachable, the handle is cleared during the atomic pause and the
+  // object is reclaimed in the same cycle.  After the collection the callback
+  // is invoked with the parameter and the first two internal fields of the
+  // object, and must dispose of the handle.
+  static void MakePhantom(Object** location,
+                          void* parameter,
+                          PhantomCallback phantom_callback);
+
   void RecordStats(HeapStats* stats);
 
   // Returns the current number of weak handles.
@@ -207,7 +248,8 @@ class GlobalHandles {
   void IterateWeakRoots(ObjectVisitor* v);
 
   // Find all weak handles satisfying the callback predicate, mark
-  // them as pending.
+  // them as pending.  Phantom handles among them are cleared right away
+  // and their callbacks are queued.
   void IdentifyWeakHandles(WeakSlotCallback f);
 
   // NOTE: Three ...NewSpace... functions below are used during
@@ -297,6 +339,9 @@ class GlobalHandles {
   // efficient representation (object_groups_ and implicit_ref_groups_).
   void ComputeObjectGroupsAndImplicitReferences();
 
+  // Invokes the phantom callbacks queued during the last collection.
+  void DispatchPendingPhantomCallbacks();
+
   // v8::internal::List is inefficient even for small number of elements, if we
   // don't assign any initial capacity.
   static const int kObjectGroupConnectionsCapacity = 20;
@@ -326,6 +371,9 @@ class GlobalHandles {
 
   int post_gc_processing_count_;
 
+  // Callbacks of phantom handles cleared by the last collection.
+  List<PendingPhantomCallback> pending_phantom_callbacks_;
+
   // Object groups and implicit references, public and more efficient
   // representation.
   List<ObjectGroup*> object_groups_;
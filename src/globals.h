@@ -258,6 +258,15 @@ const uintptr_t kUintptrAllBitsSet = 0xFFFFFFFFu;
 const bool kIs64BitArch = false;
 #endif
 
+#if V8_TARGET_ARCH_X64
+// With --heap-cage every non-executable chunk of the heap is allocated from
+// one reservation (the heap cage) that is aligned to its own size.  A pointer
+// into the cage is then fully determined by its lower 32 bits together with
+// the address of any other object in the cage.
+const int kHeapCageSizeLog2 = 32;
+const uintptr_t kHeapCageSize = V8_UINT64_C(1) << kHeapCageSizeLog2;
+#endif
+
 const int kBitsPerByte = 8;
 const int kBitsPerByteLog2 = 3;
 const int kBitsPerPointer = kPointerSize * kBitsPerByte;
@@ -705,6 +705,10 @@ Handle<FixedArray> GetEnumPropertyKeys(Handle<JSObject> object,
         if (!indices.is_null()) {
           if (details.type() != FIELD) {
             indices = Handle<FixedArray>();
+          } else if (FLAG_unbox_double_fields &&
+                     details.representation().IsDouble()) {
+            // Loads by field index assume a tagged field.
+            indices = Handle<FixedArray>();
           } else {
             int field_index = descs->GetFieldIndex(i);
             if (field_index >= map->inobject_properties()) {
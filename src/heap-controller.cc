@@ -0,0 +1,129 @@
+// Copyright 2013 the V8 project authors. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Google Inc. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "v8.h"
+
+#include "heap-controller.h"
+
+namespace v8 {
+namespace internal {
+
+const double HeapController::kMinHeapGrowingFactor = 1.1;
+const double HeapController::kMaxHeapGrowingFactor = 4.0;
+
+
+HeapController::HeapController()
+    : target_gc_overhead_percent_(
+          Min(Max(FLAG_target_gc_overhead, 0), kMaxTargetGCOverheadPercent)),
+      last_gc_end_time_(0),
+      new_space_size_after_last_gc_(0),
+      old_generation_sample_time_(0),
+      old_generation_sample_size_(0) { }
+
+
+void HeapController::NotifyGCStart(double time_in_ms,
+                                   intptr_t new_space_size,
+                                   intptr_t old_generation_size) {
+  if (last_gc_end_time_ > 0) {
+    new_space_allocations_.Add(
+        Max(new_space_size - new_space_size_after_last_gc_,
+            static_cast<intptr_t>(0)),
+        time_in_ms - last_gc_end_time_);
+  }
+  if (old_generation_sample_time_ > 0) {
+    old_generation_allocations_.Add(
+        Max(old_generation_size - old_generation_sample_size_,
+            static_cast<intptr_t>(0)),
+        time_in_ms - old_generation_sample_time_);
+  }
+  old_generation_sample_time_ = time_in_ms;
+  old_generation_sample_size_ = old_generation_size;
+}
+
+
+void HeapController::NotifyGCEnd(GarbageCollector collector,
+                                 double time_in_ms,
+                                 double duration_in_ms,
+                                 intptr_t survived_bytes,
+                                 intptr_t new_space_size,
+                                 intptr_t old_generation_size) {
+  last_gc_end_time_ = time_in_ms;
+  new_space_size_after_last_gc_ = new_space_size;
+  if (collector == SCAVENGER) {
+    scavenged_survivors_.Add(survived_bytes, duration_in_ms);
+  } else {
+    old_generation_sample_time_ = time_in_ms;
+    old_generation_sample_size_ = old_generation_size;
+  }
+}
+
+
+double HeapController::HeapGrowingFactor(intptr_t mark_compact_speed) const {
+  if (!IsEnabled()) return 0;
+  intptr_t allocation_rate = OldGenerationAllocationRateInBytesPerMs();
+  if (allocation_rate == 0) return 0;
+  return HeapGrowingFactor(gc_overhead(), allocation_rate, mark_compact_speed);
+}
+
+
+intptr_t HeapController::NewSpaceCapacity(intptr_t survived_bytes) const {
+  if (!IsEnabled()) return 0;
+  intptr_t allocation_rate = NewSpaceAllocationRateInBytesPerMs();
+  intptr_t scavenge_speed = SurvivorScavengeSpeedInBytesPerMs();
+  if (allocation_rate == 0 || scavenge_speed == 0) return 0;
+  double scavenge_time_in_ms =
+      GCIdleTimeHandler::EstimateTimeInMs(survived_bytes, scavenge_speed);
+  return NewSpaceCapacity(gc_overhead(), allocation_rate, scavenge_time_in_ms);
+}
+
+
+double HeapController::HeapGrowingFactor(double gc_overhead,
+                                         intptr_t allocation_rate,
+                                         intptr_t mark_compact_speed) {
+  ASSERT(gc_overhead > 0 && gc_overhead < 1);
+  ASSERT(mark_compact_speed > 0);
+  // Marking the live size L takes L / mark_compact_speed, during which the
+  // mutator has to allocate allocation_rate * L / mark_compact_speed *
+  // (1 - g) / g bytes.  Relative to L the live size cancels out.
+  double factor = 1 + static_cast<double>(allocation_rate) /
+      mark_compact_speed * (1 - gc_overhead) / gc_overhead;
+  return Min(Max(factor, kMinHeapGrowingFactor), kMaxHeapGrowingFactor);
+}
+
+
+intptr_t HeapController::NewSpaceCapacity(double gc_overhead,
+                                          intptr_t allocation_rate,
+                                          double scavenge_time_in_ms) {
+  ASSERT(gc_overhead > 0 && gc_overhead < 1);
+  double capacity = allocation_rate * scavenge_time_in_ms *
+      (1 - gc_overhead) / gc_overhead;
+  if (capacity >= static_cast<double>(kMaxInt)) return kMaxInt;
+  return static_cast<intptr_t>(capacity);
+}
+
+} }  // namespace v8::internal
@@ -0,0 +1,139 @@
+// Copyright 2013 the V8 project authors. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Google Inc. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef V8_HEAP_CONTROLLER_H_
+#define V8_HEAP_CONTROLLER_H_
+
+#include "globals.h"
+#include "gc-idle-time-handler.h"
+#include "v8globals.h"
+
+namespace v8 {
+namespace internal {
+
+// Sizes the heap so that the fraction of time spent in garbage collection
+// stays close to a target GC overhead.  The GCTracer reports every
+// collection, from which the mutator allocation rates and the scavenge speed
+// are derived.  Mark-compact speed is taken from the idle time handler.
+//
+// If a collection takes time t_gc and the mutator runs for t_mutator until
+// the next one, the overhead is t_gc / (t_gc + t_mutator).  Keeping it at or
+// below a target g requires t_mutator >= t_gc * (1 - g) / g.  This bounds how
+// far the heap has to grow between collections:
+//  - the old generation grows by a factor derived from the old generation
+//    allocation rate and the mark-compact speed;
+//  - the semispace capacity is large enough that a scavenge happens at most
+//    once per t_mutator at the new space allocation rate.
+class HeapController {
+ public:
+  static const double kMinHeapGrowingFactor;
+  static const double kMaxHeapGrowingFactor;
+
+  static const int kMaxTargetGCOverheadPercent = 50;
+
+  HeapController();
+
+  // A target of 0 disables the controller and the heap falls back to fixed
+  // growing factors.
+  int target_gc_overhead_percent() const { return target_gc_overhead_percent_; }
+  void set_target_gc_overhead_percent(int percent) {
+    ASSERT(percent >= 0 && percent <= kMaxTargetGCOverheadPercent);
+    target_gc_overhead_percent_ = percent;
+  }
+
+  bool IsEnabled() const { return target_gc_overhead_percent_ > 0; }
+
+  // Called by the GCTracer at the start and at the end of every collection.
+  // Sizes are the new space size and the size of objects in the old
+  // generation at that point.
+  void NotifyGCStart(double time_in_ms,
+                     intptr_t new_space_size,
+                     intptr_t old_generation_size);
+  void NotifyGCEnd(GarbageCollector collector,
+                   double time_in_ms,
+                   double duration_in_ms,
+                   intptr_t survived_bytes,
+                   intptr_t new_space_size,
+                   intptr_t old_generation_size);
+
+  // Observed rates in bytes per millisecond, or 0 if nothing was observed
+  // yet.
+  intptr_t NewSpaceAllocationRateInBytesPerMs() const {
+    return new_space_allocations_.Speed(0);
+  }
+
+  intptr_t OldGenerationAllocationRateInBytesPerMs() const {
+    return old_generation_allocations_.Speed(0);
+  }
+
+  intptr_t SurvivorScavengeSpeedInBytesPerMs() const {
+    return scavenged_survivors_.Speed(0);
+  }
+
+  // Returns the factor by which the old generation may grow beyond its live
+  // size before the next mark-compact, or 0 if the controller is disabled or
+  // has not observed enough collections yet.
+  double HeapGrowingFactor(intptr_t mark_compact_speed) const;
+
+  // Returns the semispace capacity needed to meet the target when each
+  // scavenge copies the given number of surviving bytes, or 0 if the
+  // controller is disabled or has not observed enough collections yet.
+  intptr_t NewSpaceCapacity(intptr_t survived_bytes) const;
+
+  static double HeapGrowingFactor(double gc_overhead,
+                                  intptr_t allocation_rate,
+                                  intptr_t mark_compact_speed);
+
+  static intptr_t NewSpaceCapacity(double gc_overhead,
+                                   intptr_t allocation_rate,
+                                   double scavenge_time_in_ms);
+
+ private:
+  double gc_overhead() const { return target_gc_overhead_percent_ / 100.0; }
+
+  int target_gc_overhead_percent_;
+
+  double last_gc_end_time_;
+  intptr_t new_space_size_after_last_gc_;
+
+  // Old generation growth is sampled from one collection start to the next,
+  // so that objects promoted by a scavenge count as allocated.  Only a
+  // mark-compact moves the sample point to the end of the collection.
+  double old_generation_sample_time_;
+  intptr_t old_generation_sample_size_;
+
+  GCIdleTimeHandler::SpeedHistory new_space_allocations_;
+  GCIdleTimeHandler::SpeedHistory old_generation_allocations_;
+  GCIdleTimeHandler::SpeedHistory scavenged_survivors_;
+
+  DISALLOW_COPY_AND_ASSIGN(HeapController);
+};
+
+} }  // namespace v8::internal
+
+#endif  // V8_HEAP_CONTROLLER_H_
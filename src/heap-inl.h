@@ -238,6 +238,24 @@ MaybeObject* Heap::AllocateRaw(int size_in_bytes,
     } else {
       return result;
     }
+  } else if ((OLD_POINTER_SPACE == space || OLD_DATA_SPACE == space) &&
+             incremental_marking()->black_allocation()) {
+    // Only explicitly tenured objects are allocated black.  Code that falls
+    // back to old space when new space is full may copy pointers into the
+    // object without a write barrier.  Large objects are left white, because
+    // the write barrier ignores slots right of the progress bar.
+    if (OLD_POINTER_SPACE == space) {
+      result = old_pointer_space_->AllocateRaw(size_in_bytes);
+    } else {
+      result = old_data_space_->AllocateRaw(size_in_bytes);
+    }
+    if (result->IsFailure()) {
+      old_gen_exhausted_ = true;
+    } else {
+      incremental_marking()->MarkAllocatedObjectBlack(
+          HeapObject::cast(result->ToObjectUnchecked()), size_in_bytes);
+    }
+    return result;
   }
 
   if (OLD_POINTER_SPACE == space) {
@@ -261,6 +279,15 @@ MaybeObject* Heap::AllocateRaw(int size_in_bytes,
 }
 
 
+void Heap::MarkMapOfBlackAllocatedObject(Map* map) {
+  if (!incremental_marking()->black_allocation()) return;
+  MarkBit map_mark_bit = Marking::MarkBitFrom(map);
+  if (Marking::IsWhite(map_mark_bit)) {
+    incremental_marking()->WhiteToGreyAndPush(map, map_mark_bit);
+  }
+}
+
+
 MaybeObject* Heap::NumberFromInt32(
     int32_t value, PretenureFlag pretenure) {
   if (Smi::IsValid(value)) return Smi::FromInt(value);
@@ -348,14 +375,11 @@ bool Heap::OldGenerationAllocationLimitReached() {
 
 bool Heap::ShouldBePromoted(Address old_address, int object_size) {
   // An object should be promoted if:
-  // - the object has survived a scavenge operation or
+  // - the object has survived --scavenges_before_promotion scavenges or
   // - to space is already 25% full.
-  NewSpacePage* page = NewSpacePage::FromAddress(old_address);
-  Address age_mark = new_space_.age_mark();
-  bool below_mark = page->IsFlagSet(MemoryChunk::NEW_SPACE_BELOW_AGE_MARK) &&
-      (!page->ContainsLimit(age_mark) || old_address < age_mark);
-  return below_mark || (new_space_.Size() + object_size) >=
-                        (new_space_.EffectiveCapacity() >> 2);
+  return new_space_.SurvivorAge(old_address) >= new_space_.promotion_age() ||
+      (new_space_.Size() + object_size) >=
+          (new_space_.EffectiveCapacity() >> 2);
 }
 
 
@@ -595,8 +619,8 @@ Isolate* Heap::isolate() {
 // to guarantee that any allocations performed during the call will
 // succeed if there's enough memory.
 
-// Warning: Do not use the identifiers __object__, __maybe_object__ or
-// __scope__ in a call to this macro.
+// Warning: Do not use the identifiers __object__, __maybe_object__,
+// __scope__ or __gc_scope__ in a call to this macro.
 
 #define CALL_AND_RETRY(ISOLATE, FUNCTION_CALL, RETURN_VALUE, RETURN_EMPTY, OOM)\
   do {                                                                         \
@@ -608,9 +632,12 @@ Isolate* Heap::isolate() {
       OOM;                                                                     \
     }                                                                          \
     if (!__maybe_object__->IsRetryAfterGC()) RETURN_EMPTY;                     \
-    (ISOLATE)->heap()->CollectGarbage(Failure::cast(__maybe_object__)->        \
-                                    allocation_space(),                        \
-                                    "allocation failure");                     \
+    {                                                                          \
+      AllocationFailureGCScope __gc_scope__((ISOLATE)->heap());                \
+      (ISOLATE)->heap()->CollectGarbage(Failure::cast(__maybe_object__)->      \
+                                      allocation_space(),                      \
+                                      "allocation failure");                   \
+    }                                                                          \
     __maybe_object__ = FUNCTION_CALL;                                          \
     if (__maybe_object__->ToObject(&__object__)) RETURN_VALUE;                 \
     if (__maybe_object__->IsOutOfMemory()) {                                   \
@@ -618,7 +645,10 @@ Isolate* Heap::isolate() {
     }                                                                          \
     if (!__maybe_object__->IsRetryAfterGC()) RETURN_EMPTY;                     \
     (ISOLATE)->counters()->gc_last_resort_from_handles()->Increment();         \
-    (ISOLATE)->heap()->CollectAllAvailableGarbage("last resort gc");           \
+    {                                                                          \
+      AllocationFailureGCScope __gc_scope__((ISOLATE)->heap());                \
+      (ISOLATE)->heap()->CollectAllAvailableGarbage("last resort gc");         \
+    }                                                                          \
     {                                                                          \
       AlwaysAllocateScope __scope__;                                           \
       __maybe_object__ = FUNCTION_CALL;                                        \
@@ -627,6 +657,12 @@ Isolate* Heap::isolate() {
     if (__maybe_object__->IsOutOfMemory()) {                                   \
       OOM;                                                                     \
     }                                                                          \
+    if (__maybe_object__->IsRetryAfterGC() &&                                  \
+        (ISOLATE)->heap()->InvokeNearHeapLimitCallback()) {                    \
+      AlwaysAllocateScope __scope__;                                           \
+      __maybe_object__ = FUNCTION_CALL;                                        \
+      if (__maybe_object__->ToObject(&__object__)) RETURN_VALUE;               \
+    }                                                                          \
     if (__maybe_object__->IsRetryAfterGC()) {                                  \
       /* TODO(1181417): Fix this. */                                           \
       v8::internal::V8::FatalProcessOutOfMemory("CALL_AND_RETRY_LAST", true);  \
@@ -816,6 +852,17 @@ AlwaysAllocateScope::~AlwaysAllocateScope() {
 }
 
 
+AllocationFailureGCScope::AllocationFailureGCScope(Heap* heap)
+    : heap_(heap), previous_(heap->collecting_for_allocation_failure_) {
+  heap_->collecting_for_allocation_failure_ = true;
+}
+
+
+AllocationFailureGCScope::~AllocationFailureGCScope() {
+  heap_->collecting_for_allocation_failure_ = previous_;
+}
+
+
 #ifdef VERIFY_HEAP
 NoWeakObjectVerificationScope::NoWeakObjectVerificationScope() {
   Isolate* isolate = Isolate::Current();
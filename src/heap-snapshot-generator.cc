@@ -1531,6 +1531,8 @@ void V8HeapExplorer::ExtractPropertyReferences(JSObject* js_obj, int entry) {
       switch (descs->GetType(i)) {
         case FIELD: {
           int index = descs->GetFieldIndex(i);
+          // Unboxed doubles do not reference anything.
+          if (js_obj->IsUnboxedDoubleField(index)) break;
 
           Name* k = descs->GetKey(i);
           if (index < js_obj->map()->inobject_properties()) {
@@ -44,11 +44,15 @@
 #include "objects-visiting.h"
 #include "objects-visiting-inl.h"
 #include "once.h"
+#include "platform/condition-variable.h"
 #include "runtime-profiler.h"
+#include "scavenger-thread.h"
 #include "scopeinfo.h"
 #include "snapshot.h"
 #include "store-buffer.h"
+#include "unmapper-thread.h"
 #include "utils/random-number-generator.h"
+#include "v8conversions.h"
 #include "v8threads.h"
 #include "v8utils.h"
 #include "vm-state-inl.h"
@@ -74,6 +78,7 @@ Heap::Heap()
       max_semispace_size_(8 * (kPointerSize / 4)  * MB),
       initial_semispace_size_(Page::kPageSize),
       max_old_generation_size_(700ul * (kPointerSize / 4) * MB),
+      initial_max_old_generation_size_(0),
       max_executable_size_(256ul * (kPointerSize / 4) * MB),
 // Variables set based on semispace_size_ and old_generation_size_ in
 // ConfigureHeap (survived_since_last_expansion_, external_allocation_limit_)
@@ -114,7 +119,10 @@ Heap::Heap()
       amount_of_external_allocated_memory_(0),
       amount_of_external_allocated_memory_at_last_global_gc_(0),
       old_gen_exhausted_(false),
-      store_buffer_rebuilder_(store_buffer()),
+      consecutive_ineffective_mark_compacts_(0),
+      invoking_near_heap_limit_callback_(false),
+      collecting_for_allocation_failure_(false),
+      last_mark_compact_end_time_(0.0),
       hidden_string_(NULL),
       gc_safe_size_of_old_object_(NULL),
       total_regexp_code_generated_(0),
@@ -123,6 +131,7 @@ Heap::Heap()
       high_survival_rate_period_length_(0),
       low_survival_rate_period_length_(0),
       survival_rate_(0),
+      promotion_rate_(0),
       previous_survival_rate_trend_(Heap::STABLE),
       survival_rate_trend_(Heap::STABLE),
       max_gc_pause_(0.0),
@@ -149,6 +158,8 @@ Heap::Heap()
       no_weak_object_verification_scope_depth_(0),
 #endif
       promotion_queue_(this),
+      parallel_scavenger_(NULL),
+      objects_evacuated_by_scavenger_threads_(0),
       configured_(false),
       chunks_queued_for_free_(NULL),
       relocation_mutex_(NULL) {
@@ -177,6 +188,7 @@ Heap::Heap()
   allocation_sites_list_ = Smi::FromInt(0);
   mark_compact_collector_.heap_ = this;
   external_string_table_.heap_ = this;
+  array_buffer_tracker_.heap_ = this;
   // Put a dummy entry in the remembered pages so we can find the list the
   // minidump even if there are no real unmapped pages.
   RememberUnmappedPage(NULL, false);
@@ -506,6 +518,8 @@ void Heap::GarbageCollectionEpilogue() {
 
   AllowHeapAllocation for_the_rest_of_the_epilogue;
 
+  ShrinkStringTable();
+
 #ifdef DEBUG
   if (FLAG_print_global_handles) isolate_->global_handles()->Print();
   if (FLAG_print_handles) PrintHandles();
@@ -635,7 +649,7 @@ void Heap::CollectAllGarbage(int flags, const char* gc_reason) {
 }
 
 
-void Heap::CollectAllAvailableGarbage(const char* gc_reason) {
+void Heap::CollectAllAvailableGarbage(const char* gc_reason, int flags) {
   // Since we are ignoring the return value, the exact choice of space does
   // not matter, so long as we do not specify NEW_SPACE, which would not
   // cause a full GC.
@@ -653,7 +667,8 @@ void Heap::CollectAllAvailableGarbage(const char* gc_reason) {
     isolate()->optimizing_compiler_thread()->Flush();
   }
   mark_compact_collector()->SetFlags(kMakeHeapIterableMask |
-                                     kReduceMemoryFootprintMask);
+                                     kReduceMemoryFootprintMask |
+                                     flags);
   isolate_->compilation_cache()->Clear();
   const int kMaxNumberOfAttempts = 7;
   const int kMinNumberOfAttempts = 2;
@@ -667,6 +682,7 @@ void Heap::CollectAllAvailableGarbage(const char* gc_reason) {
   new_space_.Shrink();
   UncommitFromSpace();
   incremental_marking()->UncommitMarkingDeque();
+  isolate_->memory_allocator()->ReleasePooledChunks();
 }
 
 
@@ -734,6 +750,17 @@ bool Heap::CollectGarbage(AllocationSpace space,
     GarbageCollectionEpilogue();
   }
 
+  // The callback may allocate, e.g. to take a heap snapshot, so it is only
+  // invoked once the GC is over.
+  if (consecutive_ineffective_mark_compacts_ >=
+          kMaxConsecutiveIneffectiveMarkCompacts &&
+      !invoking_near_heap_limit_callback_) {
+    if (!InvokeNearHeapLimitCallback()) {
+      V8::FatalProcessOutOfMemory("Ineffective mark-compacts near heap limit");
+    }
+    consecutive_ineffective_mark_compacts_ = 0;
+  }
+
   // Start incremental marking for the next cycle. The heap snapshot
   // generator needs incremental marking to stay off after it aborted.
   if (!mark_compact_collector()->abort_incremental_marking() &&
@@ -760,8 +787,10 @@ int Heap::NotifyContextDisposed() {
 void Heap::PerformScavenge() {
   GCTracer tracer(this, NULL, NULL);
   if (incremental_marking()->IsStopped()) {
+    tracer.set_collector(SCAVENGER);
     PerformGarbageCollection(SCAVENGER, &tracer);
   } else {
+    tracer.set_collector(MARK_COMPACTOR);
     PerformGarbageCollection(MARK_COMPACTOR, &tracer);
   }
 }
@@ -990,6 +1019,9 @@ bool Heap::PerformGarbageCollection(GarbageCollector collector,
   }
 
   if (collector == MARK_COMPACTOR) {
+    intptr_t old_gen_size_before_gc = PromotedSpaceSizeOfObjects();
+    double mark_compact_start_time = OS::TimeCurrentMillis();
+
     // Perform mark-sweep with optional compaction.
     MarkCompact(tracer);
     sweep_generation_++;
@@ -997,6 +1029,8 @@ bool Heap::PerformGarbageCollection(GarbageCollector collector,
     UpdateSurvivalRateTrend(start_new_space_size);
 
     size_of_old_gen_at_last_old_space_gc_ = PromotedSpaceSizeOfObjects();
+    UpdateIneffectiveMarkCompacts(old_gen_size_before_gc,
+                                  mark_compact_start_time);
 
     old_generation_allocation_limit_ =
         OldGenerationAllocationLimit(size_of_old_gen_at_last_old_space_gc_);
@@ -1051,6 +1085,15 @@ bool Heap::PerformGarbageCollection(GarbageCollector collector,
   if (new_space_high_promotion_mode_active_ &&
       new_space_.Capacity() > new_space_.InitialCapacity()) {
     new_space_.Shrink();
+  } else if (collector == SCAVENGER &&
+             new_space_.Capacity() > new_space_.InitialCapacity()) {
+    // Give back semispace memory that the heap controller does not need to
+    // meet the target GC overhead.
+    intptr_t desired_capacity =
+        heap_controller_.NewSpaceCapacity(young_survivors_after_last_gc_);
+    if (desired_capacity > 0 && 2 * desired_capacity < new_space_.Capacity()) {
+      new_space_.Shrink();
+    }
   }
 
   isolate_->counters()->objs_since_last_young()->Set(0);
@@ -1242,7 +1285,48 @@ static void VerifyNonPointerSpacePointers(Heap* heap) {
 #endif  // VERIFY_HEAP
 
 
+intptr_t Heap::OldGenerationAllocationLimit(intptr_t old_gen_size) {
+  double factor = FLAG_stress_compaction ? 0 :
+      heap_controller_.HeapGrowingFactor(
+          gc_idle_time_handler_.MarkCompactSpeedInBytesPerMs());
+  intptr_t limit;
+  if (factor > 0) {
+    // The heap controller sized the old generation for the target GC
+    // overhead from the observed allocation rate and mark-compact speed.
+    limit = Max(static_cast<intptr_t>(old_gen_size * factor),
+                kMinimumOldGenerationAllocationLimit);
+    limit += new_space_.Capacity();
+  } else {
+    const int divisor = FLAG_stress_compaction ? 10 :
+        new_space_high_promotion_mode_active_ ? 1 : 3;
+    limit = Max(old_gen_size + old_gen_size / divisor,
+                kMinimumOldGenerationAllocationLimit);
+    limit += new_space_.Capacity();
+    // TODO(hpayer): Can be removed when when pretenuring is supported for all
+    // allocation sites.
+    if (IsHighSurvivalRate() && IsStableOrIncreasingSurvivalTrend()) {
+      limit *= 2;
+    }
+  }
+  intptr_t halfway_to_the_max = (old_gen_size + max_old_generation_size_) / 2;
+  return Min(limit, halfway_to_the_max);
+}
+
+
 void Heap::CheckNewSpaceExpansionCriteria() {
+  intptr_t desired_capacity =
+      heap_controller_.NewSpaceCapacity(young_survivors_after_last_gc_);
+  if (desired_capacity > 0) {
+    // Grow the size of new space if scavenges are too frequent for the target
+    // GC overhead at the current allocation rate.
+    if (new_space_.Capacity() < new_space_.MaximumCapacity() &&
+        desired_capacity > new_space_.Capacity() &&
+        !new_space_high_promotion_mode_active_) {
+      new_space_.Grow();
+      survived_since_last_expansion_ = 0;
+    }
+    return;
+  }
   if (new_space_.Capacity() < new_space_.MaximumCapacity() &&
       survived_since_last_expansion_ > new_space_.Capacity() &&
       !new_space_high_promotion_mode_active_) {
@@ -1261,64 +1345,6 @@ static bool IsUnscavengedHeapObject(Heap* heap, Object** p) {
 }
 
 
-void Heap::ScavengeStoreBufferCallback(
-    Heap* heap,
-    MemoryChunk* page,
-    StoreBufferEvent event) {
-  heap->store_buffer_rebuilder_.Callback(page, event);
-}
-
-
-void StoreBufferRebuilder::Callback(MemoryChunk* page, StoreBufferEvent event) {
-  if (event == kStoreBufferStartScanningPagesEvent) {
-    start_of_current_page_ = NULL;
-    current_page_ = NULL;
-  } else if (event == kStoreBufferScanningPageEvent) {
-    if (current_page_ != NULL) {
-      // If this page already overflowed the store buffer during this iteration.
-      if (current_page_->scan_on_scavenge()) {
-        // Then we should wipe out the entries that have been added for it.
-        store_buffer_->SetTop(start_of_current_page_);
-      } else if (store_buffer_->Top() - start_of_current_page_ >=
-                 (store_buffer_->Limit() - store_buffer_->Top()) >> 2) {
-        // Did we find too many pointers in the previous page?  The heuristic is
-        // that no page can take more then 1/5 the remaining slots in the store
-        // buffer.
-        current_page_->set_scan_on_scavenge(true);
-        store_buffer_->SetTop(start_of_current_page_);
-      } else {
-        // In this case the page we scanned took a reasonable number of slots in
-        // the store buffer.  It has now been rehabilitated and is no longer
-        // marked scan_on_scavenge.
-        ASSERT(!current_page_->scan_on_scavenge());
-      }
-    }
-    start_of_current_page_ = store_buffer_->Top();
-    current_page_ = page;
-  } else if (event == kStoreBufferFullEvent) {
-    // The current page overflowed the store buffer again.  Wipe out its entries
-    // in the store buffer and mark it scan-on-scavenge again.  This may happen
-    // several times while scanning.
-    if (current_page_ == NULL) {
-      // Store Buffer overflowed while scanning promoted objects.  These are not
-      // in any particular page, though they are likely to be clustered by the
-      // allocation routines.
-      store_buffer_->EnsureSpace(StoreBuffer::kStoreBufferSize / 2);
-    } else {
-      // Store Buffer overflowed while scanning a particular old space page for
-      // pointers to new space.
-      ASSERT(current_page_ == page);
-      ASSERT(page != NULL);
-      current_page_->set_scan_on_scavenge(true);
-      ASSERT(start_of_current_page_ != store_buffer_->Top());
-      store_buffer_->SetTop(start_of_current_page_);
-    }
-  } else {
-    UNREACHABLE();
-  }
-}
-
-
 void PromotionQueue::Initialize() {
   // Assumes that a NewSpacePage exactly fits a number of promotion queue
   // entries (where each is a pair of intptr_t). This allows us to simplify
@@ -1430,58 +1456,64 @@ void Heap::Scavenge() {
   Address new_space_front = new_space_.ToSpaceStart();
   promotion_queue_.Initialize();
 
-#ifdef DEBUG
-  store_buffer()->Clean();
-#endif
-
   ScavengeVisitor scavenge_visitor(this);
-  // Copy roots.
-  IterateRoots(&scavenge_visitor, VISIT_ALL_IN_SCAVENGE);
+  objects_evacuated_by_scavenger_threads_ = 0;
+  if (CanScavengeInParallel()) {
+    new_space_front = ScavengeInParallel();
+  } else {
+    // Copy roots.
+    IterateRoots(&scavenge_visitor, VISIT_ALL_IN_SCAVENGE);
 
-  // Copy objects reachable from the old generation.
-  {
-    StoreBufferRebuildScope scope(this,
-                                  store_buffer(),
-                                  &ScavengeStoreBufferCallback);
-    store_buffer()->IteratePointersToNewSpace(&ScavengeObject);
-  }
+    // Copy objects reachable from the old generation.
+    {
+      StoreBufferRebuildScope scope(store_buffer());
+      store_buffer()->IteratePointersToNewSpace(&ScavengeObject);
+    }
 
-  // Copy objects reachable from simple cells by scavenging cell values
-  // directly.
-  HeapObjectIterator cell_iterator(cell_space_);
-  for (HeapObject* heap_object = cell_iterator.Next();
-       heap_object != NULL;
-       heap_object = cell_iterator.Next()) {
-    if (heap_object->IsCell()) {
-      Cell* cell = Cell::cast(heap_object);
-      Address value_address = cell->ValueAddress();
-      scavenge_visitor.VisitPointer(reinterpret_cast<Object**>(value_address));
+    // Copy objects reachable from simple cells by scavenging cell values
+    // directly.
+    HeapObjectIterator cell_iterator(cell_space_);
+    for (HeapObject* heap_object = cell_iterator.Next();
+         heap_object != NULL;
+         heap_object = cell_iterator.Next()) {
+      if (heap_object->IsCell()) {
+        Cell* cell = Cell::cast(heap_object);
+        Address value_address = cell->ValueAddress();
+        scavenge_visitor.VisitPointer(
+            reinterpret_cast<Object**>(value_address));
+      }
     }
-  }
 
-  // Copy objects reachable from global property cells by scavenging global
-  // property cell values directly.
-  HeapObjectIterator js_global_property_cell_iterator(property_cell_space_);
-  for (HeapObject* heap_object = js_global_property_cell_iterator.Next();
-       heap_object != NULL;
-       heap_object = js_global_property_cell_iterator.Next()) {
-    if (heap_object->IsPropertyCell()) {
-      PropertyCell* cell = PropertyCell::cast(heap_object);
-      Address value_address = cell->ValueAddress();
-      scavenge_visitor.VisitPointer(reinterpret_cast<Object**>(value_address));
-      Address type_address = cell->TypeAddress();
-      scavenge_visitor.VisitPointer(reinterpret_cast<Object**>(type_address));
+    // Copy objects reachable from global property cells by scavenging global
+    // property cell values directly.
+    HeapObjectIterator js_global_property_cell_iterator(property_cell_space_);
+    for (HeapObject* heap_object = js_global_property_cell_iterator.Next();
+         heap_object != NULL;
+         heap_object = js_global_property_cell_iterator.Next()) {
+      if (heap_object->IsPropertyCell()) {
+        PropertyCell* cell = PropertyCell::cast(heap_object);
+        Address value_address = cell->ValueAddress();
+        scavenge_visitor.VisitPointer(
+            reinterpret_cast<Object**>(value_address));
+        Address type_address = cell->TypeAddress();
+        scavenge_visitor.VisitPointer(
+            reinterpret_cast<Object**>(type_address));
+      }
     }
-  }
 
-  // Copy objects reachable from the code flushing candidates list.
-  MarkCompactCollector* collector = mark_compact_collector();
-  if (collector->is_code_flushing_enabled()) {
-    collector->code_flusher()->IteratePointersToFromSpace(&scavenge_visitor);
-  }
+    // Copy objects reachable from the code flushing candidates list.
+    MarkCompactCollector* collector = mark_compact_collector();
+    if (collector->is_code_flushing_enabled()) {
+      collector->code_flusher()->IteratePointersToFromSpace(&scavenge_visitor);
+    }
+
+    // Copy weak collections encountered by incremental marking.
+    scavenge_visitor.VisitPointer(
+        collector->encountered_weak_collections_address());
 
-  // Scavenge object reachable from the native contexts list directly.
-  scavenge_visitor.VisitPointer(BitCast<Object**>(&native_contexts_list_));
+    // Scavenge object reachable from the native contexts list directly.
+    scavenge_visitor.VisitPointer(BitCast<Object**>(&native_contexts_list_));
+  }
 
   new_space_front = DoScavenge(&scavenge_visitor, new_space_front);
 
@@ -1512,6 +1544,7 @@ void Heap::Scavenge() {
   ProcessWeakReferences(&weak_object_retainer);
 
   ASSERT(new_space_front == new_space_.top());
+  new_space_.CloseSurvivorAreas();
 
   // Set age mark.
   new_space_.set_age_mark(new_space_.top());
@@ -1520,8 +1553,11 @@ void Heap::Scavenge() {
       new_space_.inline_allocation_limit_step());
 
   // Update how much has survived scavenge.
-  IncrementYoungSurvivorsCounter(static_cast<int>(
-      (PromotedSpaceSizeOfObjects() - survived_watermark) + new_space_.Size()));
+  intptr_t promoted = PromotedSpaceSizeOfObjects() - survived_watermark;
+  intptr_t survived = promoted + new_space_.Size();
+  IncrementYoungSurvivorsCounter(static_cast<int>(survived));
+  promotion_rate_ =
+      survived > 0 ? static_cast<double>(promoted) * 100 / survived : 0;
 
   LOG(isolate_, ResourceEvent("scavenge", "end"));
 
@@ -1760,6 +1796,15 @@ struct WeakListVisitor<Context> {
 };
 
 
+void Heap::ShrinkStringTable() {
+  Object* new_table;
+  MaybeObject* maybe_new_table = string_table()->Shrink();
+  // Keep the old table if the allocation fails, it is still valid.
+  if (!maybe_new_table->ToObject(&new_table)) return;
+  roots_[kStringTableRootIndex] = new_table;
+}
+
+
 void Heap::ProcessWeakReferences(WeakObjectRetainer* retainer) {
   // We don't record weak slots during marking or scavenges.
   // Instead we do it once when we complete mark-compact cycle.
@@ -1820,6 +1865,7 @@ struct WeakListVisitor<JSArrayBuffer> {
                               JSArrayBuffer* array_buffer,
                               WeakObjectRetainer* retainer,
                               bool record_slots) {
+    heap->array_buffer_tracker()->ReportLive(array_buffer);
     Object* typed_array_obj =
         VisitWeakList<JSArrayBufferView>(
             heap,
@@ -1834,7 +1880,7 @@ struct WeakListVisitor<JSArrayBuffer> {
   }
 
   static void VisitPhantomObject(Heap* heap, JSArrayBuffer* phantom) {
-    Runtime::FreeArrayBuffer(heap->isolate(), phantom);
+    heap->array_buffer_tracker()->ReportDead(phantom);
   }
 
   static int WeakNextOffset() {
@@ -1845,11 +1891,13 @@ struct WeakListVisitor<JSArrayBuffer> {
 
 void Heap::ProcessArrayBuffers(WeakObjectRetainer* retainer,
                                bool record_slots) {
+  array_buffer_tracker_.PrepareForGC();
   Object* array_buffer_obj =
       VisitWeakList<JSArrayBuffer>(this,
                                    array_buffers_list(),
                                    retainer, record_slots);
   set_array_buffers_list(array_buffer_obj);
+  array_buffer_tracker_.FreeDead();
 }
 
 
@@ -1861,6 +1909,108 @@ void Heap::TearDownArrayBuffers() {
     o = buffer->weak_next();
   }
   array_buffers_list_ = undefined;
+  array_buffer_tracker_.TearDown();
+}
+
+
+size_t ArrayBufferTracker::LengthOf(Isolate* isolate, JSArrayBuffer* buffer) {
+  return NumberToSize(isolate, buffer->byte_length());
+}
+
+
+void ArrayBufferTracker::RegisterNew(JSArrayBuffer* buffer) {
+  ASSERT(!buffer->is_external());
+  size_t length = LengthOf(heap_->isolate(), buffer);
+  retained_bytes_ += length;
+  if (heap_->InNewSpace(buffer)) {
+    retained_bytes_in_new_space_ += length;
+  }
+  heap_->AdjustAmountOfExternalAllocatedMemory(static_cast<intptr_t>(length));
+}
+
+
+void ArrayBufferTracker::Unregister(JSArrayBuffer* buffer) {
+  ASSERT(!buffer->is_external());
+  size_t length = LengthOf(heap_->isolate(), buffer);
+  ASSERT(retained_bytes_ >= length);
+  retained_bytes_ -= length;
+  if (heap_->InNewSpace(buffer)) {
+    retained_bytes_in_new_space_ -= Min(length, retained_bytes_in_new_space_);
+  }
+  heap_->AdjustAmountOfExternalAllocatedMemory(
+      -static_cast<intptr_t>(length));
+}
+
+
+void ArrayBufferTracker::PrepareForGC() {
+  ASSERT(dead_.is_empty());
+  retained_bytes_in_new_space_ = 0;
+}
+
+
+void ArrayBufferTracker::ReportLive(JSArrayBuffer* buffer) {
+  if (buffer->is_external() || !heap_->InNewSpace(buffer)) return;
+  retained_bytes_in_new_space_ += LengthOf(heap_->isolate(), buffer);
+}
+
+
+void ArrayBufferTracker::ReportDead(JSArrayBuffer* buffer) {
+  if (buffer->is_external() || buffer->backing_store() == NULL) return;
+  BackingStore backing_store;
+  backing_store.data = buffer->backing_store();
+  backing_store.length = LengthOf(heap_->isolate(), buffer);
+  ASSERT(retained_bytes_ >= backing_store.length);
+  retained_bytes_ -= backing_store.length;
+  freed_bytes_ += backing_store.length;
+  dead_.Add(backing_store);
+}
+
+
+void ArrayBufferTracker::FreeDead() {
+  if (freed_bytes_ > 0) {
+    heap_->AdjustAmountOfExternalAllocatedMemory(
+        -static_cast<intptr_t>(freed_bytes_));
+    freed_bytes_ = 0;
+  }
+  if (dead_.is_empty()) return;
+  CHECK(V8::ArrayBufferAllocator() != NULL);
+  UnmapperThread* thread = heap_->isolate()->unmapper_thread();
+  if (FLAG_concurrent_array_buffer_freeing && thread != NULL &&
+      V8::ArrayBufferAllocator()->IsThreadSafe()) {
+    {
+      LockGuard<Mutex> lock_guard(&free_queue_mutex_);
+      free_queue_.AddAll(dead_);
+    }
+    dead_.Clear();
+    thread->StartUnmapping();
+    return;
+  }
+  for (int i = 0; i < dead_.length(); i++) {
+    V8::ArrayBufferAllocator()->Free(dead_[i].data, dead_[i].length);
+  }
+  dead_.Clear();
+}
+
+
+void ArrayBufferTracker::FreeQueued() {
+  while (true) {
+    BackingStore backing_store;
+    {
+      LockGuard<Mutex> lock_guard(&free_queue_mutex_);
+      if (free_queue_.is_empty()) return;
+      backing_store = free_queue_.RemoveLast();
+    }
+    V8::ArrayBufferAllocator()->Free(backing_store.data,
+                                     backing_store.length);
+  }
+}
+
+
+void ArrayBufferTracker::TearDown() {
+  // The unmapper thread has been stopped already.
+  FreeQueued();
+  free_queue_.Free();
+  dead_.Free();
 }
 
 
@@ -1968,6 +2118,9 @@ Address Heap::DoScavenge(ObjectVisitor* scavenge_visitor,
     // queue is empty.
     while (new_space_front != new_space_.top()) {
       if (!NewSpacePage::IsAtEnd(new_space_front)) {
+        if (new_space_.has_open_survivor_areas()) {
+          new_space_.CloseSurvivorAreaAt(new_space_front);
+        }
         HeapObject* object = HeapObject::FromAddress(new_space_front);
         new_space_front +=
           NewSpaceScavenger::IterateBody(object->map(), object);
@@ -1979,9 +2132,7 @@ Address Heap::DoScavenge(ObjectVisitor* scavenge_visitor,
 
     // Promote and process all the to-be-promoted objects.
     {
-      StoreBufferRebuildScope scope(this,
-                                    store_buffer(),
-                                    &ScavengeStoreBufferCallback);
+      StoreBufferRebuildScope scope(store_buffer());
       while (!promotion_queue()->is_empty()) {
         HeapObject* target;
         int size;
@@ -2109,6 +2260,10 @@ class ScavengingVisitor : public StaticVisitorBase {
                                    kVisitJSObject,
                                    kVisitJSObjectGeneric>();
 
+    table_.Register(kVisitJSObjectWithUnboxedDoubles,
+                    &ObjectEvacuationStrategy<POINTER_OBJECT>::
+                    Visit);
+
     table_.RegisterSpecializations<ObjectEvacuationStrategy<POINTER_OBJECT>,
                                    kVisitStruct,
                                    kVisitStructGeneric>();
@@ -2229,7 +2384,14 @@ class ScavengingVisitor : public StaticVisitorBase {
       }
     }
     ASSERT(heap->AllowedToBeMigrated(object, NEW_SPACE));
-    MaybeObject* allocation = heap->new_space()->AllocateRaw(allocation_size);
+    NewSpace* new_space = heap->new_space();
+    int age = 1;
+    if (new_space->promotion_age() > 1) {
+      age = Min(new_space->SurvivorAge(object->address()) + 1,
+                NewSpace::kMaxSurvivorAge);
+    }
+    MaybeObject* allocation =
+        new_space->AllocateSurvivor(allocation_size, age);
     heap->promotion_queue()->SetNewLimit(heap->new_space()->top());
     Object* result = allocation->ToObjectUnchecked();
     HeapObject* target = HeapObject::cast(result);
@@ -2400,12 +2562,16 @@ static void InitializeScavengingVisitorsTables() {
 }
 
 
+static bool IsLoggingOrProfilingObjectMoves(Isolate* isolate) {
+  return isolate->logger()->is_logging() ||
+      isolate->cpu_profiler()->is_profiling() ||
+      (isolate->heap_profiler() != NULL &&
+       isolate->heap_profiler()->is_profiling());
+}
+
+
 void Heap::SelectScavengingVisitorsTable() {
-  bool logging_and_profiling =
-      isolate()->logger()->is_logging() ||
-      isolate()->cpu_profiler()->is_profiling() ||
-      (isolate()->heap_profiler() != NULL &&
-       isolate()->heap_profiler()->is_profiling());
+  bool logging_and_profiling = IsLoggingOrProfilingObjectMoves(isolate());
 
   if (!incremental_marking()->IsMarking()) {
     if (!logging_and_profiling) {
@@ -2451,6 +2617,666 @@ void Heap::ScavengeObjectSlow(HeapObject** p, HeapObject* object) {
 }
 
 
+// A linear allocation buffer that a parallel scavenge task carves out of a
+// space, so that most copies do not need to synchronize with other tasks.
+class ScavengeAllocationBuffer {
+ public:
+  ScavengeAllocationBuffer() : top_(NULL), limit_(NULL) { }
+
+  Address top() { return top_; }
+  Address limit() { return limit_; }
+
+  void Reset(Address top, Address limit) {
+    top_ = top;
+    limit_ = limit;
+  }
+
+  // Returns NULL if the buffer is exhausted.
+  Address Allocate(int size_in_bytes) {
+    if (limit_ - top_ < size_in_bytes) return NULL;
+    Address result = top_;
+    top_ += size_in_bytes;
+    return result;
+  }
+
+  // Gives back the memory of the last allocation.
+  void Undo(Address start) {
+    ASSERT(start <= top_ && start >= top_ - Page::kMaxNonCodeHeapObjectSize);
+    top_ = start;
+  }
+
+  bool Contains(Address address) {
+    return top_ != NULL && address < limit_ && address >= limit_ - kSize;
+  }
+
+  static const int kSize = 8 * KB;
+  // Larger objects are allocated directly in the space.
+  static const int kMaxObjectSize = kSize / 4;
+
+ private:
+  Address top_;
+  Address limit_;
+};
+
+
+class ParallelScavenger;
+
+
+// One task of a parallel scavenge.  Objects are claimed by installing the
+// forwarding address with a compare-and-swap on the map word of the object
+// in from space.  Copied objects are kept on a local work list until their
+// pointers have been scavenged.  Slots in the old generation that still point
+// to new space afterwards are recorded locally and entered into the remembered
+// sets by the main thread when all tasks are done.
+class ParallelScavengeTask {
+ public:
+  ParallelScavengeTask(ParallelScavenger* scavenger, Heap* heap)
+      : scavenger_(scavenger),
+        heap_(heap),
+        visitor_(this),
+        work_(kInitialWorkListCapacity),
+        recorded_slots_(kInitialWorkListCapacity),
+        promoted_objects_size_(0),
+        evacuated_objects_(0),
+        new_space_is_filling_up_(false) { }
+
+  void Run();
+
+  // Scavenges a slot that is not in the old generation (roots, cells, fields
+  // of objects copied within new space).
+  void ScavengePointer(Object** p) {
+    Object* object = *p;
+    if (!heap_->InFromSpace(object)) return;
+    *p = EvacuateObject(HeapObject::cast(object));
+  }
+
+  // Gives the unused parts of the allocation buffers back to their spaces.
+  void Finish();
+
+  ObjectVisitor* visitor() { return &visitor_; }
+
+  // Scavenges a slot from the remembered set of an old generation chunk.
+  void VisitSlot(Address slot_address);
+
+  List<Address>* recorded_slots() { return &recorded_slots_; }
+  intptr_t promoted_objects_size() { return promoted_objects_size_; }
+  int evacuated_objects() { return evacuated_objects_; }
+
+ private:
+  class ScavengePointersVisitor : public ObjectVisitor {
+   public:
+    explicit ScavengePointersVisitor(ParallelScavengeTask* task)
+        : task_(task) { }
+
+    void VisitPointer(Object** p) { task_->ScavengePointer(p); }
+
+    void VisitPointers(Object** start, Object** end) {
+      for (Object** p = start; p < end; p++) task_->ScavengePointer(p);
+    }
+
+   private:
+    ParallelScavengeTask* task_;
+  };
+
+  static const int kInitialWorkListCapacity = 256;
+
+  HeapObject* EvacuateObject(HeapObject* object);
+  bool ShouldBePromoted(int age);
+  Address AllocateRaw(AllocationSpace space, int size_in_bytes);
+  Address AllocateSurvivor(int size_in_bytes, int age);
+  void UndoAllocation(AllocationSpace space, Address start, int size_in_bytes);
+  void CloseAllocationBuffer(AllocationSpace space);
+  void CloseSurvivorBuffer(int age);
+  ScavengeAllocationBuffer* allocation_buffer(AllocationSpace space) {
+    switch (space) {
+      case NEW_SPACE: return &new_space_buffer_;
+      case OLD_POINTER_SPACE: return &old_pointer_space_buffer_;
+      case OLD_DATA_SPACE: return &old_data_space_buffer_;
+      default: UNREACHABLE();
+    }
+    return NULL;
+  }
+
+  void IterateNewSpaceObject(HeapObject* object);
+  void IteratePromotedObject(HeapObject* object);
+  void ProcessWorkList();
+
+  ParallelScavenger* scavenger_;
+  Heap* heap_;
+  ScavengePointersVisitor visitor_;
+  List<HeapObject*> work_;
+  List<Address> recorded_slots_;
+  intptr_t promoted_objects_size_;
+  int evacuated_objects_;
+  // Set once to space is 25% full, after which all objects are promoted.
+  bool new_space_is_filling_up_;
+  ScavengeAllocationBuffer new_space_buffer_;
+  ScavengeAllocationBuffer old_pointer_space_buffer_;
+  ScavengeAllocationBuffer old_data_space_buffer_;
+  // Buffers for survivors older than one scavenge, indexed by age.
+  ScavengeAllocationBuffer survivor_buffers_[NewSpace::kMaxSurvivorAge + 1];
+};
+
+
+// Shared state of a parallel scavenge: the tasks, the chunks whose remembered
+// sets are still to be processed and a pool of work that idle tasks can take
+// from busy tasks.
+class ParallelScavenger {
+ public:
+  ParallelScavenger(Heap* heap,
+                    int number_of_tasks,
+                    List<MemoryChunk*>* chunks)
+      : number_of_tasks_(number_of_tasks),
+        chunks_(chunks),
+        idle_tasks_(0),
+        done_(false) {
+    NoBarrier_Store(&next_chunk_, 0);
+    NoBarrier_Store(&idle_tasks_hint_, 0);
+    tasks_ = NewArray<ParallelScavengeTask*>(number_of_tasks);
+    for (int i = 0; i < number_of_tasks; i++) {
+      tasks_[i] = new ParallelScavengeTask(this, heap);
+    }
+  }
+
+  ~ParallelScavenger() {
+    for (int i = 0; i < number_of_tasks_; i++) delete tasks_[i];
+    DeleteArray(tasks_);
+  }
+
+  int number_of_tasks() { return number_of_tasks_; }
+  ParallelScavengeTask* task(int task_id) { return tasks_[task_id]; }
+
+  Mutex* allocation_mutex() { return &allocation_mutex_; }
+
+  // Hands out the next chunk with a remembered set.  Returns NULL once all
+  // chunks have been claimed.
+  MemoryChunk* ClaimChunk() {
+    int index =
+        static_cast<int>(Barrier_AtomicIncrement(&next_chunk_, 1) - 1);
+    if (index >= chunks_->length()) return NULL;
+    return chunks_->at(index);
+  }
+
+  // Moves part of a task's work list to the shared pool if other tasks are
+  // waiting for work.
+  void ShareWork(List<HeapObject*>* work) {
+    if (work->length() < kMinWorkToShare ||
+        NoBarrier_Load(&idle_tasks_hint_) == 0) {
+      return;
+    }
+    LockGuard<Mutex> lock_guard(&work_mutex_);
+    int share = work->length() / 2;
+    for (int i = 0; i < share; i++) shared_work_.Add(work->RemoveLast());
+    work_available_.NotifyAll();
+  }
+
+  // Blocks until work is available and moves it to the given work list.
+  // Returns false when all tasks ran out of work, i.e. the scavenge is done.
+  bool WaitForWork(List<HeapObject*>* work) {
+    LockGuard<Mutex> lock_guard(&work_mutex_);
+    idle_tasks_++;
+    while (true) {
+      if (!shared_work_.is_empty()) {
+        int take = Min(shared_work_.length(), kMaxWorkToTake);
+        for (int i = 0; i < take; i++) work->Add(shared_work_.RemoveLast());
+        idle_tasks_--;
+        NoBarrier_Store(&idle_tasks_hint_, idle_tasks_);
+        return true;
+      }
+      if (done_) return false;
+      if (idle_tasks_ == number_of_tasks_) {
+        done_ = true;
+        work_available_.NotifyAll();
+        return false;
+      }
+      NoBarrier_Store(&idle_tasks_hint_, idle_tasks_);
+      work_available_.Wait(&work_mutex_);
+    }
+  }
+
+ private:
+  static const int kMinWorkToShare = 64;
+  static const int kMaxWorkToTake = 256;
+
+  int number_of_tasks_;
+  ParallelScavengeTask** tasks_;
+
+  List<MemoryChunk*>* chunks_;
+  volatile AtomicWord next_chunk_;
+
+  Mutex allocation_mutex_;
+
+  Mutex work_mutex_;
+  ConditionVariable work_available_;
+  List<HeapObject*> shared_work_;
+  int idle_tasks_;
+  // Copy of idle_tasks_ that busy tasks read without taking the lock.
+  volatile AtomicWord idle_tasks_hint_;
+  bool done_;
+};
+
+
+void ParallelScavengeTask::Run() {
+  do {
+    MemoryChunk* chunk;
+    while ((chunk = scavenger_->ClaimChunk()) != NULL) {
+      StoreBuffer::IterateAndClearSlots(chunk, this);
+      ProcessWorkList();
+    }
+    ProcessWorkList();
+  } while (scavenger_->WaitForWork(&work_));
+}
+
+
+void ParallelScavengeTask::VisitSlot(Address slot_address) {
+  Object** slot = reinterpret_cast<Object**>(slot_address);
+  Object* object = *slot;
+  if (!heap_->InFromSpace(object)) return;
+  HeapObject* target = EvacuateObject(HeapObject::cast(object));
+  // The slot may be a stale entry in memory that another task has just
+  // reused for a promoted object, so only update it if it was not
+  // overwritten in the meantime.
+  Release_CompareAndSwap(reinterpret_cast<AtomicWord*>(slot),
+                         reinterpret_cast<AtomicWord>(object),
+                         reinterpret_cast<AtomicWord>(target));
+  if (heap_->InNewSpace(*slot)) {
+    recorded_slots_.Add(slot_address);
+  }
+}
+
+
+void ParallelScavengeTask::ProcessWorkList() {
+  while (!work_.is_empty()) {
+    HeapObject* object = work_.RemoveLast();
+    if (heap_->InNewSpace(object)) {
+      IterateNewSpaceObject(object);
+    } else {
+      IteratePromotedObject(object);
+    }
+    scavenger_->ShareWork(&work_);
+  }
+}
+
+
+// Mirrors StaticNewSpaceVisitor, which does not visit weak fields.
+void ParallelScavengeTask::IterateNewSpaceObject(HeapObject* object) {
+  Map* map = object->map();
+  InstanceType type = map->instance_type();
+  switch (type) {
+    case JS_FUNCTION_TYPE:
+      visitor_.VisitPointers(
+          HeapObject::RawField(object, JSFunction::kPropertiesOffset),
+          HeapObject::RawField(object, JSFunction::kCodeEntryOffset));
+      visitor_.VisitPointers(
+          HeapObject::RawField(object,
+                               JSFunction::kCodeEntryOffset + kPointerSize),
+          HeapObject::RawField(object, JSFunction::kNonWeakFieldsEndOffset));
+      break;
+    case JS_ARRAY_BUFFER_TYPE:
+      visitor_.VisitPointers(
+          HeapObject::RawField(object,
+                               JSArrayBuffer::BodyDescriptor::kStartOffset),
+          HeapObject::RawField(object, JSArrayBuffer::kWeakNextOffset));
+      visitor_.VisitPointers(
+          HeapObject::RawField(
+              object, JSArrayBuffer::kWeakNextOffset + 2 * kPointerSize),
+          HeapObject::RawField(object, JSArrayBuffer::kSizeWithInternalFields));
+      break;
+    case JS_TYPED_ARRAY_TYPE:
+      visitor_.VisitPointers(
+          HeapObject::RawField(object,
+                               JSTypedArray::BodyDescriptor::kStartOffset),
+          HeapObject::RawField(object, JSTypedArray::kWeakNextOffset));
+      visitor_.VisitPointers(
+          HeapObject::RawField(object,
+                               JSTypedArray::kWeakNextOffset + kPointerSize),
+          HeapObject::RawField(object, JSTypedArray::kSizeWithInternalFields));
+      break;
+    case JS_DATA_VIEW_TYPE:
+      visitor_.VisitPointers(
+          HeapObject::RawField(object,
+                               JSDataView::BodyDescriptor::kStartOffset),
+          HeapObject::RawField(object, JSDataView::kWeakNextOffset));
+      visitor_.VisitPointers(
+          HeapObject::RawField(object,
+                               JSDataView::kWeakNextOffset + kPointerSize),
+          HeapObject::RawField(object, JSDataView::kSizeWithInternalFields));
+      break;
+    default:
+      object->IterateBody(type, object->SizeFromMap(map), &visitor_);
+  }
+}
+
+
+// Mirrors Heap::IterateAndMarkPointersToFromSpace.
+void ParallelScavengeTask::IteratePromotedObject(HeapObject* object) {
+  int size = object->IsJSFunction() ? JSFunction::kNonWeakFieldsEndOffset
+                                    : object->Size();
+  Map* map = object->map();
+  bool has_unboxed_doubles = map->HasUnboxedDoubleFields();
+  Address slot_address = object->address() + kPointerSize;
+  Address end = object->address() + size;
+  while (slot_address < end) {
+    if (has_unboxed_doubles &&
+        map->IsUnboxedDoubleFieldOffset(
+            static_cast<int>(slot_address - object->address()))) {
+      slot_address += kPointerSize;
+      continue;
+    }
+    Object** slot = reinterpret_cast<Object**>(slot_address);
+    Object* value = *slot;
+    if (heap_->InFromSpace(value)) {
+      *slot = EvacuateObject(HeapObject::cast(value));
+      if (heap_->InNewSpace(*slot)) {
+        recorded_slots_.Add(slot_address);
+      }
+    }
+    slot_address += kPointerSize;
+  }
+}
+
+
+bool ParallelScavengeTask::ShouldBePromoted(int age) {
+  // Same policy as Heap::ShouldBePromoted.  Whether to space is 25% full is
+  // only checked when a new allocation buffer is taken from new space.
+  return new_space_is_filling_up_ ||
+      age >= heap_->new_space()->promotion_age();
+}
+
+
+HeapObject* ParallelScavengeTask::EvacuateObject(HeapObject* object) {
+  MapWord first_word = object->acquire_map_word();
+  if (first_word.IsForwardingAddress()) {
+    return first_word.ToForwardingAddress();
+  }
+
+  Map* map = first_word.ToMap();
+  int object_size = object->SizeFromMap(map);
+  InstanceType type = map->instance_type();
+  SLOW_ASSERT(object_size <= Page::kMaxNonCodeHeapObjectSize);
+
+  int allocation_size = object_size;
+  bool needs_double_alignment = kDoubleAlignment != kObjectAlignment &&
+      type == FIXED_DOUBLE_ARRAY_TYPE;
+  if (needs_double_alignment) allocation_size += kPointerSize;
+
+  AllocationSpace space = NEW_SPACE;
+  Address allocation = NULL;
+  int age = heap_->new_space()->SurvivorAge(object->address());
+  if (ShouldBePromoted(age)) {
+    space = heap_->TargetSpaceId(type);
+    allocation = AllocateRaw(space, allocation_size);
+  }
+  if (allocation == NULL) {
+    space = NEW_SPACE;
+    age = Min(age + 1, NewSpace::kMaxSurvivorAge);
+    if (age > 1) allocation = AllocateSurvivor(allocation_size, age);
+  }
+  if (allocation == NULL) {
+    allocation = AllocateRaw(space, allocation_size);
+  }
+  if (allocation == NULL) {
+    V8::FatalProcessOutOfMemory("ParallelScavengeTask::EvacuateObject");
+  }
+
+  HeapObject* target = HeapObject::FromAddress(allocation);
+  if (needs_double_alignment) {
+    target = EnsureDoubleAligned(heap_, target, allocation_size);
+  }
+
+  // The copy may have picked up the forwarding address of a task that is
+  // racing for the same object, so the map is restored explicitly.
+  heap_->CopyBlock(target->address(), object->address(), object_size);
+  target->set_map_word(MapWord::FromMap(map));
+
+  if (!object->release_compare_and_swap_map_word(
+          first_word, MapWord::FromForwardingAddress(target))) {
+    // Another task copied the object first.
+    UndoAllocation(space, allocation, allocation_size);
+    return object->acquire_map_word().ToForwardingAddress();
+  }
+  evacuated_objects_++;
+
+  if (space != NEW_SPACE) {
+    promoted_objects_size_ += object_size;
+    if (space == OLD_DATA_SPACE) return target;
+  }
+  work_.Add(target);
+  return target;
+}
+
+
+Address ParallelScavengeTask::AllocateRaw(AllocationSpace space,
+                                          int size_in_bytes) {
+  ScavengeAllocationBuffer* buffer = allocation_buffer(space);
+  Address result = buffer->Allocate(size_in_bytes);
+  if (result != NULL) return result;
+
+  LockGuard<Mutex> lock_guard(scavenger_->allocation_mutex());
+  MaybeObject* maybe_result;
+  if (size_in_bytes > ScavengeAllocationBuffer::kMaxObjectSize) {
+    maybe_result = space == NEW_SPACE
+        ? heap_->new_space()->AllocateRaw(size_in_bytes)
+        : heap_->paged_space(space)->AllocateRaw(size_in_bytes);
+    Object* object;
+    if (!maybe_result->ToObject(&object)) return NULL;
+    return HeapObject::cast(object)->address();
+  }
+
+  CloseAllocationBuffer(space);
+  if (space == NEW_SPACE) {
+    NewSpace* new_space = heap_->new_space();
+    new_space_is_filling_up_ =
+        new_space->Size() >= (new_space->EffectiveCapacity() >> 2);
+    maybe_result = new_space->AllocateRaw(ScavengeAllocationBuffer::kSize);
+    if (maybe_result->IsFailure()) {
+      // Use up the last bits of to space without wasting any memory.
+      maybe_result = new_space->AllocateRaw(size_in_bytes);
+      Object* object;
+      if (!maybe_result->ToObject(&object)) return NULL;
+      return HeapObject::cast(object)->address();
+    }
+  } else {
+    maybe_result = heap_->paged_space(space)->AllocateRaw(
+        ScavengeAllocationBuffer::kSize);
+    if (maybe_result->IsFailure()) {
+      maybe_result = heap_->paged_space(space)->AllocateRaw(size_in_bytes);
+      Object* object;
+      if (!maybe_result->ToObject(&object)) return NULL;
+      return HeapObject::cast(object)->address();
+    }
+  }
+  Address start =
+      HeapObject::cast(maybe_result->ToObjectUnchecked())->address();
+  buffer->Reset(start, start + ScavengeAllocationBuffer::kSize);
+  return buffer->Allocate(size_in_bytes);
+}
+
+
+Address ParallelScavengeTask::AllocateSurvivor(int size_in_bytes, int age) {
+  ScavengeAllocationBuffer* buffer = &survivor_buffers_[age];
+  Address result = buffer->Allocate(size_in_bytes);
+  if (result != NULL) return result;
+
+  // Survivor buffers are recorded in the age table of to space when they
+  // are taken, which keeps the table sorted by address.
+  LockGuard<Mutex> lock_guard(scavenger_->allocation_mutex());
+  NewSpace* new_space = heap_->new_space();
+  Object* object;
+  if (size_in_bytes > ScavengeAllocationBuffer::kMaxObjectSize) {
+    if (!new_space->AllocateRaw(size_in_bytes)->ToObject(&object)) {
+      return NULL;
+    }
+    Address start = HeapObject::cast(object)->address();
+    new_space->RecordSurvivorArea(start, start + size_in_bytes, age);
+    return start;
+  }
+
+  CloseSurvivorBuffer(age);
+  new_space_is_filling_up_ =
+      new_space->Size() >= (new_space->EffectiveCapacity() >> 2);
+  MaybeObject* maybe_result =
+      new_space->AllocateRaw(ScavengeAllocationBuffer::kSize);
+  if (!maybe_result->ToObject(&object)) return NULL;
+  Address start = HeapObject::cast(object)->address();
+  Address limit = start + ScavengeAllocationBuffer::kSize;
+  new_space->RecordSurvivorArea(start, limit, age);
+  buffer->Reset(start, limit);
+  return buffer->Allocate(size_in_bytes);
+}
+
+
+void ParallelScavengeTask::UndoAllocation(AllocationSpace space,
+                                          Address start,
+                                          int size_in_bytes) {
+  ScavengeAllocationBuffer* buffer = allocation_buffer(space);
+  if (space == NEW_SPACE && !buffer->Contains(start)) {
+    for (int age = 2; age <= NewSpace::kMaxSurvivorAge; age++) {
+      if (survivor_buffers_[age].Contains(start)) {
+        buffer = &survivor_buffers_[age];
+        break;
+      }
+    }
+  }
+  if (buffer->Contains(start)) {
+    buffer->Undo(start);
+  } else {
+    // The object was allocated directly in the space.
+    heap_->CreateFillerObjectAt(start, size_in_bytes);
+  }
+}
+
+
+void ParallelScavengeTask::CloseAllocationBuffer(AllocationSpace space) {
+  ScavengeAllocationBuffer* buffer = allocation_buffer(space);
+  int size = static_cast<int>(buffer->limit() - buffer->top());
+  if (size > 0) {
+    if (space == NEW_SPACE) {
+      heap_->CreateFillerObjectAt(buffer->top(), size);
+    } else {
+      heap_->paged_space(space)->Free(buffer->top(), size);
+    }
+  }
+  buffer->Reset(NULL, NULL);
+}
+
+
+void ParallelScavengeTask::CloseSurvivorBuffer(int age) {
+  ScavengeAllocationBuffer* buffer = &survivor_buffers_[age];
+  int size = static_cast<int>(buffer->limit() - buffer->top());
+  if (size > 0) heap_->CreateFillerObjectAt(buffer->top(), size);
+  buffer->Reset(NULL, NULL);
+}
+
+
+void ParallelScavengeTask::Finish() {
+  ASSERT(work_.is_empty());
+  CloseAllocationBuffer(NEW_SPACE);
+  CloseAllocationBuffer(OLD_POINTER_SPACE);
+  CloseAllocationBuffer(OLD_DATA_SPACE);
+  for (int age = 2; age <= NewSpace::kMaxSurvivorAge; age++) {
+    CloseSurvivorBuffer(age);
+  }
+}
+
+
+bool Heap::CanScavengeInParallel() {
+  // The parallel tasks neither transfer incremental marking marks nor
+  // report object moves, and they do not short-circuit cons strings.
+  return isolate()->scavenger_threads() != NULL &&
+      !incremental_marking()->IsMarking() &&
+      !IsLoggingOrProfilingObjectMoves(isolate()) &&
+      !FLAG_trace_track_allocation_sites;
+}
+
+
+Address Heap::ScavengeInParallel() {
+  // The tasks claim the chunks that have a remembered set one at a time.  The
+  // remembered sets are rebuilt from the slots recorded by the tasks.
+  store_buffer()->Compact();
+  List<MemoryChunk*> chunks;
+  PointerChunkIterator it(this);
+  MemoryChunk* chunk;
+  while ((chunk = it.next()) != NULL) {
+    if (chunk->old_to_new_slots() != NULL) chunks.Add(chunk);
+  }
+
+  int number_of_tasks = FLAG_scavenger_threads + 1;
+  ParallelScavenger scavenger(this, number_of_tasks, &chunks);
+  parallel_scavenger_ = &scavenger;
+
+  // The roots are few compared to the old-to-new pointers, so the main
+  // thread copies their immediate targets before starting the helpers.
+  ObjectVisitor* visitor = scavenger.task(0)->visitor();
+  IterateRoots(visitor, VISIT_ALL_IN_SCAVENGE);
+
+  HeapObjectIterator cell_iterator(cell_space_);
+  for (HeapObject* heap_object = cell_iterator.Next();
+       heap_object != NULL;
+       heap_object = cell_iterator.Next()) {
+    if (heap_object->IsCell()) {
+      Cell* cell = Cell::cast(heap_object);
+      visitor->VisitPointer(reinterpret_cast<Object**>(cell->ValueAddress()));
+    }
+  }
+
+  HeapObjectIterator js_global_property_cell_iterator(property_cell_space_);
+  for (HeapObject* heap_object = js_global_property_cell_iterator.Next();
+       heap_object != NULL;
+       heap_object = js_global_property_cell_iterator.Next()) {
+    if (heap_object->IsPropertyCell()) {
+      PropertyCell* cell = PropertyCell::cast(heap_object);
+      visitor->VisitPointer(reinterpret_cast<Object**>(cell->ValueAddress()));
+      visitor->VisitPointer(reinterpret_cast<Object**>(cell->TypeAddress()));
+    }
+  }
+
+  MarkCompactCollector* collector = mark_compact_collector();
+  if (collector->is_code_flushing_enabled()) {
+    collector->code_flusher()->IteratePointersToFromSpace(visitor);
+  }
+  visitor->VisitPointer(collector->encountered_weak_collections_address());
+
+  visitor->VisitPointer(BitCast<Object**>(&native_contexts_list_));
+
+  ScavengerThread** threads = isolate()->scavenger_threads();
+  for (int i = 0; i < FLAG_scavenger_threads; i++) {
+    threads[i]->StartScavenging();
+  }
+  RunParallelScavengeTask(0);
+  for (int i = 0; i < FLAG_scavenger_threads; i++) {
+    threads[i]->WaitForScavengerThread();
+  }
+  parallel_scavenger_ = NULL;
+
+  {
+    StoreBufferRebuildScope scope(store_buffer());
+    for (int i = 0; i < number_of_tasks; i++) {
+      ParallelScavengeTask* task = scavenger.task(i);
+      task->Finish();
+      List<Address>* slots = task->recorded_slots();
+      for (int j = 0; j < slots->length(); j++) {
+        store_buffer_.EnterDirectlyIntoStoreBuffer(slots->at(j));
+      }
+      tracer()->increment_promoted_objects_size(task->promoted_objects_size());
+      if (i > 0) {
+        objects_evacuated_by_scavenger_threads_ += task->evacuated_objects();
+      }
+    }
+  }
+
+  // Everything copied so far has been scanned by the tasks.
+  promotion_queue_.SetNewLimit(new_space_.top());
+  return new_space_.top();
+}
+
+
+void Heap::RunParallelScavengeTask(int task_id) {
+  ASSERT(parallel_scavenger_ != NULL);
+  parallel_scavenger_->task(task_id)->Run();
+}
+
+
 MaybeObject* Heap::AllocatePartialMap(InstanceType instance_type,
                                       int instance_size) {
   Object* result;
@@ -2471,6 +3297,7 @@ MaybeObject* Heap::AllocatePartialMap(InstanceType instance_type,
   int bit_field3 = Map::EnumLengthBits::encode(Map::kInvalidEnumCache) |
                    Map::OwnsDescriptors::encode(true);
   reinterpret_cast<Map*>(result)->set_bit_field3(bit_field3);
+  reinterpret_cast<Map*>(result)->set_layout_descriptor(0);
   return result;
 }
 
@@ -2503,6 +3330,7 @@ MaybeObject* Heap::AllocateMap(InstanceType instance_type,
   int bit_field3 = Map::EnumLengthBits::encode(Map::kInvalidEnumCache) |
                    Map::OwnsDescriptors::encode(true);
   map->set_bit_field3(bit_field3);
+  map->set_layout_descriptor(0);
   map->set_elements_kind(elements_kind);
 
   return map;
@@ -4140,6 +4968,14 @@ void Heap::CreateFillerObjectAt(Address addr, int size) {
 }
 
 
+void Heap::ClearRecordedSlotRange(Address start, Address end) {
+  if (start == end || InNewSpace(start)) return;
+  // The range may still have entries in the mutator's buffer.
+  store_buffer()->Compact();
+  store_buffer()->RemoveSlots(start, end);
+}
+
+
 MaybeObject* Heap::AllocateExternalArray(int length,
                                          ExternalArrayType array_type,
                                          void* external_pointer,
@@ -4346,7 +5182,9 @@ MaybeObject* Heap::AllocateWithAllocationSite(Map* map, AllocationSpace space,
   MaybeObject* maybe_result = AllocateRaw(size, space, retry_space);
   if (!maybe_result->ToObject(&result)) return maybe_result;
   // No need for write barrier since object is white and map is in old space.
+  // Objects allocated black are not scanned, so their map is marked here.
   HeapObject::cast(result)->set_map_no_write_barrier(map);
+  if (space != NEW_SPACE) MarkMapOfBlackAllocatedObject(map);
   AllocationMemento* alloc_memento = reinterpret_cast<AllocationMemento*>(
       reinterpret_cast<Address>(result) + map->instance_size());
   alloc_memento->set_map_no_write_barrier(allocation_memento_map());
@@ -4368,7 +5206,9 @@ MaybeObject* Heap::Allocate(Map* map, AllocationSpace space) {
   MaybeObject* maybe_result = AllocateRaw(size, space, retry_space);
   if (!maybe_result->ToObject(&result)) return maybe_result;
   // No need for write barrier since object is white and map is in old space.
+  // Objects allocated black are not scanned, so their map is marked here.
   HeapObject::cast(result)->set_map_no_write_barrier(map);
+  if (space != NEW_SPACE) MarkMapOfBlackAllocatedObject(map);
   return result;
 }
 
@@ -4802,9 +5642,19 @@ MaybeObject* Heap::CopyJSObject(JSObject* source, AllocationSite* site) {
               source->address(),
               object_size);
     // Update write barrier for all fields that lie beyond the header.
-    RecordWrites(clone_address,
-                 JSObject::kHeaderSize,
-                 (object_size - JSObject::kHeaderSize) / kPointerSize);
+    if (map->HasUnboxedDoubleFields()) {
+      // Raw double slots must not end up in the remembered set.
+      for (int offset = JSObject::kHeaderSize;
+           offset < object_size;
+           offset += kPointerSize) {
+        if (map->IsUnboxedDoubleFieldOffset(offset)) continue;
+        RecordWrite(clone_address, offset);
+      }
+    } else {
+      RecordWrites(clone_address,
+                   JSObject::kHeaderSize,
+                   (object_size - JSObject::kHeaderSize) / kPointerSize);
+    }
   } else {
     wb_mode = SKIP_WRITE_BARRIER;
 
@@ -5811,6 +6661,137 @@ bool Heap::IdleNotification(int hint) {
 }
 
 
+void Heap::MemoryPressureNotification(v8::MemoryPressureLevel level) {
+  if (level == v8::kMemoryPressureNone) return;
+
+  if (level == v8::kMemoryPressureCritical) {
+    // Monomorphic inline caches keep their stubs alive, clear them as well.
+    flush_monomorphic_ics_ = true;
+    CollectAllAvailableGarbage("memory pressure: critical",
+                               kFlushRegExpCodeMask);
+    return;
+  }
+
+  isolate_->compilation_cache()->Clear();
+
+  // Shrinking new space back to its initial size requires it to be mostly
+  // empty, so scavenge first.
+  CollectGarbage(NEW_SPACE, "memory pressure: moderate");
+  new_space_.Shrink();
+  UncommitFromSpace();
+  isolate_->memory_allocator()->ReleasePooledChunks();
+
+  if (!incremental_marking()->IsStopped()) return;
+  if (incremental_marking()->WorthActivating()) {
+    // Evacuation candidates are selected when marking starts, so the
+    // collector only needs to know about the memory pressure until then.
+    mark_compact_collector()->SetFlags(kReduceMemoryFootprintMask);
+    incremental_marking()->Start();
+    mark_compact_collector()->SetFlags(kNoGCFlags);
+  } else {
+    incremental_marking()->UncommitMarkingDeque();
+  }
+}
+
+
+bool Heap::IdleNotificationDeadline(double deadline_in_seconds) {
+  double idle_time_in_ms =
+      deadline_in_seconds * 1000 - OS::TimeCurrentMillis();
+
+  // After context disposal there is likely a lot of garbage remaining, and
+  // after an idle round the mutator may have created enough new garbage to
+  // justify another one.
+  if (contexts_disposed_ > 0 ||
+      (mark_sweeps_since_idle_round_started_ >= kMaxMarkSweepsInIdleRound &&
+       EnoughGarbageSinceLastIdleRound())) {
+    StartIdleRound();
+  }
+
+  GCIdleTimeHandler::HeapState heap_state;
+  heap_state.size_of_objects = SizeOfObjects();
+  heap_state.new_space_size = new_space_.SizeAsInt();
+  heap_state.new_space_capacity = new_space_.Capacity();
+  heap_state.contexts_disposed = contexts_disposed_;
+  heap_state.remaining_mark_sweeps_in_idle_round =
+      kMaxMarkSweepsInIdleRound - mark_sweeps_since_idle_round_started_;
+  heap_state.incremental_marking_stopped = incremental_marking()->IsStopped();
+  heap_state.incremental_marking_complete =
+      incremental_marking()->IsComplete();
+  heap_state.can_start_incremental_marking =
+      FLAG_incremental_marking && !FLAG_expose_gc && !Serializer::enabled();
+  heap_state.sweeping_in_progress = !IsSweepingComplete();
+
+  GCIdleTimeAction action =
+      gc_idle_time_handler_.Compute(idle_time_in_ms, heap_state);
+  bool result = PerformIdleTimeAction(action);
+
+  if (FLAG_trace_idle_notification) {
+    PrintPID("Idle notification: %.1f ms requested, action %d (%" V8_PTR_PREFIX
+             "d), %.1f ms left\n",
+             idle_time_in_ms,
+             static_cast<int>(action.type()),
+             action.parameter(),
+             deadline_in_seconds * 1000 - OS::TimeCurrentMillis());
+  }
+  return result;
+}
+
+
+bool Heap::PerformIdleTimeAction(GCIdleTimeAction action) {
+  switch (action.type()) {
+    case GCIdleTimeAction::DONE:
+      return true;
+    case GCIdleTimeAction::DO_NOTHING:
+      return false;
+    case GCIdleTimeAction::DO_INCREMENTAL_MARKING: {
+      if (incremental_marking()->IsStopped()) {
+        incremental_marking()->Start();
+      }
+      // The step processes the given amount times the marking speed.
+      intptr_t step_size = Max(
+          action.parameter() / incremental_marking()->marking_speed(),
+          IncrementalMarking::kAllocatedThreshold);
+      incremental_marking()->Step(step_size,
+                                  IncrementalMarking::NO_GC_VIA_STACK_GUARD);
+      return false;
+    }
+    case GCIdleTimeAction::DO_SCAVENGE:
+      CollectGarbage(NEW_SPACE, "idle notification: scavenge");
+      return false;
+    case GCIdleTimeAction::DO_FINALIZE_SWEEPING:
+      EnsureSweepersProgressed(static_cast<int>(action.parameter()));
+      return false;
+    case GCIdleTimeAction::DO_FULL_GC:
+      break;
+  }
+
+  if (!incremental_marking()->IsStopped()) {
+    bool uncommit = false;
+    if (gc_count_at_last_idle_gc_ == gc_count_) {
+      // No GC since the last full GC, the mutator is probably not active.
+      isolate_->compilation_cache()->Clear();
+      uncommit = true;
+    }
+    CollectAllGarbage(kNoGCFlags, "idle notification: finalize incremental");
+    if (uncommit) {
+      new_space_.Shrink();
+      UncommitFromSpace();
+    }
+  } else {
+    CollectAllGarbage(kReduceMemoryFootprintMask,
+                      "idle notification: reduce memory footprint");
+  }
+  contexts_disposed_ = 0;
+  mark_sweeps_since_idle_round_started_++;
+  gc_count_at_last_idle_gc_ = gc_count_;
+  if (mark_sweeps_since_idle_round_started_ >= kMaxMarkSweepsInIdleRound) {
+    FinishIdleRound();
+    return true;
+  }
+  return false;
+}
+
+
 bool Heap::IdleGlobalGC() {
   static const int kIdlesBeforeScavenge = 4;
   static const int kIdlesBeforeMarkSweep = 7;
@@ -6129,13 +7110,22 @@ void Heap::IterateAndMarkPointersToFromSpace(Address start,
     record_slots = Marking::IsBlack(mark_bit);
   }
 
+  // Unboxed double fields hold raw bits that must not be taken for pointers.
+  Map* map = HeapObject::FromAddress(start)->map();
+  bool has_unboxed_doubles = map->HasUnboxedDoubleFields();
+
   while (slot_address < end) {
     Object** slot = reinterpret_cast<Object**>(slot_address);
     Object* object = *slot;
-    // If the store buffer becomes overfull we mark pages as being exempt from
-    // the store buffer.  These pages are scanned to find pointers that point
-    // to the new space.  In that case we may hit newly promoted objects and
-    // fix the pointers before the promotion queue gets to them.  Thus the 'if'.
+    if (has_unboxed_doubles &&
+        map->IsUnboxedDoubleFieldOffset(
+            static_cast<int>(slot_address - start))) {
+      slot_address += kPointerSize;
+      continue;
+    }
+    // The slots of a promoted object may already have been updated through
+    // the remembered set if the object was allocated in memory that still had
+    // stale slots recorded.  Thus the 'if'.
     if (object->IsHeapObject()) {
       if (Heap::InFromSpace(object)) {
         callback(reinterpret_cast<HeapObject**>(slot),
@@ -6178,8 +7168,6 @@ bool EverythingsAPointer(Object** addr) {
 static void CheckStoreBuffer(Heap* heap,
                              Object** current,
                              Object** limit,
-                             Object**** store_buffer_position,
-                             Object*** store_buffer_top,
                              CheckStoreBufferFilter filter,
                              Address special_garbage_start,
                              Address special_garbage_end) {
@@ -6216,12 +7204,7 @@ static void CheckStoreBuffer(Heap* heap,
     // a string can contain values like 1 and 3 which are tagged null
     // pointers.
     if (!heap->InNewSpace(o)) continue;
-    while (**store_buffer_position < current &&
-           *store_buffer_position < store_buffer_top) {
-      (*store_buffer_position)++;
-    }
-    if (**store_buffer_position != current ||
-        *store_buffer_position == store_buffer_top) {
+    if (!heap->store_buffer()->CellIsInStoreBuffer(current_address)) {
       Object** obj_start = current;
       while (!(*obj_start)->IsMap()) obj_start--;
       UNREACHABLE();
@@ -6237,23 +7220,16 @@ void Heap::OldPointerSpaceCheckStoreBuffer() {
   OldSpace* space = old_pointer_space();
   PageIterator pages(space);
 
-  store_buffer()->SortUniq();
-
   while (pages.has_next()) {
     Page* page = pages.next();
     Object** current = reinterpret_cast<Object**>(page->area_start());
 
     Address end = page->area_end();
 
-    Object*** store_buffer_position = store_buffer()->Start();
-    Object*** store_buffer_top = store_buffer()->Top();
-
     Object** limit = reinterpret_cast<Object**>(end);
     CheckStoreBuffer(this,
                      current,
                      limit,
-                     &store_buffer_position,
-                     store_buffer_top,
                      &EverythingsAPointer,
                      space->top(),
                      space->limit());
@@ -6265,23 +7241,16 @@ void Heap::MapSpaceCheckStoreBuffer() {
   MapSpace* space = map_space();
   PageIterator pages(space);
 
-  store_buffer()->SortUniq();
-
   while (pages.has_next()) {
     Page* page = pages.next();
     Object** current = reinterpret_cast<Object**>(page->area_start());
 
     Address end = page->area_end();
 
-    Object*** store_buffer_position = store_buffer()->Start();
-    Object*** store_buffer_top = store_buffer()->Top();
-
     Object** limit = reinterpret_cast<Object**>(end);
     CheckStoreBuffer(this,
                      current,
                      limit,
-                     &store_buffer_position,
-                     store_buffer_top,
                      &IsAMapPointerAddress,
                      space->top(),
                      space->limit());
@@ -6296,16 +7265,12 @@ void Heap::LargeObjectSpaceCheckStoreBuffer() {
     // object space, and only fixed arrays can possibly contain pointers to
     // the young generation.
     if (object->IsFixedArray()) {
-      Object*** store_buffer_position = store_buffer()->Start();
-      Object*** store_buffer_top = store_buffer()->Top();
       Object** current = reinterpret_cast<Object**>(object->address());
       Object** limit =
           reinterpret_cast<Object**>(object->address() + object->Size());
       CheckStoreBuffer(this,
                        current,
                        limit,
-                       &store_buffer_position,
-                       store_buffer_top,
                        &EverythingsAPointer,
                        NULL,
                        NULL);
@@ -6485,6 +7450,7 @@ bool Heap::ConfigureHeap(int max_semispace_size,
                                                        Page::kPageSize),
                                  RoundUp(max_old_generation_size_,
                                          Page::kPageSize));
+  initial_max_old_generation_size_ = max_old_generation_size_;
 
   // We rely on being able to allocate new arrays in paged spaces.
   ASSERT(MaxRegularSpaceAllocationSize() >=
@@ -6596,6 +7562,16 @@ bool Heap::SetUp() {
   if (!isolate_->memory_allocator()->SetUp(MaxReserved(), MaxExecutableSize()))
       return false;
 
+#if V8_TARGET_ARCH_X64
+  // Reserve the heap cage that the new space and all non-executable pages
+  // are allocated from.  The new space has to come first so that it starts
+  // at the aligned base of the cage.
+  if (isolate_->heap_cage() != NULL &&
+      !isolate_->heap_cage()->SetUp(kHeapCageSize)) {
+    return false;
+  }
+#endif
+
   // Set up new space.
   if (!new_space_.SetUp(reserved_semispace_size_, max_semispace_size_)) {
     return false;
@@ -6868,6 +7844,102 @@ void Heap::RemoveGCEpilogueCallback(v8::Isolate::GCEpilogueCallback callback) {
 }
 
 
+void Heap::AddNearHeapLimitCallback(v8::NearHeapLimitCallback callback,
+                                    void* data) {
+  ASSERT(callback != NULL);
+  NearHeapLimitCallbackPair pair(callback, data);
+  ASSERT(!near_heap_limit_callbacks_.Contains(pair));
+  near_heap_limit_callbacks_.Add(pair);
+}
+
+
+void Heap::RemoveNearHeapLimitCallback(v8::NearHeapLimitCallback callback,
+                                       size_t heap_limit) {
+  ASSERT(callback != NULL);
+  for (int i = 0; i < near_heap_limit_callbacks_.length(); ++i) {
+    if (near_heap_limit_callbacks_[i].callback == callback) {
+      near_heap_limit_callbacks_.Remove(i);
+      intptr_t limit = static_cast<intptr_t>(heap_limit);
+      if (limit > 0 && limit > PromotedSpaceSizeOfObjects()) {
+        SetMaxOldGenerationSize(limit);
+      }
+      return;
+    }
+  }
+  // Embedders may remove a callback that has already been removed.
+}
+
+
+bool Heap::InvokeNearHeapLimitCallback() {
+  // The callback may itself run into the limit, e.g. while taking a heap
+  // snapshot.
+  if (near_heap_limit_callbacks_.is_empty() ||
+      invoking_near_heap_limit_callback_) {
+    return false;
+  }
+  NearHeapLimitCallbackPair pair = near_heap_limit_callbacks_.last();
+  size_t heap_limit;
+  {
+    VMState<EXTERNAL> state(isolate_);
+    HandleScope handle_scope(isolate_);
+    invoking_near_heap_limit_callback_ = true;
+    heap_limit = pair.callback(
+        pair.data,
+        static_cast<size_t>(max_old_generation_size_),
+        static_cast<size_t>(initial_max_old_generation_size_));
+    invoking_near_heap_limit_callback_ = false;
+  }
+  if (static_cast<intptr_t>(heap_limit) <= max_old_generation_size_) {
+    return false;
+  }
+  SetMaxOldGenerationSize(static_cast<intptr_t>(heap_limit));
+  return true;
+}
+
+
+void Heap::UpdateIneffectiveMarkCompacts(intptr_t old_gen_size_before_gc,
+                                         double mark_compact_start_time) {
+  // The share of the time since the end of the previous mark-compact that
+  // the mutator got.
+  double end_time = OS::TimeCurrentMillis();
+  double mutator_time = 0.0;
+  if (last_mark_compact_end_time_ > 0) {
+    mutator_time =
+        Max(mark_compact_start_time - last_mark_compact_end_time_, 0.0);
+  }
+  double total_time = mutator_time + (end_time - mark_compact_start_time);
+  bool low_mutator_utilization = last_mark_compact_end_time_ > 0 &&
+      mutator_time * 100 < total_time * kLowMutatorUtilizationPercentage;
+  last_mark_compact_end_time_ = end_time;
+
+  if (!collecting_for_allocation_failure_) return;
+
+  intptr_t reclaimed =
+      old_gen_size_before_gc - size_of_old_gen_at_last_old_space_gc_;
+  if (IsCloseToOutOfMemory() &&
+      reclaimed / kLowReclaimPercentage < old_gen_size_before_gc / 100 &&
+      low_mutator_utilization) {
+    consecutive_ineffective_mark_compacts_++;
+  } else {
+    consecutive_ineffective_mark_compacts_ = 0;
+  }
+}
+
+
+void Heap::SetMaxOldGenerationSize(intptr_t max_old_generation_size) {
+  max_old_generation_size_ = RoundUp(max_old_generation_size, Page::kPageSize);
+  old_pointer_space_->SetMaxCapacity(max_old_generation_size_);
+  old_data_space_->SetMaxCapacity(max_old_generation_size_);
+  code_space_->SetMaxCapacity(max_old_generation_size_);
+  map_space_->SetMaxCapacity(max_old_generation_size_);
+  cell_space_->SetMaxCapacity(max_old_generation_size_);
+  property_cell_space_->SetMaxCapacity(max_old_generation_size_);
+  lo_space_->SetMaxCapacity(max_old_generation_size_);
+  old_generation_allocation_limit_ =
+      OldGenerationAllocationLimit(size_of_old_gen_at_last_old_space_gc_);
+}
+
+
 MaybeObject* Heap::AddWeakObjectToCodeDependency(Object* obj,
                                                  DependentCode* dep) {
   ASSERT(!InNewSpace(obj));
@@ -7325,6 +8397,9 @@ void PathTracer::MarkRecursively(Object** p, MarkVisitor* mark_visitor) {
     Object** end = reinterpret_cast<Object**>(obj->address() +
         Context::kHeaderSize + Context::FIRST_WEAK_SLOT * kPointerSize);
     mark_visitor->VisitPointers(start, end);
+  } else if (map_p->HasUnboxedDoubleFields()) {
+    reinterpret_cast<JSObject*>(obj)->JSObjectIterateBodyWithUnboxedDoubles(
+        map_p, obj->SizeFromMap(map_p), mark_visitor);
   } else {
     obj->IterateBody(map_p->instance_type(),
                      obj->SizeFromMap(map_p),
@@ -7431,6 +8506,9 @@ GCTracer::GCTracer(Heap* heap,
     : start_time_(0.0),
       start_object_size_(0),
       start_memory_size_(0),
+      start_new_space_size_(0),
+      incremental_marking_in_progress_(false),
+      collector_(SCAVENGER),
       gc_count_(0),
       full_gc_count_(0),
       allocated_since_last_gc_(0),
@@ -7439,12 +8517,20 @@ GCTracer::GCTracer(Heap* heap,
       nodes_died_in_new_space_(0),
       nodes_copied_in_new_space_(0),
       nodes_promoted_(0),
+      deduplicated_strings_size_(0),
       heap_(heap),
       gc_reason_(gc_reason),
       collector_reason_(collector_reason) {
-  if (!FLAG_trace_gc && !FLAG_print_cumulative_gc_stat) return;
+  // The duration and the amount of processed memory are always recorded,
+  // they feed the idle time handler's speed estimates.
   start_time_ = OS::TimeCurrentMillis();
   start_object_size_ = heap_->SizeOfObjects();
+  start_new_space_size_ = heap_->new_space()->SizeAsInt();
+  incremental_marking_in_progress_ =
+      !heap_->incremental_marking()->IsStopped();
+  heap_->heap_controller()->NotifyGCStart(
+      start_time_, start_new_space_size_, heap_->PromotedSpaceSizeOfObjects());
+  if (!FLAG_trace_gc && !FLAG_print_cumulative_gc_stat) return;
   start_memory_size_ = heap_->isolate()->memory_allocator()->Size();
 
   for (int i = 0; i < Scope::kNumberOfScopes; i++) {
@@ -7471,6 +8557,24 @@ GCTracer::GCTracer(Heap* heap,
 
 
 GCTracer::~GCTracer() {
+  double end_time = OS::TimeCurrentMillis();
+  double duration = end_time - start_time_;
+  GCIdleTimeHandler* idle_time_handler = heap_->gc_idle_time_handler();
+  if (collector_ == SCAVENGER) {
+    idle_time_handler->NotifyScavenge(start_new_space_size_, duration);
+  } else if (incremental_marking_in_progress_) {
+    idle_time_handler->NotifyFinalizeMarkCompact(start_object_size_,
+                                                 duration);
+  } else {
+    idle_time_handler->NotifyMarkCompact(start_object_size_, duration);
+  }
+  heap_->heap_controller()->NotifyGCEnd(collector_,
+                                        end_time,
+                                        duration,
+                                        heap_->young_survivors_after_last_gc_,
+                                        heap_->new_space()->SizeAsInt(),
+                                        heap_->PromotedSpaceSizeOfObjects());
+
   // Printf ONE line iff flag is set.
   if (!FLAG_trace_gc && !FLAG_print_cumulative_gc_stat) return;
 
@@ -7587,12 +8691,14 @@ GCTracer::~GCTracer() {
     PrintF("nodes_promoted=%d ", nodes_promoted_);
 
     if (collector_ == SCAVENGER) {
+      PrintF("promotion_rate=%.1f%% ", heap_->promotion_rate());
       PrintF("stepscount=%d ", steps_count_since_last_gc_);
       PrintF("stepstook=%.1f ", steps_took_since_last_gc_);
     } else {
       PrintF("stepscount=%d ", steps_count_);
       PrintF("stepstook=%.1f ", steps_took_);
       PrintF("longeststep=%.1f ", longest_step_);
+      PrintF("deduplicated=%" V8_PTR_PREFIX "d ", deduplicated_strings_size_);
     }
 
     PrintF("\n");
@@ -7775,15 +8881,15 @@ void Heap::FreeQueuedChunks() {
     chunk->SetFlag(MemoryChunk::ABOUT_TO_BE_FREED);
 
     if (chunk->owner()->identity() == LO_SPACE) {
-      // StoreBuffer::Filter relies on MemoryChunk::FromAnyPointerAddress.
-      // If FromAnyPointerAddress encounters a slot that belongs to a large
-      // chunk queued for deletion it will fail to find the chunk because
-      // it try to perform a search in the list of pages owned by of the large
-      // object space and queued chunks were detached from that list.
+      // StoreBuffer::Compact looks up the chunk of every slot in the buffer.
+      // If it encounters a slot that belongs to a large chunk queued for
+      // deletion it will fail to find the chunk because it performs a search
+      // in the pages owned by the large object space and queued chunks were
+      // detached from it.
       // To work around this we split large chunk into normal kPageSize aligned
       // pieces and initialize size, owner and flags field of every piece.
-      // If FromAnyPointerAddress encounters a slot that belongs to one of
-      // these smaller pieces it will treat it as a slot on a normal Page.
+      // If Compact encounters a slot that belongs to one of these smaller
+      // pieces it will treat it as a slot on a normal Page and drop it.
       Address chunk_end = chunk->address() + chunk->size();
       MemoryChunk* inner = MemoryChunk::FromAddress(
           chunk->address() + Page::kPageSize);
@@ -7804,8 +8910,8 @@ void Heap::FreeQueuedChunks() {
       }
     }
   }
+  // The remembered sets of the chunks are freed along with them.
   isolate_->heap()->store_buffer()->Compact();
-  isolate_->heap()->store_buffer()->Filter(MemoryChunk::ABOUT_TO_BE_FREED);
   for (chunk = chunks_queued_for_free_; chunk != NULL; chunk = next) {
     next = chunk->next_chunk();
     isolate_->memory_allocator()->Free(chunk);
@@ -32,7 +32,9 @@
 
 #include "allocation.h"
 #include "assert-scope.h"
+#include "gc-idle-time-handler.h"
 #include "globals.h"
+#include "heap-controller.h"
 #include "incremental-marking.h"
 #include "list.h"
 #include "mark-compact.h"
@@ -302,33 +304,13 @@ namespace internal {
 class GCTracer;
 class HeapStats;
 class Isolate;
+class ParallelScavenger;
 class WeakObjectRetainer;
 
 
 typedef String* (*ExternalStringTableUpdaterCallback)(Heap* heap,
                                                       Object** pointer);
 
-class StoreBufferRebuilder {
- public:
-  explicit StoreBufferRebuilder(StoreBuffer* store_buffer)
-      : store_buffer_(store_buffer) {
-  }
-
-  void Callback(MemoryChunk* page, StoreBufferEvent event);
-
- private:
-  StoreBuffer* store_buffer_;
-
-  // We record in this variable how full the store buffer was when we started
-  // iterating over the current page, finding pointers to new space.  If the
-  // store buffer overflows again we can exempt the page from the store buffer
-  // by rewinding to this point instead of having to search the store buffer.
-  Object*** start_of_current_page_;
-  // The current page we are scanning in the store buffer iterator.
-  MemoryChunk* current_page_;
-};
-
-
 
 // A queue of objects promoted during scavenge. Each object is accompanied
 // by it's size to avoid dereferencing a map pointer for scanning.
@@ -471,6 +453,78 @@ class ExternalStringTable {
 };
 
 
+// Keeps track of the backing stores that V8 allocated for array buffers.
+// The scavenger and the mark-compact collector report every buffer while
+// they process the weak list of array buffers.  The backing stores of dead
+// buffers are freed after the GC, on the unmapper thread if
+// --concurrent-array-buffer-freeing is on and the embedder's allocator is
+// thread-safe.
+class ArrayBufferTracker {
+ public:
+  // Starts tracking the backing store of a buffer allocated by V8.  The
+  // bytes count as external memory, so they make the next GC come sooner.
+  void RegisterNew(JSArrayBuffer* buffer);
+
+  // Stops tracking the backing store of a buffer, e.g. because it now
+  // belongs to the embedder.
+  void Unregister(JSArrayBuffer* buffer);
+
+  // The GC reports all buffers between PrepareForGC and FreeDead.
+  void PrepareForGC();
+  void ReportLive(JSArrayBuffer* buffer);
+  void ReportDead(JSArrayBuffer* buffer);
+  void FreeDead();
+
+  // Frees the backing stores queued by FreeDead.  Runs on the unmapper
+  // thread, or on the main thread if there is none.
+  void FreeQueued();
+
+  // Frees the backing stores of all dead buffers that are still queued.
+  void TearDown();
+
+  // Bytes in the backing stores of all live buffers, and of the ones that
+  // are still in new space.
+  size_t retained_bytes() { return retained_bytes_; }
+  size_t retained_bytes_in_new_space() { return retained_bytes_in_new_space_; }
+
+  // Whether FreeDead handed backing stores to the unmapper thread that it
+  // has not freed yet.
+  bool has_queued_frees() {
+    LockGuard<Mutex> lock_guard(&free_queue_mutex_);
+    return !free_queue_.is_empty();
+  }
+
+ private:
+  ArrayBufferTracker()
+      : retained_bytes_(0),
+        retained_bytes_in_new_space_(0),
+        freed_bytes_(0) { }
+
+  friend class Heap;
+
+  struct BackingStore {
+    void* data;
+    size_t length;
+  };
+
+  static size_t LengthOf(Isolate* isolate, JSArrayBuffer* buffer);
+
+  Heap* heap_;
+  size_t retained_bytes_;
+  size_t retained_bytes_in_new_space_;
+
+  // Backing stores of the buffers reported dead during the current GC.
+  List<BackingStore> dead_;
+  size_t freed_bytes_;
+
+  // Backing stores waiting to be freed, shared with the unmapper thread.
+  List<BackingStore> free_queue_;
+  Mutex free_queue_mutex_;
+
+  DISALLOW_COPY_AND_ASSIGN(ArrayBufferTracker);
+};
+
+
 enum ArrayStorageAllocationMode {
   DONT_INITIALIZE_ARRAY_ELEMENTS,
   INITIALIZE_ARRAY_ELEMENTS_WITH_HOLE
@@ -722,6 +776,9 @@ class Heap {
   // Please note this function does not perform a garbage collection.
   MUST_USE_RESULT MaybeObject* Allocate(Map* map, AllocationSpace space);
 
+  // Marks the map of an object that was allocated black.
+  inline void MarkMapOfBlackAllocatedObject(Map* map);
+
   MUST_USE_RESULT MaybeObject* AllocateWithAllocationSite(Map* map,
       AllocationSpace space, Handle<AllocationSite> allocation_site);
 
@@ -1192,6 +1249,8 @@ class Heap {
   static const int kSweepPreciselyMask = 1;
   static const int kReduceMemoryFootprintMask = 2;
   static const int kAbortIncrementalMarkingMask = 4;
+  // Discard the compiled code of all RegExps regardless of their age.
+  static const int kFlushRegExpCodeMask = 8;
 
   // Making the heap iterable requires us to sweep precisely and abort any
   // incremental marking as well.
@@ -1203,8 +1262,11 @@ class Heap {
   // in a state where we can iterate over the heap visiting all objects.
   void CollectAllGarbage(int flags, const char* gc_reason = NULL);
 
-  // Last hope GC, should try to squeeze as much as possible.
-  void CollectAllAvailableGarbage(const char* gc_reason = NULL);
+  // Last hope GC, should try to squeeze as much as possible. The given
+  // flags are applied in addition to kMakeHeapIterableMask and
+  // kReduceMemoryFootprintMask.
+  void CollectAllAvailableGarbage(const char* gc_reason = NULL,
+                                  int flags = kNoGCFlags);
 
   // Check whether the heap is currently iterable.
   bool IsHeapIterable();
@@ -1251,6 +1313,22 @@ class Heap {
                              bool pass_isolate = true);
   void RemoveGCEpilogueCallback(v8::Isolate::GCEpilogueCallback callback);
 
+  void AddNearHeapLimitCallback(v8::NearHeapLimitCallback callback,
+                                void* data);
+  void RemoveNearHeapLimitCallback(v8::NearHeapLimitCallback callback,
+                                   size_t heap_limit);
+
+  // Invokes the most recently added near heap limit callback.  Returns true
+  // if the callback raised the maximum old generation size.
+  bool InvokeNearHeapLimitCallback();
+
+  // Returns true if the old generation is within a few percent of its
+  // maximum size.
+  bool IsCloseToOutOfMemory() {
+    return PromotedSpaceSizeOfObjects() / kHighHeapPercentage >=
+        max_old_generation_size_ / 100;
+  }
+
   // Heap root getters.  We have versions with and without type::cast() here.
   // You can't use type::cast during GC because the assert fails.
   // TODO(1490): Try removing the unchecked accessors, now that GC marking does
@@ -1293,6 +1371,8 @@ class Heap {
   }
   Object* array_buffers_list() { return array_buffers_list_; }
 
+  ArrayBufferTracker* array_buffer_tracker() { return &array_buffer_tracker_; }
+
   void set_allocation_sites_list(Object* object) {
     allocation_sites_list_ = object;
   }
@@ -1443,6 +1523,11 @@ class Heap {
   // Write barrier support for address[start : start + len[ = o.
   INLINE(void RecordWrites(Address address, int start, int len));
 
+  // Forgets the old-to-new slots recorded in [start, end[.  Must be called
+  // when memory that may hold such slots is trimmed off an object or stops
+  // holding tagged values, before it can be reused for raw data.
+  void ClearRecordedSlotRange(Address start, Address end);
+
   enum HeapState { NOT_IN_GC, SCAVENGE, MARK_COMPACT };
   inline HeapState gc_state() { return gc_state_; }
 
@@ -1525,25 +1610,18 @@ class Heap {
   static const intptr_t kMinimumOldGenerationAllocationLimit =
       8 * (Page::kPageSize > MB ? Page::kPageSize : MB);
 
-  intptr_t OldGenerationAllocationLimit(intptr_t old_gen_size) {
-    const int divisor = FLAG_stress_compaction ? 10 :
-        new_space_high_promotion_mode_active_ ? 1 : 3;
-    intptr_t limit =
-        Max(old_gen_size + old_gen_size / divisor,
-            kMinimumOldGenerationAllocationLimit);
-    limit += new_space_.Capacity();
-    // TODO(hpayer): Can be removed when when pretenuring is supported for all
-    // allocation sites.
-    if (IsHighSurvivalRate() && IsStableOrIncreasingSurvivalTrend()) {
-      limit *= 2;
-    }
-    intptr_t halfway_to_the_max = (old_gen_size + max_old_generation_size_) / 2;
-    return Min(limit, halfway_to_the_max);
-  }
+  intptr_t OldGenerationAllocationLimit(intptr_t old_gen_size);
 
   // Implements the corresponding V8 API function.
   bool IdleNotification(int hint);
 
+  // Implements the corresponding V8 API function.
+  void MemoryPressureNotification(v8::MemoryPressureLevel level);
+
+  // Implements the corresponding V8 API function. The deadline is in
+  // seconds, on the same clock as OS::TimeCurrentMillis().
+  bool IdleNotificationDeadline(double deadline_in_seconds);
+
   // Declare all the root indices.
   enum RootListIndex {
 #define ROOT_INDEX_DECLARATION(type, name, camel_name) k##camel_name##RootIndex,
@@ -1602,6 +1680,10 @@ class Heap {
   // Check new space expansion criteria and expand semispaces if it was hit.
   void CheckNewSpaceExpansionCriteria();
 
+  // Percentage of the bytes that survived the last scavenge that were
+  // promoted to the old generation.
+  double promotion_rate() { return promotion_rate_; }
+
   inline void IncrementYoungSurvivorsCounter(int survived) {
     ASSERT(survived >= 0);
     young_survivors_after_last_gc_ = survived;
@@ -1629,12 +1711,16 @@ class Heap {
 
   void ProcessWeakReferences(WeakObjectRetainer* retainer);
 
+  // Replaces the string table with a smaller one if most of its entries
+  // have been removed.
+  void ShrinkStringTable();
+
   void VisitExternalResources(v8::ExternalResourceVisitor* visitor);
 
   // Helper function that governs the promotion policy from new space to
-  // old.  If the object's old address lies below the new space's age
-  // mark or if we've already filled the bottom 1/16th of the to space,
-  // we try to promote this object.
+  // old.  If the object has survived enough scavenges or if we've already
+  // filled the bottom quarter of the to space, we try to promote this
+  // object.
   inline bool ShouldBePromoted(Address old_address, int object_size);
 
   void ClearJSFunctionResultCaches();
@@ -1702,6 +1788,14 @@ class Heap {
     return &incremental_marking_;
   }
 
+  GCIdleTimeHandler* gc_idle_time_handler() {
+    return &gc_idle_time_handler_;
+  }
+
+  HeapController* heap_controller() {
+    return &heap_controller_;
+  }
+
   bool IsSweepingComplete() {
     return !mark_compact_collector()->IsConcurrentSweepingInProgress() &&
            old_data_space()->IsLazySweepingComplete() &&
@@ -1741,6 +1835,16 @@ class Heap {
     scavenging_visitors_table_.GetVisitor(map)(map, slot, obj);
   }
 
+  // Runs one task of the current parallel scavenge.  Called by the scavenger
+  // helper threads, task 0 is run by the main thread.
+  void RunParallelScavengeTask(int task_id);
+
+  // Number of objects that the scavenger helper threads evacuated during the
+  // last scavenge.  Zero if the last scavenge did not run in parallel.
+  int objects_evacuated_by_scavenger_threads() {
+    return objects_evacuated_by_scavenger_threads_;
+  }
+
   void QueueMemoryChunkForFree(MemoryChunk* chunk);
   void FreeQueuedChunks();
 
@@ -1887,6 +1991,7 @@ class Heap {
   int max_semispace_size_;
   int initial_semispace_size_;
   intptr_t max_old_generation_size_;
+  intptr_t initial_max_old_generation_size_;
   intptr_t max_executable_size_;
   intptr_t maximum_committed_;
 
@@ -1987,6 +2092,30 @@ class Heap {
   // last GC.
   bool old_gen_exhausted_;
 
+  // A mark-compact is ineffective if it was needed for an allocation to
+  // succeed and it leaves the old generation close to its maximum size while
+  // freeing less than kLowReclaimPercentage of it, with the mutator getting
+  // less than kLowMutatorUtilizationPercentage of the time since the previous
+  // mark-compact.  Several of them in a row mean that the heap is thrashing,
+  // and the near heap limit callback gets a chance to raise the limit before
+  // V8 gives up.  Collections forced through the API, by idle notifications
+  // or by memory pressure are not counted.
+  static const int kHighHeapPercentage = 95;
+  static const int kLowReclaimPercentage = 5;
+  static const int kLowMutatorUtilizationPercentage = 40;
+  static const int kMaxConsecutiveIneffectiveMarkCompacts = 4;
+  int consecutive_ineffective_mark_compacts_;
+  bool invoking_near_heap_limit_callback_;
+  // Set by AllocationFailureGCScope.
+  bool collecting_for_allocation_failure_;
+  double last_mark_compact_end_time_;
+
+  void UpdateIneffectiveMarkCompacts(intptr_t old_gen_size_before_gc,
+                                     double mark_compact_start_time);
+
+  // Changes the maximum capacity of the old generation spaces.
+  void SetMaxOldGenerationSize(intptr_t max_old_generation_size);
+
   // Weak list heads, threaded through the objects.
   // List heads are initilized lazily and contain the undefined_value at start.
   Object* native_contexts_list_;
@@ -1998,8 +2127,6 @@ class Heap {
   // start.
   Object* weak_object_to_code_table_;
 
-  StoreBufferRebuilder store_buffer_rebuilder_;
-
   struct StringTypeTable {
     InstanceType type;
     int size;
@@ -2059,6 +2186,18 @@ class Heap {
   };
   List<GCEpilogueCallbackPair> gc_epilogue_callbacks_;
 
+  struct NearHeapLimitCallbackPair {
+    NearHeapLimitCallbackPair(v8::NearHeapLimitCallback callback, void* data)
+        : callback(callback), data(data) {
+    }
+    bool operator==(const NearHeapLimitCallbackPair& pair) const {
+      return pair.callback == callback;
+    }
+    v8::NearHeapLimitCallback callback;
+    void* data;
+  };
+  List<NearHeapLimitCallbackPair> near_heap_limit_callbacks_;
+
   // Support for computing object sizes during GC.
   HeapObjectCallback gc_safe_size_of_old_object_;
   static int GcSafeSizeOfOldObject(HeapObject* object);
@@ -2156,9 +2295,15 @@ class Heap {
       Object** pointer);
 
   Address DoScavenge(ObjectVisitor* scavenge_visitor, Address new_space_front);
-  static void ScavengeStoreBufferCallback(Heap* heap,
-                                          MemoryChunk* page,
-                                          StoreBufferEvent event);
+
+  // Returns true if the roots and old-to-new pointers of the current scavenge
+  // can be processed by the scavenger helper threads.
+  bool CanScavengeInParallel();
+
+  // Copies the objects reachable from the roots and the old-to-new pointers
+  // using several tasks.  Returns the new space front from which the
+  // sequential part of the scavenge continues.
+  Address ScavengeInParallel();
 
   // Performs a major collection in the whole heap.
   void MarkCompact(GCTracer* tracer);
@@ -2217,6 +2362,7 @@ class Heap {
   int high_survival_rate_period_length_;
   int low_survival_rate_period_length_;
   double survival_rate_;
+  double promotion_rate_;
   SurvivalRateTrend previous_survival_rate_trend_;
   SurvivalRateTrend survival_rate_trend_;
 
@@ -2302,6 +2448,10 @@ class Heap {
 
   void AdvanceIdleIncrementalMarking(intptr_t step_size);
 
+  // Carries out the action chosen by the idle time handler. Returns true if
+  // no more GC work is left in the current idle round.
+  bool PerformIdleTimeAction(GCIdleTimeAction action);
+
   void ClearObjectStats(bool clear_last_time_stats = false);
 
   void set_weak_object_to_code_table(Object* value) {
@@ -2354,6 +2504,10 @@ class Heap {
 
   IncrementalMarking incremental_marking_;
 
+  GCIdleTimeHandler gc_idle_time_handler_;
+
+  HeapController heap_controller_;
+
   int number_idle_notifications_;
   unsigned int last_idle_notification_gc_count_;
   bool last_idle_notification_gc_count_init_;
@@ -2381,12 +2535,20 @@ class Heap {
   // Shared state read by the scavenge collector and set by ScavengeObject.
   PromotionQueue promotion_queue_;
 
+  // State shared by the tasks of a parallel scavenge.  Only set while the
+  // tasks are running.
+  ParallelScavenger* parallel_scavenger_;
+
+  int objects_evacuated_by_scavenger_threads_;
+
   // Flag is set when the heap has been configured.  The heap can be repeatedly
   // configured through the API until it is set up.
   bool configured_;
 
   ExternalStringTable external_string_table_;
 
+  ArrayBufferTracker array_buffer_tracker_;
+
   VisitorDispatchTable<ScavengingCallback> scavenging_visitors_table_;
 
   MemoryChunk* chunks_queued_for_free_;
@@ -2400,6 +2562,7 @@ class Heap {
   friend class GCTracer;
   friend class DisallowAllocationFailure;
   friend class AlwaysAllocateScope;
+  friend class AllocationFailureGCScope;
   friend class Page;
   friend class Isolate;
   friend class MarkCompactCollector;
@@ -2470,6 +2633,18 @@ class AlwaysAllocateScope {
   DisallowAllocationFailure disallow_allocation_failure_;
 };
 
+// Marks the garbage collections in its scope as needed for an allocation to
+// succeed, either right after the allocation failed or as a last resort.
+class AllocationFailureGCScope {
+ public:
+  explicit inline AllocationFailureGCScope(Heap* heap);
+  inline ~AllocationFailureGCScope();
+
+ private:
+  Heap* heap_;
+  bool previous_;
+};
+
 #ifdef VERIFY_HEAP
 class NoWeakObjectVerificationScope {
  public:
@@ -2790,6 +2965,10 @@ class GCTracer BASE_EMBEDDED {
     nodes_promoted_++;
   }
 
+  void increment_deduplicated_strings_size(int object_size) {
+    deduplicated_strings_size_ += object_size;
+  }
+
  private:
   // Returns a string matching the collector.
   const char* CollectorString();
@@ -2806,6 +2985,12 @@ class GCTracer BASE_EMBEDDED {
   // Size of memory allocated from OS set in constructor.
   intptr_t start_memory_size_;
 
+  // Size of objects in new space set in constructor.
+  intptr_t start_new_space_size_;
+
+  // Whether incremental marking was running when the collection started.
+  bool incremental_marking_in_progress_;
+
   // Type of collector.
   GarbageCollector collector_;
 
@@ -2843,6 +3028,9 @@ class GCTracer BASE_EMBEDDED {
   // Number of promoted nodes to the old space.
   int nodes_promoted_;
 
+  // Size of the duplicate strings merged away during compaction.
+  intptr_t deduplicated_strings_size_;
+
   // Incremental marking steps counters.
   int steps_count_;
   double steps_took_;
@@ -4208,6 +4208,12 @@ HObjectAccess HObjectAccess::ForField(Handle<Map> map,
     // Negative property indices are in-object properties, indexed
     // from the end of the fixed part of the object.
     int offset = (index * kPointerSize) + map->instance_size();
+    int field_index = index + map->inobject_properties();
+    Map* layout_map = lookup->IsField()
+        ? *map : lookup->GetTransitionMapFromMap(*map);
+    if (layout_map->IsUnboxedDoubleField(field_index)) {
+      return ForUnboxedDoubleField(offset, name);
+    }
     return HObjectAccess(kInobject, offset, representation);
   } else {
     // Non-negative property indices are in the properties array.
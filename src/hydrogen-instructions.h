@@ -5732,6 +5732,12 @@ class HObjectAccess V8_FINAL {
     return portion() == kStringLengths;
   }
 
+  // The access reads or writes a double value in place rather than a
+  // HeapNumber box holding it.
+  inline bool IsUnboxedDouble() const {
+    return portion() == kDouble && representation().IsDouble();
+  }
+
   inline int offset() const {
     return OffsetField::decode(value_);
   }
@@ -5753,6 +5759,12 @@ class HObjectAccess V8_FINAL {
         kDouble, HeapNumber::kValueOffset, Representation::Double());
   }
 
+  // Create an access to an in-object double field stored unboxed.
+  static HObjectAccess ForUnboxedDoubleField(int offset,
+      Handle<String> name = Handle<String>::null()) {
+    return HObjectAccess(kDouble, offset, Representation::Double(), name);
+  }
+
   static HObjectAccess ForHeapNumberValueLowestBits() {
     return HObjectAccess(kDouble,
                          HeapNumber::kValueOffset,
@@ -6286,7 +6298,8 @@ class HStoreNamedField V8_FINAL : public HTemplateInstruction<3> {
   DECLARE_CONCRETE_INSTRUCTION(StoreNamedField)
 
   virtual bool HasEscapingOperandAt(int index) V8_OVERRIDE {
-    return index == 1;
+    // Captured objects are materialized with tagged fields only.
+    return index == 1 || access().IsUnboxedDouble();
   }
   virtual bool HasOutOfBoundsAccess(int size) V8_OVERRIDE {
     return !access().IsInobject() || access().offset() >= size;
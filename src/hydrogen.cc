@@ -4291,6 +4291,7 @@ static bool IsFastLiteral(Handle<JSObject> boilerplate,
       if (details.type() != FIELD) continue;
       int index = descriptors->GetFieldIndex(i);
       if ((*max_properties)-- == 0) return false;
+      if (boilerplate->IsUnboxedDoubleField(index)) continue;
       Handle<Object> value(boilerplate->InObjectPropertyAt(index), isolate);
       if (value->IsJSObject()) {
         Handle<JSObject> value_object = Handle<JSObject>::cast(value);
@@ -4601,6 +4602,23 @@ HInstruction* HOptimizedGraphBuilder::BuildStoreNamedField(
   HObjectAccess field_access = HObjectAccess::ForField(map, lookup, name);
   bool transition_to_field = lookup->IsTransitionToField(*map);
 
+  if (field_access.IsUnboxedDouble()) {
+    // The double is written in place. On a transition, the value is stored
+    // before the map that turns the slot into a raw double slot.
+    HStoreNamedField* store = New<HStoreNamedField>(
+        checked_object->ActualValue(), field_access, value);
+    if (!transition_to_field) return store;
+    AddInstruction(store);
+    Handle<Map> transition(lookup->GetTransitionMapFromMap(*map));
+    if (transition->CanBeDeprecated()) {
+      transition->AddDependentCompilationInfo(
+          DependentCode::kTransitionGroup, top_info());
+    }
+    return New<HStoreNamedField>(checked_object->ActualValue(),
+                                 HObjectAccess::ForMap(),
+                                 Add<HConstant>(transition));
+  }
+
   HStoreNamedField *instr;
   if (FLAG_track_double_fields && field_access.representation().IsDouble()) {
     HObjectAccess heap_number_access =
@@ -4727,6 +4745,9 @@ bool HOptimizedGraphBuilder::PropertyAccessInfo::IsCompatibleForLoad(
   if (!info->access_.representation().IsCompatibleForLoad(r)) return false;
   if (info->access_.offset() != access_.offset()) return false;
   if (info->access_.IsInobject() != access_.IsInobject()) return false;
+  if (info->access_.IsUnboxedDouble() != access_.IsUnboxedDouble()) {
+    return false;
+  }
   info->GeneralizeRepresentation(r);
   return true;
 }
@@ -5496,7 +5517,8 @@ void HOptimizedGraphBuilder::VisitThrow(Throw* expr) {
 
 HLoadNamedField* HGraphBuilder::BuildLoadNamedField(HValue* object,
                                                     HObjectAccess access) {
-  if (FLAG_track_double_fields && access.representation().IsDouble()) {
+  if (FLAG_track_double_fields && access.representation().IsDouble() &&
+      !access.IsUnboxedDouble()) {
     // load the heap number
     HLoadNamedField* heap_number = Add<HLoadNamedField>(
         object, access.WithRepresentation(Representation::Tagged()));
@@ -8444,6 +8466,14 @@ void HOptimizedGraphBuilder::BuildEmitInObjectProperties(
     copied_fields++;
     int index = descriptors->GetFieldIndex(i);
     int property_offset = boilerplate_object->GetInObjectPropertyOffset(index);
+    if (boilerplate_object->IsUnboxedDoubleField(index)) {
+      HInstruction* value_instruction =
+          Add<HConstant>(boilerplate_object->RawFastDoublePropertyAt(index));
+      Add<HStoreNamedField>(
+          object, HObjectAccess::ForUnboxedDoubleField(property_offset),
+          value_instruction);
+      continue;
+    }
     Handle<Name> name(descriptors->GetKey(i));
     Handle<Object> value =
         Handle<Object>(boilerplate_object->InObjectPropertyAt(index),
@@ -703,6 +703,8 @@ Handle<Code> CallICBase::ComputeMonomorphicStub(LookupResult* lookup,
   switch (lookup->type()) {
     case FIELD: {
       PropertyIndex index = lookup->GetFieldIndex();
+      // A double is never callable; leave unboxed fields to the runtime.
+      if (index.is_unboxed_double(holder)) return Handle<Code>::null();
       return isolate()->stub_cache()->ComputeCallField(
           argc, kind_, extra_ic_state(), name, object, holder, index);
     }
@@ -1109,12 +1111,13 @@ void IC::PatchCache(Handle<HeapObject> receiver,
 
 Handle<Code> LoadIC::SimpleFieldLoad(int offset,
                                      bool inobject,
-                                     Representation representation) {
+                                     Representation representation,
+                                     bool raw_double) {
   if (kind() == Code::LOAD_IC) {
-    LoadFieldStub stub(inobject, offset, representation);
+    LoadFieldStub stub(inobject, offset, representation, raw_double);
     return stub.GetCode(isolate());
   } else {
-    KeyedLoadFieldStub stub(inobject, offset, representation);
+    KeyedLoadFieldStub stub(inobject, offset, representation, raw_double);
     return stub.GetCode(isolate());
   }
 }
@@ -1197,7 +1200,8 @@ Handle<Code> LoadIC::CompileHandler(LookupResult* lookup,
       if (receiver.is_identical_to(holder)) {
         return SimpleFieldLoad(field.translate(holder),
                                field.is_inobject(holder),
-                               lookup->representation());
+                               lookup->representation(),
+                               field.is_unboxed_double(holder));
       }
       return compiler.CompileLoadField(
           receiver, holder, name, field, lookup->representation());
@@ -443,7 +443,8 @@ class LoadIC: public IC {
   Handle<Code> SimpleFieldLoad(int offset,
                                bool inobject = true,
                                Representation representation =
-                                    Representation::Tagged());
+                                    Representation::Tagged(),
+                               bool raw_double = false);
 
   static void Clear(Isolate* isolate, Address address, Code* target);
 
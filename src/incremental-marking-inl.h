@@ -140,6 +140,15 @@ void IncrementalMarking::WhiteToGreyAndPush(HeapObject* obj, MarkBit mark_bit) {
 }
 
 
+void IncrementalMarking::MarkAllocatedObjectBlack(HeapObject* obj, int size) {
+  ASSERT(black_allocation_);
+  MarkBit mark_bit = Marking::MarkBitFrom(obj);
+  ASSERT(Marking::IsWhite(mark_bit));
+  Marking::MarkBlack(mark_bit);
+  MemoryChunk::IncrementLiveBytesFromGC(obj->address(), size);
+}
+
+
 } }  // namespace v8::internal
 
 #endif  // V8_INCREMENTAL_MARKING_INL_H_
@@ -31,6 +31,7 @@
 
 #include "code-stubs.h"
 #include "compilation-cache.h"
+#include "marking-thread.h"
 #include "objects-visiting.h"
 #include "objects-visiting-inl.h"
 #include "v8conversions.h"
@@ -42,6 +43,7 @@ namespace internal {
 IncrementalMarking::IncrementalMarking(Heap* heap)
     : heap_(heap),
       state_(STOPPED),
+      black_allocation_(false),
       marking_deque_memory_(NULL),
       marking_deque_memory_committed_(false),
       steps_count_(0),
@@ -55,7 +57,10 @@ IncrementalMarking::IncrementalMarking(Heap* heap)
       marking_speed_(0),
       allocated_(0),
       no_marking_scope_depth_(0),
-      unscanned_bytes_of_large_object_(0) {
+      unscanned_bytes_of_large_object_(0),
+      weak_collection_passes_(0),
+      concurrent_marking_paused_(true),
+      concurrent_marking_scanning_(false) {
 }
 
 
@@ -275,10 +280,40 @@ class IncrementalMarkingMarkingVisitor
 
   static void VisitWeakCollection(Map* map, HeapObject* object) {
     Heap* heap = map->GetHeap();
+    MarkCompactCollector* collector = heap->mark_compact_collector();
+    JSWeakCollection* weak_collection =
+        reinterpret_cast<JSWeakCollection*>(object);
+
+    // Mark the backing hash table black without scanning it and enqueue the
+    // weak collection, so that its entries are treated as ephemerons.  A
+    // table that is already grey is traced as a regular array, e.g. because
+    // it was stored into a black weak collection.
+    Object* table_object = weak_collection->table();
+    if (table_object->IsHashTable()) {
+      HeapObject* table = HeapObject::cast(table_object);
+      Object** table_slot =
+          HeapObject::RawField(object, JSWeakCollection::kTableOffset);
+      collector->RecordSlot(table_slot, table_slot, table);
+      MarkBit table_mark_bit = Marking::MarkBitFrom(table);
+      if (Marking::IsWhite(table_mark_bit)) {
+        MarkBlackOrKeepBlack(table, table_mark_bit, table->Size());
+      }
+      if (weak_collection->next()->IsUndefined()) {
+        weak_collection->set_next(collector->encountered_weak_collections());
+        collector->set_encountered_weak_collections(weak_collection);
+      }
+    }
+
+    int object_size = JSWeakCollection::BodyDescriptor::SizeOf(map, object);
     VisitPointers(heap,
                   HeapObject::RawField(object,
                                        JSWeakCollection::kPropertiesOffset),
-                  HeapObject::RawField(object, JSWeakCollection::kSize));
+                  HeapObject::RawField(object, JSWeakCollection::kTableOffset));
+    VisitPointers(heap,
+                  HeapObject::RawField(object,
+                                       JSWeakCollection::kTableOffset +
+                                           kPointerSize),
+                  HeapObject::RawField(object, object_size));
   }
 
   static void BeforeVisitingSharedFunctionInfo(HeapObject* object) {}
@@ -607,12 +642,20 @@ void IncrementalMarking::StartMarking(CompactionFlag flag) {
     PrintF("[IncrementalMarking] Start marking\n");
   }
 
+  weak_collection_passes_ = 0;
+
   is_compacting_ = !FLAG_never_compact && (flag == ALLOW_COMPACTION) &&
       heap_->mark_compact_collector()->StartCompaction(
           MarkCompactCollector::INCREMENTAL_COMPACTION);
 
   state_ = MARKING;
 
+  // The sweeper has cleared the mark bits of free memory, so linear
+  // allocation can hand out objects that are marked right away.  Runtime
+  // initializing stores skip the write barrier and would leave slots into
+  // evacuation candidates unrecorded, so compacting cycles allocate white.
+  black_allocation_ = FLAG_black_allocation && !is_compacting_;
+
   RecordWriteStub::Mode mode = is_compacting_ ?
       RecordWriteStub::INCREMENTAL_COMPACTION : RecordWriteStub::INCREMENTAL;
 
@@ -650,6 +693,8 @@ void IncrementalMarking::StartMarking(CompactionFlag flag) {
 
   heap_->mark_compact_collector()->MarkWeakObjectToCodeTable();
 
+  ResumeConcurrentMarking();
+
   // Ready to start incremental marking.
   if (FLAG_trace_incremental_marking) {
     PrintF("[IncrementalMarking] Running\n");
@@ -659,6 +704,8 @@ void IncrementalMarking::StartMarking(CompactionFlag flag) {
 
 void IncrementalMarking::PrepareForScavenge() {
   if (!IsMarking()) return;
+  // The marking thread must not observe objects while they are moved.
+  PauseConcurrentMarking();
   NewSpacePageIterator it(heap_->new_space()->FromSpaceStart(),
                           heap_->new_space()->FromSpaceEnd());
   while (it.has_next()) {
@@ -713,6 +760,8 @@ void IncrementalMarking::UpdateMarkingDequeAfterScavenge() {
   }
   marking_deque_.set_top(new_top);
 
+  ResumeConcurrentMarking();
+
   steps_took_since_last_gc_ = 0;
   steps_count_since_last_gc_ = 0;
   longest_step_ = 0.0;
@@ -739,9 +788,11 @@ void IncrementalMarking::VisitObject(Map* map, HeapObject* obj, int size) {
 }
 
 
-void IncrementalMarking::ProcessMarkingDeque(intptr_t bytes_to_process) {
+intptr_t IncrementalMarking::ProcessMarkingDeque(intptr_t bytes_to_process) {
+  intptr_t bytes_processed = 0;
   Map* filler_map = heap_->one_pointer_filler_map();
-  while (!marking_deque_.IsEmpty() && bytes_to_process > 0) {
+  int hand_off_budget = ConcurrentMarkingHandOffBudget();
+  while (!marking_deque_.IsEmpty() && bytes_processed < bytes_to_process) {
     HeapObject* obj = marking_deque_.Pop();
 
     // Explicitly skip one word fillers. Incremental markbit patterns are
@@ -750,10 +801,17 @@ void IncrementalMarking::ProcessMarkingDeque(intptr_t bytes_to_process) {
     if (map == filler_map) continue;
 
     int size = obj->SizeFromMap(map);
+    if (hand_off_budget > 0 && CanHandOffToMarkingThread(map, obj)) {
+      HandOffToMarkingThread(map, obj, size);
+      hand_off_budget--;
+      continue;
+    }
     unscanned_bytes_of_large_object_ = 0;
     VisitObject(map, obj, size);
-    bytes_to_process -= (size - unscanned_bytes_of_large_object_);
+    bytes_processed += (size - unscanned_bytes_of_large_object_);
   }
+  FlushConcurrentMarkingHandOff();
+  return bytes_processed;
 }
 
 
@@ -772,7 +830,276 @@ void IncrementalMarking::ProcessMarkingDeque() {
 }
 
 
+bool IncrementalMarking::ProcessWeakCollections() {
+  if (weak_collection_passes_ == kMaxWeakCollectionPasses) return false;
+  weak_collection_passes_++;
+  bool greyed_values = false;
+  MarkCompactCollector* collector = heap_->mark_compact_collector();
+  Object* weak_collection_obj = collector->encountered_weak_collections();
+  while (weak_collection_obj != Smi::FromInt(0)) {
+    JSWeakCollection* weak_collection =
+        reinterpret_cast<JSWeakCollection*>(weak_collection_obj);
+    ObjectHashTable* table = ObjectHashTable::cast(weak_collection->table());
+    for (int i = 0; i < table->Capacity(); i++) {
+      Object* value = table->get(ObjectHashTable::EntryToValueIndex(i));
+      if (!value->IsHeapObject()) continue;
+      HeapObject* key = HeapObject::cast(table->KeyAt(i));
+      if (Marking::IsWhite(Marking::MarkBitFrom(key))) continue;
+      if (!Marking::IsWhite(Marking::MarkBitFrom(HeapObject::cast(value)))) {
+        continue;
+      }
+      IncrementalMarkingMarkingVisitor::MarkObject(heap_, value);
+      greyed_values = true;
+    }
+    weak_collection_obj = weak_collection->next();
+  }
+  return greyed_values;
+}
+
+
+MarkingThread* IncrementalMarking::marking_thread() {
+  return heap_->isolate()->marking_thread();
+}
+
+
+int IncrementalMarking::ConcurrentMarkingHandOffBudget() {
+  if (marking_thread() == NULL || concurrent_marking_paused_) return 0;
+  LockGuard<Mutex> lock_guard(&concurrent_marking_mutex_);
+  return kMaxConcurrentMarkingInput - concurrent_marking_input_.length();
+}
+
+
+static inline bool IsScannedConcurrently(int visitor_id) {
+  switch (visitor_id) {
+    case StaticVisitorBase::kVisitFixedArray:
+    case StaticVisitorBase::kVisitShortcutCandidate:
+    case StaticVisitorBase::kVisitConsString:
+    case StaticVisitorBase::kVisitSlicedString:
+    case StaticVisitorBase::kVisitSymbol:
+      return true;
+    default:
+      return (visitor_id >= StaticVisitorBase::kVisitJSObject &&
+              visitor_id <= StaticVisitorBase::kVisitJSObjectGeneric) ||
+             (visitor_id >= StaticVisitorBase::kVisitStruct &&
+              visitor_id <= StaticVisitorBase::kVisitStructGeneric);
+  }
+}
+
+
+// Only plain objects in old pointer space are scanned by the marking thread.
+// Their bodies consist of tagged fields only and none of them needs special
+// treatment by the incremental marking visitor.  Objects are not handed off
+// while compacting, since slots would have to be recorded.  With unboxed
+// double fields, stores may write a raw double into a slot before the map
+// that describes it is installed, so plain objects stay on the main thread.
+bool IncrementalMarking::CanHandOffToMarkingThread(Map* map, HeapObject* obj) {
+  if (is_compacting_) return false;
+  if (FLAG_unbox_double_fields && map->instance_type() == JS_OBJECT_TYPE) {
+    return false;
+  }
+  MemoryChunk* chunk = MemoryChunk::FromAddress(obj->address());
+  if (chunk->owner()->identity() != OLD_POINTER_SPACE) return false;
+  return IsScannedConcurrently(map->visitor_id());
+}
+
+
+// The object is marked black before it is scanned, so any later write into it
+// hits the write barrier and queues the object for rescanning on the main
+// thread.  Values read by the marking thread are thus either reported back or
+// seen again when the object is rescanned.
+void IncrementalMarking::HandOffToMarkingThread(Map* map,
+                                                HeapObject* obj,
+                                                int size) {
+  MarkBit map_mark_bit = Marking::MarkBitFrom(map);
+  if (Marking::IsWhite(map_mark_bit)) {
+    WhiteToGreyAndPush(map, map_mark_bit);
+  }
+  MarkBlackOrKeepBlack(obj, Marking::MarkBitFrom(obj), size);
+  concurrent_marking_hand_off_.Add(obj);
+}
+
+
+void IncrementalMarking::FlushConcurrentMarkingHandOff() {
+  if (concurrent_marking_hand_off_.is_empty()) return;
+  { LockGuard<Mutex> lock_guard(&concurrent_marking_mutex_);
+    concurrent_marking_input_.AddAll(concurrent_marking_hand_off_);
+  }
+  concurrent_marking_hand_off_.Rewind(0);
+  marking_thread()->StartMarking();
+}
+
+
+// Called on the marking thread.  Reads the tagged fields of the object and
+// checks afterwards that its map and size did not change in the meantime,
+// otherwise the object is left to the main thread.  Objects in new space are
+// reported without looking at them, as they may be moved by a scavenge.
+bool IncrementalMarking::ScanObjectConcurrently(HeapObject* obj,
+                                                List<Object*>* fields,
+                                                List<HeapObject*>* found) {
+  Map* map = obj->acquire_map_word().ToMap();
+  int visitor_id = map->visitor_id();
+  if (!IsScannedConcurrently(visitor_id)) return false;
+
+  int start_offset;
+  int end_offset;
+  switch (visitor_id) {
+    case StaticVisitorBase::kVisitFixedArray:
+      start_offset = FixedArray::BodyDescriptor::kStartOffset;
+      end_offset = FixedArray::BodyDescriptor::SizeOf(map, obj);
+      break;
+    case StaticVisitorBase::kVisitShortcutCandidate:
+    case StaticVisitorBase::kVisitConsString:
+      start_offset = ConsString::BodyDescriptor::kStartOffset;
+      end_offset = ConsString::BodyDescriptor::kEndOffset;
+      break;
+    case StaticVisitorBase::kVisitSlicedString:
+      start_offset = SlicedString::BodyDescriptor::kStartOffset;
+      end_offset = SlicedString::BodyDescriptor::kEndOffset;
+      break;
+    case StaticVisitorBase::kVisitSymbol:
+      start_offset = Symbol::BodyDescriptor::kStartOffset;
+      end_offset = Symbol::BodyDescriptor::kEndOffset;
+      break;
+    default:
+      if (visitor_id <= StaticVisitorBase::kVisitJSObjectGeneric) {
+        start_offset = JSObject::BodyDescriptor::kStartOffset;
+      } else {
+        start_offset = StructBodyDescriptor::kStartOffset;
+      }
+      end_offset = map->instance_size();
+      break;
+  }
+
+  fields->Rewind(0);
+  for (int offset = start_offset; offset < end_offset; offset += kPointerSize) {
+    fields->Add(*HeapObject::RawField(obj, offset));
+  }
+
+  MemoryBarrier();
+  if (obj->acquire_map_word().ToMap() != map) return false;
+  if (visitor_id == StaticVisitorBase::kVisitFixedArray &&
+      FixedArray::BodyDescriptor::SizeOf(map, obj) != end_offset) {
+    return false;
+  }
+
+  for (int i = 0; i < fields->length(); i++) {
+    Object* value = fields->at(i);
+    if (!value->IsHeapObject()) continue;
+    HeapObject* heap_object = HeapObject::cast(value);
+    if (heap_->InNewSpace(heap_object) ||
+        Marking::IsWhite(Marking::MarkBitFrom(heap_object))) {
+      found->Add(heap_object);
+    }
+  }
+  return true;
+}
+
+
+void IncrementalMarking::ProcessConcurrentMarkingInput() {
+  List<HeapObject*> batch(kConcurrentMarkingBatchSize);
+  List<HeapObject*> found;
+  List<HeapObject*> rescan;
+  List<Object*> fields;
+  while (true) {
+    { LockGuard<Mutex> lock_guard(&concurrent_marking_mutex_);
+      concurrent_marking_found_.AddAll(found);
+      concurrent_marking_rescan_.AddAll(rescan);
+      found.Rewind(0);
+      rescan.Rewind(0);
+      batch.Rewind(0);
+      if (concurrent_marking_paused_ || concurrent_marking_input_.is_empty()) {
+        concurrent_marking_scanning_ = false;
+        concurrent_marking_idle_.NotifyAll();
+        return;
+      }
+      while (!concurrent_marking_input_.is_empty() &&
+             batch.length() < kConcurrentMarkingBatchSize) {
+        batch.Add(concurrent_marking_input_.RemoveLast());
+      }
+      concurrent_marking_scanning_ = true;
+    }
+    for (int i = 0; i < batch.length(); i++) {
+      if (!ScanObjectConcurrently(batch[i], &fields, &found)) {
+        rescan.Add(batch[i]);
+      }
+    }
+  }
+}
+
+
+void IncrementalMarking::CommitConcurrentMarkingResults() {
+  if (marking_thread() == NULL) return;
+  LockGuard<Mutex> lock_guard(&concurrent_marking_mutex_);
+  for (int i = 0; i < concurrent_marking_found_.length(); i++) {
+    HeapObject* obj = concurrent_marking_found_[i];
+    MarkBit mark_bit = Marking::MarkBitFrom(obj);
+    if (mark_bit.data_only()) {
+      MarkBlackOrKeepGrey(obj, mark_bit, obj->Size());
+    } else if (Marking::IsWhite(mark_bit)) {
+      WhiteToGreyAndPush(obj, mark_bit);
+    }
+  }
+  concurrent_marking_found_.Rewind(0);
+  for (int i = 0; i < concurrent_marking_rescan_.length(); i++) {
+    RescanHandedOffObject(concurrent_marking_rescan_[i]);
+  }
+  concurrent_marking_rescan_.Rewind(0);
+}
+
+
+void IncrementalMarking::RescanHandedOffObject(HeapObject* obj) {
+  // Left trimming of an array leaves fillers at its old start and transfers
+  // the black color to the remaining part, which then has to be rescanned.
+  Address limit = Page::FromAddress(obj->address())->area_end();
+  while (obj->IsFiller()) {
+    Address next = obj->address() + obj->Size();
+    if (next >= limit) return;
+    obj = HeapObject::FromAddress(next);
+  }
+  MarkBit mark_bit = Marking::MarkBitFrom(obj);
+  if (Marking::IsBlack(mark_bit)) {
+    Marking::BlackToGrey(mark_bit);
+    MemoryChunk::IncrementLiveBytesFromGC(obj->address(), -obj->Size());
+    marking_deque_.UnshiftGrey(obj);
+  }
+}
+
+
+bool IncrementalMarking::IsConcurrentMarkingDone() {
+  if (marking_thread() == NULL) return true;
+  LockGuard<Mutex> lock_guard(&concurrent_marking_mutex_);
+  return !concurrent_marking_scanning_ &&
+         concurrent_marking_input_.is_empty() &&
+         concurrent_marking_found_.is_empty() &&
+         concurrent_marking_rescan_.is_empty();
+}
+
+
+void IncrementalMarking::PauseConcurrentMarking() {
+  if (marking_thread() == NULL) return;
+  { LockGuard<Mutex> lock_guard(&concurrent_marking_mutex_);
+    concurrent_marking_paused_ = true;
+    while (concurrent_marking_scanning_) {
+      concurrent_marking_idle_.Wait(&concurrent_marking_mutex_);
+    }
+    for (int i = 0; i < concurrent_marking_input_.length(); i++) {
+      concurrent_marking_rescan_.Add(concurrent_marking_input_[i]);
+    }
+    concurrent_marking_input_.Rewind(0);
+  }
+  CommitConcurrentMarkingResults();
+}
+
+
+void IncrementalMarking::ResumeConcurrentMarking() {
+  if (marking_thread() == NULL) return;
+  LockGuard<Mutex> lock_guard(&concurrent_marking_mutex_);
+  concurrent_marking_paused_ = false;
+}
+
+
 void IncrementalMarking::Hurry() {
+  PauseConcurrentMarking();
   if (state() == MARKING) {
     double start = 0.0;
     if (FLAG_trace_incremental_marking || FLAG_print_cumulative_gc_stat) {
@@ -830,6 +1157,7 @@ void IncrementalMarking::Abort() {
   IncrementalMarking::set_should_hurry(false);
   ResetStepCounters();
   if (IsMarking()) {
+    PauseConcurrentMarking();
     PatchIncrementalMarkingRecordWriteStubs(heap_,
                                             RecordWriteStub::STORE_BUFFER_ONLY);
     DeactivateIncrementalWriteBarrier();
@@ -847,6 +1175,7 @@ void IncrementalMarking::Abort() {
   heap_->isolate()->stack_guard()->Continue(GC_REQUEST);
   state_ = STOPPED;
   is_compacting_ = false;
+  black_allocation_ = false;
 }
 
 
@@ -854,6 +1183,7 @@ void IncrementalMarking::Finalize() {
   Hurry();
   state_ = STOPPED;
   is_compacting_ = false;
+  black_allocation_ = false;
   heap_->new_space()->LowerInlineAllocationLimit(0);
   IncrementalMarking::set_should_hurry(false);
   ResetStepCounters();
@@ -925,12 +1255,8 @@ void IncrementalMarking::Step(intptr_t allocated_bytes,
 
   bytes_scanned_ += bytes_to_process;
 
-  double start = 0;
-
-  if (FLAG_trace_incremental_marking || FLAG_trace_gc ||
-      FLAG_print_cumulative_gc_stat) {
-    start = OS::TimeCurrentMillis();
-  }
+  double start = OS::TimeCurrentMillis();
+  intptr_t bytes_processed = 0;
 
   if (state_ == SWEEPING) {
     if (heap_->EnsureSweepersProgressed(static_cast<int>(bytes_to_process))) {
@@ -938,8 +1264,20 @@ void IncrementalMarking::Step(intptr_t allocated_bytes,
       StartMarking(PREVENT_COMPACTION);
     }
   } else if (state_ == MARKING) {
-    ProcessMarkingDeque(bytes_to_process);
-    if (marking_deque_.IsEmpty()) MarkingComplete(action);
+    CommitConcurrentMarkingResults();
+    bytes_processed = ProcessMarkingDeque(bytes_to_process);
+    if (marking_deque_.IsEmpty() && !IsConcurrentMarkingDone()) {
+      // The mutator keeps handing off objects it writes to, so instead of
+      // waiting for the marking thread to become idle on its own, the rest
+      // of its input is taken back and scanned here.
+      PauseConcurrentMarking();
+      bytes_processed += ProcessMarkingDeque(bytes_to_process);
+      ResumeConcurrentMarking();
+    }
+    if (marking_deque_.IsEmpty() && IsConcurrentMarkingDone() &&
+        !ProcessWeakCollections()) {
+      MarkingComplete(action);
+    }
   }
 
   steps_count_++;
@@ -1008,10 +1346,15 @@ void IncrementalMarking::Step(intptr_t allocated_bytes,
     }
   }
 
+  double end = OS::TimeCurrentMillis();
+  double delta = (end - start);
+  if (bytes_processed > 0) {
+    heap_->gc_idle_time_handler()->NotifyIncrementalMarkingStep(
+        bytes_processed, delta);
+  }
+
   if (FLAG_trace_incremental_marking || FLAG_trace_gc ||
       FLAG_print_cumulative_gc_stat) {
-    double end = OS::TimeCurrentMillis();
-    double delta = (end - start);
     longest_step_ = Max(longest_step_, delta);
     steps_took_ += delta;
     steps_took_since_last_gc_ += delta;
@@ -32,10 +32,12 @@
 #include "execution.h"
 #include "mark-compact.h"
 #include "objects.h"
+#include "platform/condition-variable.h"
 
 namespace v8 {
 namespace internal {
 
+class MarkingThread;
 
 class IncrementalMarking {
  public:
@@ -163,6 +165,15 @@ class IncrementalMarking {
 
   inline void WhiteToGreyAndPush(HeapObject* obj, MarkBit mark_bit);
 
+  // With --black-allocation, objects that the runtime allocates in the old
+  // spaces while marking are marked black right away.  They survive the
+  // current cycle without being discovered or scanned by the marker.  Stores
+  // into them go through the write barrier like stores into any other black
+  // object.
+  bool black_allocation() { return black_allocation_; }
+
+  inline void MarkAllocatedObjectBlack(HeapObject* obj, int size);
+
   inline int steps_count() {
     return steps_count_;
   }
@@ -195,6 +206,8 @@ class IncrementalMarking {
 
   bool IsCompacting() { return IsMarking() && is_compacting_; }
 
+  int marking_speed() { return marking_speed_; }
+
   void ActivateGeneratedStub(Code* stub);
 
   void NotifyOfHighPromotionRate() {
@@ -224,6 +237,18 @@ class IncrementalMarking {
     unscanned_bytes_of_large_object_ = unscanned_bytes;
   }
 
+  // Scans the objects handed off by the main thread.  Called on the
+  // concurrent marking thread.  The thread only reads the heap: the white
+  // objects it finds are reported back and marked on the main thread, as the
+  // write barrier updates mark bits without synchronization.
+  void ProcessConcurrentMarkingInput();
+
+  // Objects handed off to the marking thread are limited to this number, the
+  // rest of the marking deque is processed on the main thread.
+  static const int kMaxConcurrentMarkingInput = 4096;
+  // Number of objects the marking thread takes from its input at a time.
+  static const int kConcurrentMarkingBatchSize = 64;
+
  private:
   int64_t SpaceLeftInOldSpace();
 
@@ -249,14 +274,44 @@ class IncrementalMarking {
 
   INLINE(void ProcessMarkingDeque());
 
-  INLINE(void ProcessMarkingDeque(intptr_t bytes_to_process));
+  // Returns the number of bytes that were scanned.
+  INLINE(intptr_t ProcessMarkingDeque(intptr_t bytes_to_process));
 
   INLINE(void VisitObject(Map* map, HeapObject* obj, int size));
 
+  MarkingThread* marking_thread();
+
+  int ConcurrentMarkingHandOffBudget();
+  bool CanHandOffToMarkingThread(Map* map, HeapObject* obj);
+  void HandOffToMarkingThread(Map* map, HeapObject* obj, int size);
+  void FlushConcurrentMarkingHandOff();
+  bool ScanObjectConcurrently(HeapObject* obj,
+                              List<Object*>* fields,
+                              List<HeapObject*>* found);
+  void CommitConcurrentMarkingResults();
+  void RescanHandedOffObject(HeapObject* obj);
+  bool IsConcurrentMarkingDone();
+
+  // Greys the values of the entries of the weak collections encountered so
+  // far whose keys are marked.  Returns true if any value was greyed.
+  bool ProcessWeakCollections();
+
+  // Number of times the weak collections may be processed before marking is
+  // complete.  Values found only through longer chains of ephemerons are left
+  // to the final pause.
+  static const int kMaxWeakCollectionPasses = 2;
+
+  // Waits for the marking thread to finish its current batch and keeps it
+  // from taking new work.  Objects still waiting in its input are returned to
+  // the marking deque.
+  void PauseConcurrentMarking();
+  void ResumeConcurrentMarking();
+
   Heap* heap_;
 
   State state_;
   bool is_compacting_;
+  bool black_allocation_;
 
   VirtualMemory* marking_deque_memory_;
   bool marking_deque_memory_committed_;
@@ -280,6 +335,23 @@ class IncrementalMarking {
 
   int unscanned_bytes_of_large_object_;
 
+  int weak_collection_passes_;
+
+  // State shared with the concurrent marking thread, guarded by
+  // concurrent_marking_mutex_.  Objects in the input are black; they are
+  // scanned by the marking thread, which reports the white objects they
+  // point to and the objects it failed to scan because they changed layout.
+  Mutex concurrent_marking_mutex_;
+  ConditionVariable concurrent_marking_idle_;
+  List<HeapObject*> concurrent_marking_input_;
+  List<HeapObject*> concurrent_marking_found_;
+  List<HeapObject*> concurrent_marking_rescan_;
+  bool concurrent_marking_paused_;
+  bool concurrent_marking_scanning_;
+
+  // Objects handed off during the current step, only used by the main thread.
+  List<HeapObject*> concurrent_marking_hand_off_;
+
   DISALLOW_IMPLICIT_CONSTRUCTORS(IncrementalMarking);
 };
 
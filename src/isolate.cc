@@ -33,6 +33,7 @@
 #include "ast.h"
 #include "bootstrapper.h"
 #include "codegen.h"
+#include "compaction-thread.h"
 #include "compilation-cache.h"
 #include "cpu-profiler.h"
 #include "debug.h"
@@ -42,17 +43,21 @@
 #include "isolate-inl.h"
 #include "lithium-allocator.h"
 #include "log.h"
+#include "marking-thread.h"
 #include "messages.h"
+#include "parallel-marking-thread.h"
 #include "platform.h"
 #include "regexp-stack.h"
 #include "runtime-profiler.h"
 #include "sampler.h"
+#include "scavenger-thread.h"
 #include "scopeinfo.h"
 #include "serialize.h"
 #include "simulator.h"
 #include "spaces.h"
 #include "stub-cache.h"
 #include "sweeper-thread.h"
+#include "unmapper-thread.h"
 #include "utils/random-number-generator.h"
 #include "version.h"
 #include "vm-state-inl.h"
@@ -142,6 +147,15 @@ int SystemThreadManager::NumberOfParallelSystemThreads(
     return number_of_threads;
   } else if (type == CONCURRENT_SWEEPING) {
     return number_of_threads - 1;
+  } else if (type == PARALLEL_SCAVENGING) {
+    // The main thread takes part in parallel scavenges.
+    return number_of_threads - 1;
+  } else if (type == PARALLEL_MARKING) {
+    // The main thread takes part in parallel marking.
+    return number_of_threads - 1;
+  } else if (type == PARALLEL_COMPACTION) {
+    // The main thread takes part in parallel compaction.
+    return number_of_threads - 1;
   }
   return 1;
 }
@@ -1747,6 +1761,7 @@ Isolate::Isolate()
       compilation_cache_(NULL),
       counters_(NULL),
       code_range_(NULL),
+      heap_cage_(NULL),
       debugger_initialized_(false),
       logger_(NULL),
       stats_table_(NULL),
@@ -1790,6 +1805,11 @@ Isolate::Isolate()
       deferred_handles_head_(NULL),
       optimizing_compiler_thread_(NULL),
       sweeper_thread_(NULL),
+      scavenger_thread_(NULL),
+      parallel_marking_thread_(NULL),
+      compaction_thread_(NULL),
+      marking_thread_(NULL),
+      unmapper_thread_(NULL),
       stress_deopt_count_(0) {
   id_ = NoBarrier_AtomicIncrement(&isolate_counter_, 1);
   TRACE_ISOLATE(constructor);
@@ -1895,6 +1915,43 @@ void Isolate::Deinit() {
       delete[] sweeper_thread_;
     }
 
+    if (FLAG_scavenger_threads > 0) {
+      for (int i = 0; i < FLAG_scavenger_threads; i++) {
+        scavenger_thread_[i]->Stop();
+        delete scavenger_thread_[i];
+      }
+      delete[] scavenger_thread_;
+    }
+
+    if (FLAG_marking_threads > 0) {
+      for (int i = 0; i < FLAG_marking_threads; i++) {
+        parallel_marking_thread_[i]->Stop();
+        delete parallel_marking_thread_[i];
+      }
+      delete[] parallel_marking_thread_;
+    }
+
+    if (FLAG_compaction_threads > 0) {
+      for (int i = 0; i < FLAG_compaction_threads; i++) {
+        compaction_thread_[i]->Stop();
+        delete compaction_thread_[i];
+      }
+      delete[] compaction_thread_;
+    }
+
+    if (FLAG_concurrent_marking) {
+      marking_thread_->Stop();
+      delete marking_thread_;
+    }
+
+    if (unmapper_thread_ != NULL) {
+      // Chunks and backing stores freed during tear down are released on
+      // the main thread.
+      unmapper_thread_->Stop();
+      delete unmapper_thread_;
+      unmapper_thread_ = NULL;
+    }
+
     if (FLAG_hydrogen_stats) GetHStatistics()->Print();
 
     if (FLAG_print_deopt_stress) {
@@ -2039,6 +2096,8 @@ Isolate::~Isolate() {
   memory_allocator_ = NULL;
   delete code_range_;
   code_range_ = NULL;
+  delete heap_cage_;
+  heap_cage_ = NULL;
   delete global_handles_;
   global_handles_ = NULL;
   delete eternal_handles_;
@@ -2157,6 +2216,9 @@ bool Isolate::Init(Deserializer* des) {
 
   memory_allocator_ = new MemoryAllocator(this);
   code_range_ = new CodeRange(this);
+#if V8_TARGET_ARCH_X64
+  if (FLAG_heap_cage) heap_cage_ = new HeapCage(this);
+#endif
 
   // Safe after setting Heap::isolate_, and initializing StackGuard
   heap_.SetStackLimits();
@@ -2338,6 +2400,43 @@ bool Isolate::Init(Deserializer* des) {
     }
   }
 
+  if (FLAG_scavenger_threads > 0) {
+    scavenger_thread_ = new ScavengerThread*[FLAG_scavenger_threads];
+    for (int i = 0; i < FLAG_scavenger_threads; i++) {
+      // Task 0 of a parallel scavenge runs on the main thread.
+      scavenger_thread_[i] = new ScavengerThread(this, i + 1);
+      scavenger_thread_[i]->Start();
+    }
+  }
+
+  if (FLAG_marking_threads > 0) {
+    parallel_marking_thread_ = new ParallelMarkingThread*[FLAG_marking_threads];
+    for (int i = 0; i < FLAG_marking_threads; i++) {
+      // Task 0 of a parallel marking phase runs on the main thread.
+      parallel_marking_thread_[i] = new ParallelMarkingThread(this, i + 1);
+      parallel_marking_thread_[i]->Start();
+    }
+  }
+
+  if (FLAG_compaction_threads > 0) {
+    compaction_thread_ = new CompactionThread*[FLAG_compaction_threads];
+    for (int i = 0; i < FLAG_compaction_threads; i++) {
+      // Task 0 of a parallel compaction phase runs on the main thread.
+      compaction_thread_[i] = new CompactionThread(this, i + 1);
+      compaction_thread_[i]->Start();
+    }
+  }
+
+  if (FLAG_concurrent_marking) {
+    marking_thread_ = new MarkingThread(this);
+    marking_thread_->Start();
+  }
+
+  if (FLAG_concurrent_unmapping || FLAG_concurrent_array_buffer_freeing) {
+    unmapper_thread_ = new UnmapperThread(this);
+    unmapper_thread_->Start();
+  }
+
   initialized_from_snapshot_ = (des != NULL);
 
   return true;
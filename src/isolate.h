@@ -54,6 +54,7 @@ namespace internal {
 class Bootstrapper;
 class CodeGenerator;
 class CodeRange;
+class HeapCage;
 struct CodeStubInterfaceDescriptor;
 class CompilationCache;
 class ContextSlotCache;
@@ -83,10 +84,15 @@ class UnicodeCache;
 class ConsStringIteratorOp;
 class StringTracker;
 class StubCache;
+class MarkingThread;
+class CompactionThread;
+class ParallelMarkingThread;
+class ScavengerThread;
 class SweeperThread;
 class ThreadManager;
 class ThreadState;
 class ThreadVisitor;  // Defined in v8threads.h
+class UnmapperThread;
 template <StateTag Tag> class VMState;
 
 // 'void function pointer', used to roundtrip the
@@ -305,6 +311,11 @@ class SystemThreadManager {
   enum ParallelSystemComponent {
     PARALLEL_SWEEPING,
     CONCURRENT_SWEEPING,
+    PARALLEL_SCAVENGING,
+    PARALLEL_MARKING,
+    PARALLEL_COMPACTION,
+    CONCURRENT_MARKING,
+    CONCURRENT_UNMAPPING,
     PARALLEL_RECOMPILATION
   };
 
@@ -874,6 +885,8 @@ class Isolate {
     return counters_;
   }
   CodeRange* code_range() { return code_range_; }
+  // NULL unless --heap-cage is set on x64.
+  HeapCage* heap_cage() { return heap_cage_; }
   RuntimeProfiler* runtime_profiler() { return runtime_profiler_; }
   CompilationCache* compilation_cache() { return compilation_cache_; }
   Logger* logger() {
@@ -1122,6 +1135,26 @@ class Isolate {
     return sweeper_thread_;
   }
 
+  ScavengerThread** scavenger_threads() {
+    return scavenger_thread_;
+  }
+
+  ParallelMarkingThread** parallel_marking_threads() {
+    return parallel_marking_thread_;
+  }
+
+  CompactionThread** compaction_threads() {
+    return compaction_thread_;
+  }
+
+  MarkingThread* marking_thread() {
+    return marking_thread_;
+  }
+
+  UnmapperThread* unmapper_thread() {
+    return unmapper_thread_;
+  }
+
   int id() const { return static_cast<int>(id_); }
 
   HStatistics* GetHStatistics();
@@ -1264,6 +1297,7 @@ class Isolate {
   CompilationCache* compilation_cache_;
   Counters* counters_;
   CodeRange* code_range_;
+  HeapCage* heap_cage_;
   RecursiveMutex break_access_;
   Atomic32 debugger_initialized_;
   RecursiveMutex debugger_access_;
@@ -1370,15 +1404,25 @@ class Isolate {
   DeferredHandles* deferred_handles_head_;
   OptimizingCompilerThread* optimizing_compiler_thread_;
   SweeperThread** sweeper_thread_;
+  ScavengerThread** scavenger_thread_;
+  ParallelMarkingThread** parallel_marking_thread_;
+  CompactionThread** compaction_thread_;
+  MarkingThread* marking_thread_;
+  UnmapperThread* unmapper_thread_;
 
   // Counts deopt points if deopt_every_n_times is enabled.
   unsigned int stress_deopt_count_;
 
+  friend class CompactionThread;
   friend class ExecutionAccess;
   friend class HandleScopeImplementer;
   friend class IsolateInitializer;
+  friend class MarkingThread;
   friend class OptimizingCompilerThread;
+  friend class ParallelMarkingThread;
+  friend class ScavengerThread;
   friend class SweeperThread;
+  friend class UnmapperThread;
   friend class ThreadManager;
   friend class Simulator;
   friend class StackGuard;
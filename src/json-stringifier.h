@@ -648,10 +648,8 @@ BasicJsonStringifier::Result BasicJsonStringifier::SerializeJSObject(
       if (details.IsDontEnum()) continue;
       Handle<Object> property;
       if (details.type() == FIELD && *map == object->map()) {
-        property = Handle<Object>(
-                       object->RawFastPropertyAt(
-                           map->instance_descriptors()->GetFieldIndex(i)),
-                       isolate_);
+        property = JSObject::TaggedFastPropertyAt(
+            object, map->instance_descriptors()->GetFieldIndex(i));
       } else {
         property = GetProperty(isolate_, object, key);
         if (property.is_null()) return EXCEPTION;
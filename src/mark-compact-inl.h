@@ -49,6 +49,7 @@ void MarkCompactCollector::SetFlags(int flags) {
   reduce_memory_footprint_ = ((flags & Heap::kReduceMemoryFootprintMask) != 0);
   abort_incremental_marking_ =
       ((flags & Heap::kAbortIncrementalMarkingMask) != 0);
+  flush_regexp_code_ = ((flags & Heap::kFlushRegExpCodeMask) != 0);
 }
 
 
@@ -59,6 +60,7 @@ void MarkCompactCollector::MarkObject(HeapObject* obj, MarkBit mark_bit) {
     MemoryChunk::IncrementLiveBytesFromGC(obj->address(), obj->Size());
     ASSERT(IsMarked(obj));
     ASSERT(obj->GetIsolate()->heap()->Contains(obj));
+    if (ephemeron_keys_ != NULL) DiscoverEphemeronKey(obj);
     marking_deque_.PushBlack(obj);
   }
 }
@@ -69,6 +71,7 @@ void MarkCompactCollector::SetMark(HeapObject* obj, MarkBit mark_bit) {
   ASSERT(Marking::MarkBitFrom(obj) == mark_bit);
   mark_bit.Set();
   MemoryChunk::IncrementLiveBytesFromGC(obj->address(), obj->Size());
+  if (ephemeron_keys_ != NULL) DiscoverEphemeronKey(obj);
 }
 
 
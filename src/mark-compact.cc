@@ -28,6 +28,7 @@
 #include "v8.h"
 
 #include "code-stubs.h"
+#include "compaction-thread.h"
 #include "compilation-cache.h"
 #include "cpu-profiler.h"
 #include "deoptimizer.h"
@@ -40,6 +41,8 @@
 #include "mark-compact.h"
 #include "objects-visiting.h"
 #include "objects-visiting-inl.h"
+#include "parallel-marking-thread.h"
+#include "platform/condition-variable.h"
 #include "stub-cache.h"
 #include "sweeper-thread.h"
 
@@ -63,17 +66,25 @@ MarkCompactCollector::MarkCompactCollector() :  // NOLINT
       sweep_precisely_(false),
       reduce_memory_footprint_(false),
       abort_incremental_marking_(false),
+      flush_regexp_code_(false),
       marking_parity_(ODD_MARKING_PARITY),
       compacting_(false),
       was_marked_incrementally_(false),
       sweeping_pending_(false),
       sequential_sweeping_(false),
+      sweeping_queue_next_(0),
       tracer_(NULL),
       migration_slots_buffer_(NULL),
       heap_(NULL),
       code_flusher_(NULL),
       encountered_weak_collections_(NULL),
-      have_code_to_deoptimize_(false) { }
+      scanned_weak_collections_(NULL),
+      have_code_to_deoptimize_(false),
+      ephemeron_keys_(NULL),
+      parallel_marker_(NULL),
+      objects_marked_by_marking_threads_(0),
+      parallel_compactor_(NULL),
+      string_table_pruner_(NULL) { }
 
 #ifdef VERIFY_HEAP
 class VerifyMarkingVisitor: public ObjectVisitor {
@@ -404,7 +415,8 @@ void MarkCompactCollector::CollectGarbage() {
   // Make sure that Prepare() has been called. The individual steps below will
   // update the state as they proceed.
   ASSERT(state_ == PREPARE_GC);
-  ASSERT(encountered_weak_collections_ == Smi::FromInt(0));
+  ASSERT(was_marked_incrementally_ ||
+         encountered_weak_collections_ == Smi::FromInt(0));
 
   heap()->allocation_mementos_found_ = 0;
 
@@ -564,6 +576,7 @@ void MarkCompactCollector::ClearMarkbits() {
 
 void MarkCompactCollector::StartSweeperThreads() {
   sweeping_pending_ = true;
+  NoBarrier_Store(&sweeping_queue_next_, 0);
   for (int i = 0; i < FLAG_sweeper_threads; i++) {
     isolate()->sweeper_threads()[i]->StartSweeping();
   }
@@ -572,10 +585,19 @@ void MarkCompactCollector::StartSweeperThreads() {
 
 void MarkCompactCollector::WaitUntilSweepingCompleted() {
   ASSERT(sweeping_pending_ == true);
+  // Help the sweeper threads with the pages nobody has claimed yet instead of
+  // idling until they are done.
+  Page* p;
+  while ((p = ClaimPageForSweeping()) != NULL) {
+    PagedSpace* space = static_cast<PagedSpace*>(p->owner());
+    space->DecreaseUnsweptFreeBytes(p);
+    SweepConservatively<SWEEP_SEQUENTIALLY>(space, NULL, p);
+  }
   for (int i = 0; i < FLAG_sweeper_threads; i++) {
     isolate()->sweeper_threads()[i]->WaitForSweeperThread();
   }
   sweeping_pending_ = false;
+  sweeping_queue_.Rewind(0);
   StealMemoryFromSweeperThreads(heap()->paged_space(OLD_DATA_SPACE));
   StealMemoryFromSweeperThreads(heap()->paged_space(OLD_POINTER_SPACE));
   heap()->paged_space(OLD_DATA_SPACE)->ResetUnsweptFreeBytes();
@@ -904,6 +926,8 @@ void MarkCompactCollector::Prepare(GCTracer* tracer) {
   // variable.
   tracer_ = tracer;
 
+  objects_marked_by_marking_threads_ = 0;
+
 #ifdef DEBUG
   ASSERT(state_ == IDLE);
   state_ = PREPARE_GC;
@@ -919,6 +943,7 @@ void MarkCompactCollector::Prepare(GCTracer* tracer) {
   // Clear marking bits if incremental marking is aborted.
   if (was_marked_incrementally_ && abort_incremental_marking_) {
     heap()->incremental_marking()->Abort();
+    AbortWeakCollections();
     ClearMarkbits();
     AbortCompaction();
     was_marked_incrementally_ = false;
@@ -1360,11 +1385,14 @@ class MarkCompactMarkingVisitor
   INLINE(static void VisitPointers(Heap* heap, Object** start, Object** end)) {
     // Mark all objects pointed to in [start, end).
     const int kMinRangeForMarkingRecursion = 64;
-    if (end - start >= kMinRangeForMarkingRecursion) {
+    MarkCompactCollector* collector = heap->mark_compact_collector();
+    // Wide objects are left on the marking stack when marking in parallel,
+    // so that the work can be split among the marking threads.
+    if (end - start >= kMinRangeForMarkingRecursion &&
+        !collector->CanMarkInParallel()) {
       if (VisitUnmarkedObjects(heap, start, end)) return;
       // We are close to a stack overflow, so just mark the objects.
     }
-    MarkCompactCollector* collector = heap->mark_compact_collector();
     for (Object** p = start; p < end; p++) {
       MarkObjectByPointer(collector, start, p);
     }
@@ -1449,12 +1477,6 @@ class MarkCompactMarkingVisitor
     JSWeakCollection* weak_collection =
         reinterpret_cast<JSWeakCollection*>(object);
 
-    // Enqueue weak map in linked list of encountered weak maps.
-    if (weak_collection->next() == Smi::FromInt(0)) {
-      weak_collection->set_next(collector->encountered_weak_collections());
-      collector->set_encountered_weak_collections(weak_collection);
-    }
-
     // Skip visiting the backing hash table containing the mappings.
     int object_size = JSWeakCollection::BodyDescriptor::SizeOf(map, object);
     BodyVisitorBase<MarkCompactMarkingVisitor>::IteratePointers(
@@ -1477,6 +1499,12 @@ class MarkCompactMarkingVisitor
     MarkBit table_mark = Marking::MarkBitFrom(table);
     collector->RecordSlot(table_slot, table_slot, table);
     if (!table_mark.Get()) collector->SetMark(table, table_mark);
+    // Enqueue weak map in linked list of encountered weak maps, unless
+    // incremental marking already did so.
+    if (weak_collection->next()->IsUndefined()) {
+      weak_collection->set_next(collector->encountered_weak_collections());
+      collector->set_encountered_weak_collections(weak_collection);
+    }
     // Recording the map slot can be skipped, because maps are not compacted.
     collector->MarkObject(table->map(), Marking::MarkBitFrom(table->map()));
     ASSERT(MarkCompactCollector::IsMarked(table->map()));
@@ -1502,6 +1530,15 @@ class MarkCompactMarkingVisitor
     if (re->TypeTag() != JSRegExp::IRREGEXP) return;
 
     Object* code = re->DataAt(JSRegExp::code_index(is_ascii));
+    if (heap->mark_compact_collector()->flush_regexp_code()) {
+      // Under memory pressure the code is dropped without aging it first.
+      // It is recompiled the next time the RegExp is executed.
+      re->SetDataAt(JSRegExp::code_index(is_ascii),
+                    Smi::FromInt(JSRegExp::kUninitializedValue));
+      re->SetDataAt(JSRegExp::saved_code_index(is_ascii),
+                    Smi::FromInt(JSRegExp::kUninitializedValue));
+      return;
+    }
     if (!code->IsSmi() &&
         HeapObject::cast(code)->map()->instance_type() == CODE_TYPE) {
       // Save a copy that can be reinstated if we need the code again.
@@ -1882,6 +1919,79 @@ class StringTableCleaner : public ObjectVisitor {
 };
 
 
+// Prunes the string table in parallel.  The elements of the table are split
+// into ranges that the tasks claim one at a time.  Dead external strings are
+// only collected by the tasks and finalized on the main thread, since that
+// calls back into the embedder.
+class StringTablePruner {
+ public:
+  StringTablePruner(Heap* heap, StringTable* table, int number_of_tasks)
+      : heap_(heap),
+        table_(table),
+        number_of_tasks_(number_of_tasks),
+        dead_external_strings_(new List<String*>[number_of_tasks]) {
+    elements_ = HeapObject::RawField(table, StringTable::kElementsStartOffset);
+    number_of_elements_ = HeapObject::RawField(
+        table, FixedArray::SizeFor(table->length())) - elements_;
+    NoBarrier_Store(&next_range_, 0);
+    NoBarrier_Store(&elements_removed_, 0);
+  }
+
+  ~StringTablePruner() {
+    delete[] dead_external_strings_;
+  }
+
+  void Run(int task_id) {
+    ASSERT(task_id < number_of_tasks_);
+    List<String*>* dead_external_strings = &dead_external_strings_[task_id];
+    Object* the_hole = heap_->the_hole_value();
+    int removed = 0;
+    while (true) {
+      intptr_t start =
+          (NoBarrier_AtomicIncrement(&next_range_, 1) - 1) * kRangeSize;
+      if (start >= number_of_elements_) break;
+      intptr_t end = Min(start + kRangeSize, number_of_elements_);
+      for (Object** p = elements_ + start; p < elements_ + end; p++) {
+        Object* o = *p;
+        if (!o->IsHeapObject() ||
+            Marking::MarkBitFrom(HeapObject::cast(o)).Get()) {
+          continue;
+        }
+        // No objects have been moved yet, so the map can be accessed.
+        if (o->IsExternalString()) dead_external_strings->Add(String::cast(o));
+        *p = the_hole;
+        removed++;
+      }
+    }
+    NoBarrier_AtomicIncrement(&elements_removed_, removed);
+  }
+
+  // Called on the main thread after all tasks are done.
+  void Finish() {
+    for (int i = 0; i < number_of_tasks_; i++) {
+      List<String*>* dead_external_strings = &dead_external_strings_[i];
+      for (int j = 0; j < dead_external_strings->length(); j++) {
+        heap_->FinalizeExternalString(dead_external_strings->at(j));
+      }
+    }
+    int elements_removed = static_cast<int>(NoBarrier_Load(&elements_removed_));
+    table_->ElementsRemoved(elements_removed);
+  }
+
+ private:
+  static const intptr_t kRangeSize = 4096;
+
+  Heap* heap_;
+  StringTable* table_;
+  int number_of_tasks_;
+  Object** elements_;
+  intptr_t number_of_elements_;
+  List<String*>* dead_external_strings_;
+  volatile AtomicWord next_range_;
+  volatile AtomicWord elements_removed_;
+};
+
+
 // Implementation of WeakObjectRetainer for mark compact GCs. All marked objects
 // are retained.
 class MarkCompactWeakObjectRetainer : public WeakObjectRetainer {
@@ -2158,12 +2268,359 @@ void MarkCompactCollector::MarkWeakObjectToCodeTable() {
 }
 
 
+class ParallelMarker;
+
+
+// One task of a parallel marking phase.  Objects are claimed by setting their
+// mark bit with a compare-and-swap, and are kept on a task-local work list
+// that grows as needed, so a task never overflows and never needs the heap to
+// be rescanned.  Only objects whose bodies are plain tagged fields are traced
+// by the tasks.  Objects that need the special treatment of
+// MarkCompactMarkingVisitor (maps, code, functions, contexts, weak
+// collections, ...) are deferred and visited by the main thread once all
+// tasks are done.  Slots pointing to evacuation candidates are likewise
+// recorded locally and entered into the slots buffers by the main thread.
+class ParallelMarkingTask {
+ public:
+  ParallelMarkingTask(ParallelMarker* marker, Heap* heap, int task_id)
+      : marker_(marker),
+        heap_(heap),
+        task_id_(task_id),
+        compacting_(heap->mark_compact_collector()->is_compacting()),
+        work_(kInitialWorkListCapacity),
+        stealable_work_(kInitialWorkListCapacity),
+        deferred_objects_(kInitialWorkListCapacity),
+        recorded_slots_(kInitialWorkListCapacity),
+        visited_objects_(0) { }
+
+  void Run();
+
+  int task_id() { return task_id_; }
+
+  int visited_objects() { return visited_objects_; }
+
+  List<HeapObject*>* work() { return &work_; }
+
+  // The part of the work list that other tasks may steal from.  Guarded by
+  // the work mutex of the parallel marker.
+  List<HeapObject*>* stealable_work() { return &stealable_work_; }
+
+  List<HeapObject*>* deferred_objects() { return &deferred_objects_; }
+
+  // Pairs of anchor slot and slot.
+  List<Object**>* recorded_slots() { return &recorded_slots_; }
+
+ private:
+  static const int kInitialWorkListCapacity = 256;
+
+  INLINE(static bool TryMark(MarkBit mark_bit)) {
+    volatile Atomic32* cell = reinterpret_cast<volatile Atomic32*>(
+        mark_bit.cell());
+    Atomic32 mask = static_cast<Atomic32>(mark_bit.mask());
+    Atomic32 old_value = NoBarrier_Load(cell);
+    while ((old_value & mask) == 0) {
+      Atomic32 previous_value =
+          NoBarrier_CompareAndSwap(cell, old_value, old_value | mask);
+      if (previous_value == old_value) return true;
+      old_value = previous_value;
+    }
+    return false;
+  }
+
+  INLINE(void MarkObject(HeapObject* object)) {
+    if (TryMark(Marking::MarkBitFrom(object))) {
+      MemoryChunk::IncrementLiveBytesFromGCConcurrently(object->address(),
+                                                        object->Size());
+      work_.Add(object);
+    }
+  }
+
+  INLINE(void VisitPointers(Object** start, Object** end)) {
+    for (Object** p = start; p < end; p++) {
+      Object* o = *p;
+      if (!o->IsHeapObject()) continue;
+      HeapObject* object = HeapObject::cast(o);
+      if (compacting_ &&
+          MarkCompactCollector::IsOnEvacuationCandidate(object)) {
+        recorded_slots_.Add(start);
+        recorded_slots_.Add(p);
+      }
+      MarkObject(object);
+    }
+  }
+
+  void VisitObject(HeapObject* object);
+
+  ParallelMarker* marker_;
+  Heap* heap_;
+  int task_id_;
+  bool compacting_;
+  List<HeapObject*> work_;
+  List<HeapObject*> stealable_work_;
+  List<HeapObject*> deferred_objects_;
+  List<Object**> recorded_slots_;
+  int visited_objects_;
+};
+
+
+// Shared state of a parallel marking phase.  Busy tasks make part of their
+// work list available to idle tasks, which steal it from them.
+class ParallelMarker {
+ public:
+  ParallelMarker(Heap* heap, int number_of_tasks)
+      : number_of_tasks_(number_of_tasks),
+        idle_tasks_(0),
+        done_(false) {
+    NoBarrier_Store(&idle_tasks_hint_, 0);
+    tasks_ = NewArray<ParallelMarkingTask*>(number_of_tasks);
+    for (int i = 0; i < number_of_tasks; i++) {
+      tasks_[i] = new ParallelMarkingTask(this, heap, i);
+    }
+  }
+
+  ~ParallelMarker() {
+    for (int i = 0; i < number_of_tasks_; i++) delete tasks_[i];
+    DeleteArray(tasks_);
+  }
+
+  int number_of_tasks() { return number_of_tasks_; }
+  ParallelMarkingTask* task(int task_id) { return tasks_[task_id]; }
+
+  void PrepareForPhase() {
+    idle_tasks_ = 0;
+    done_ = false;
+    NoBarrier_Store(&idle_tasks_hint_, 0);
+  }
+
+  // Makes half of a task's work list stealable if other tasks are waiting
+  // for work.
+  void ShareWork(ParallelMarkingTask* task) {
+    List<HeapObject*>* work = task->work();
+    if (work->length() < kMinWorkToShare ||
+        NoBarrier_Load(&idle_tasks_hint_) == 0) {
+      return;
+    }
+    LockGuard<Mutex> lock_guard(&work_mutex_);
+    List<HeapObject*>* stealable_work = task->stealable_work();
+    int share = work->length() / 2;
+    for (int i = 0; i < share; i++) stealable_work->Add(work->RemoveLast());
+    work_available_.NotifyAll();
+  }
+
+  // Blocks until work can be stolen from one of the tasks and moves it to the
+  // work list of the given task.  Returns false when all tasks ran out of
+  // work, i.e. the phase is done.
+  bool WaitForWork(ParallelMarkingTask* task) {
+    LockGuard<Mutex> lock_guard(&work_mutex_);
+    idle_tasks_++;
+    while (true) {
+      // Try the other tasks first, starting with the next one.
+      for (int i = 1; i <= number_of_tasks_; i++) {
+        ParallelMarkingTask* victim =
+            tasks_[(task->task_id() + i) % number_of_tasks_];
+        List<HeapObject*>* stealable_work = victim->stealable_work();
+        if (stealable_work->is_empty()) continue;
+        int take = Min(stealable_work->length(), kMaxWorkToSteal);
+        for (int j = 0; j < take; j++) {
+          task->work()->Add(stealable_work->RemoveLast());
+        }
+        idle_tasks_--;
+        NoBarrier_Store(&idle_tasks_hint_, idle_tasks_);
+        return true;
+      }
+      if (done_) return false;
+      if (idle_tasks_ == number_of_tasks_) {
+        done_ = true;
+        work_available_.NotifyAll();
+        return false;
+      }
+      NoBarrier_Store(&idle_tasks_hint_, idle_tasks_);
+      work_available_.Wait(&work_mutex_);
+    }
+  }
+
+ private:
+  static const int kMinWorkToShare = 64;
+  static const int kMaxWorkToSteal = 256;
+
+  int number_of_tasks_;
+  ParallelMarkingTask** tasks_;
+
+  Mutex work_mutex_;
+  ConditionVariable work_available_;
+  int idle_tasks_;
+  // Copy of idle_tasks_ that busy tasks read without taking the lock.
+  volatile AtomicWord idle_tasks_hint_;
+  bool done_;
+};
+
+
+void ParallelMarkingTask::Run() {
+  do {
+    while (!work_.is_empty()) {
+      VisitObject(work_.RemoveLast());
+      visited_objects_++;
+      marker_->ShareWork(this);
+    }
+  } while (marker_->WaitForWork(this));
+}
+
+
+void ParallelMarkingTask::VisitObject(HeapObject* object) {
+  Map* map = object->map();
+  MarkObject(map);
+  int visitor_id = map->visitor_id();
+  switch (visitor_id) {
+    case StaticVisitorBase::kVisitSeqOneByteString:
+    case StaticVisitorBase::kVisitSeqTwoByteString:
+    case StaticVisitorBase::kVisitByteArray:
+    case StaticVisitorBase::kVisitFreeSpace:
+    case StaticVisitorBase::kVisitFixedDoubleArray:
+      return;
+    case StaticVisitorBase::kVisitShortcutCandidate:
+    case StaticVisitorBase::kVisitConsString:
+      // Unlike the main thread, tasks do not short-circuit cons strings.
+      VisitPointers(
+          HeapObject::RawField(object,
+                               ConsString::BodyDescriptor::kStartOffset),
+          HeapObject::RawField(object,
+                               ConsString::BodyDescriptor::kEndOffset));
+      return;
+    case StaticVisitorBase::kVisitSlicedString:
+      VisitPointers(
+          HeapObject::RawField(object,
+                               SlicedString::BodyDescriptor::kStartOffset),
+          HeapObject::RawField(object,
+                               SlicedString::BodyDescriptor::kEndOffset));
+      return;
+    case StaticVisitorBase::kVisitSymbol:
+      VisitPointers(
+          HeapObject::RawField(object, Symbol::BodyDescriptor::kStartOffset),
+          HeapObject::RawField(object, Symbol::BodyDescriptor::kEndOffset));
+      return;
+    case StaticVisitorBase::kVisitOddball:
+      VisitPointers(
+          HeapObject::RawField(object, Oddball::BodyDescriptor::kStartOffset),
+          HeapObject::RawField(object, Oddball::BodyDescriptor::kEndOffset));
+      return;
+    case StaticVisitorBase::kVisitCell:
+      VisitPointers(
+          HeapObject::RawField(object, Cell::BodyDescriptor::kStartOffset),
+          HeapObject::RawField(object, Cell::BodyDescriptor::kEndOffset));
+      return;
+    case StaticVisitorBase::kVisitFixedArray:
+      VisitPointers(
+          HeapObject::RawField(object, FixedArray::kHeaderSize),
+          HeapObject::RawField(object, object->SizeFromMap(map)));
+      return;
+    default:
+      break;
+  }
+  if (visitor_id >= StaticVisitorBase::kVisitDataObject &&
+      visitor_id <= StaticVisitorBase::kVisitDataObjectGeneric) {
+    return;
+  }
+  if (visitor_id >= StaticVisitorBase::kVisitJSObject &&
+      visitor_id <= StaticVisitorBase::kVisitJSObjectGeneric) {
+    VisitPointers(
+        HeapObject::RawField(object, JSObject::kPropertiesOffset),
+        HeapObject::RawField(object, map->instance_size()));
+    return;
+  }
+  if (visitor_id >= StaticVisitorBase::kVisitStruct &&
+      visitor_id <= StaticVisitorBase::kVisitStructGeneric) {
+    VisitPointers(
+        HeapObject::RawField(object, HeapObject::kHeaderSize),
+        HeapObject::RawField(object, map->instance_size()));
+    return;
+  }
+  deferred_objects_.Add(object);
+}
+
+
+bool MarkCompactCollector::CanMarkInParallel() {
+  // Object statistics are gathered by the marking visitor of the main thread.
+  // Pending ephemerons are discovered when the main thread marks their keys.
+  return FLAG_parallel_marking && !FLAG_track_gc_object_stats &&
+         ephemeron_keys_ == NULL;
+}
+
+
+void MarkCompactCollector::RunParallelMarkingTask(int task_id) {
+  ASSERT(parallel_marker_ != NULL);
+  parallel_marker_->task(task_id)->Run();
+}
+
+
+// Marks the objects reachable from the marking stack with the help of the
+// parallel marking threads.  The objects on the marking stack are split among
+// the tasks.  Objects deferred by the tasks are visited by the main thread,
+// which pushes their children on the marking stack again.  Phases are run
+// until too few objects are left on the marking stack to make another phase
+// worthwhile.
+void MarkCompactCollector::EmptyMarkingDequeInParallel() {
+  int number_of_tasks = FLAG_marking_threads + 1;
+  ParallelMarker marker(heap(), number_of_tasks);
+  parallel_marker_ = &marker;
+
+  ParallelMarkingThread** threads = isolate()->parallel_marking_threads();
+  do {
+    int task_id = 0;
+    while (!marking_deque_.IsEmpty()) {
+      marker.task(task_id)->work()->Add(marking_deque_.Pop());
+      task_id = (task_id + 1) % number_of_tasks;
+    }
+
+    marker.PrepareForPhase();
+    for (int i = 0; i < FLAG_marking_threads; i++) {
+      threads[i]->StartMarking();
+    }
+    RunParallelMarkingTask(0);
+    for (int i = 0; i < FLAG_marking_threads; i++) {
+      threads[i]->WaitForMarkingThread();
+    }
+
+    for (int i = 0; i < number_of_tasks; i++) {
+      ParallelMarkingTask* task = marker.task(i);
+      List<Object**>* recorded_slots = task->recorded_slots();
+      for (int j = 0; j < recorded_slots->length(); j += 2) {
+        Object** anchor_slot = recorded_slots->at(j);
+        Object** slot = recorded_slots->at(j + 1);
+        RecordSlot(anchor_slot, slot, *slot);
+      }
+      recorded_slots->Rewind(0);
+
+      List<HeapObject*>* deferred_objects = task->deferred_objects();
+      for (int j = 0; j < deferred_objects->length(); j++) {
+        HeapObject* object = deferred_objects->at(j);
+        Map* map = object->map();
+        MarkBit map_mark = Marking::MarkBitFrom(map);
+        MarkObject(map, map_mark);
+        MarkCompactMarkingVisitor::IterateBody(map, object);
+      }
+      deferred_objects->Rewind(0);
+    }
+  } while (marking_deque_.length() >= kMinObjectsForParallelMarking);
+
+  for (int i = 1; i < number_of_tasks; i++) {
+    objects_marked_by_marking_threads_ += marker.task(i)->visited_objects();
+  }
+  parallel_marker_ = NULL;
+}
+
+
 // Mark all objects reachable from the objects on the marking stack.
 // Before: the marking stack contains zero or more heap object pointers.
 // After: the marking stack is empty, and all objects reachable from the
 // marking stack have been marked, or are overflowed in the heap.
 void MarkCompactCollector::EmptyMarkingDeque() {
+  bool parallel_marking = CanMarkInParallel();
   while (!marking_deque_.IsEmpty()) {
+    if (parallel_marking &&
+        marking_deque_.length() >= kMinObjectsForParallelMarking) {
+      EmptyMarkingDequeInParallel();
+      continue;
+    }
     HeapObject* object = marking_deque_.Pop();
     ASSERT(object->IsHeapObject());
     ASSERT(heap()->Contains(object));
@@ -2252,8 +2709,10 @@ void MarkCompactCollector::ProcessEphemeralMarking(ObjectVisitor* visitor) {
         visitor, &IsUnmarkedHeapObjectWithHeap);
     MarkImplicitRefGroups();
     ProcessWeakCollections();
-    work_to_do = !marking_deque_.IsEmpty();
-    ProcessMarkingDeque();
+    DiscoverMarkedEphemeronKeys();
+    work_to_do = !marking_deque_.IsEmpty() ||
+                 !discovered_ephemerons_.is_empty();
+    ProcessDiscoveredEphemerons();
   }
 }
 
@@ -2397,14 +2856,35 @@ void MarkCompactCollector::AfterMarking() {
   // table is marked.
   StringTable* string_table = heap()->string_table();
   StringTableCleaner v(heap());
-  string_table->IterateElements(&v);
-  string_table->ElementsRemoved(v.PointersRemoved());
-  heap()->external_string_table_.Iterate(&v);
-  heap()->external_string_table_.CleanUp();
-
-  // Process the weak references.
   MarkCompactWeakObjectRetainer mark_compact_object_retainer;
-  heap()->ProcessWeakReferences(&mark_compact_object_retainer);
+  if (FLAG_parallel_weak_processing) {
+    // The compaction threads prune the string table while the main thread
+    // processes the external strings and the weak lists, which do not touch
+    // the string table.  Then the main thread helps with the pruning.
+    StringTablePruner pruner(heap(), string_table, FLAG_compaction_threads + 1);
+    string_table_pruner_ = &pruner;
+    CompactionThread** threads = isolate()->compaction_threads();
+    for (int i = 0; i < FLAG_compaction_threads; i++) {
+      threads[i]->StartCompaction();
+    }
+    heap()->external_string_table_.Iterate(&v);
+    heap()->external_string_table_.CleanUp();
+    heap()->ProcessWeakReferences(&mark_compact_object_retainer);
+    pruner.Run(0);
+    for (int i = 0; i < FLAG_compaction_threads; i++) {
+      threads[i]->WaitForCompactionThread();
+    }
+    string_table_pruner_ = NULL;
+    pruner.Finish();
+  } else {
+    string_table->IterateElements(&v);
+    string_table->ElementsRemoved(v.PointersRemoved());
+    heap()->external_string_table_.Iterate(&v);
+    heap()->external_string_table_.CleanUp();
+
+    // Process the weak references.
+    heap()->ProcessWeakReferences(&mark_compact_object_retainer);
+  }
 
   // Remove object groups after marking phase.
   heap()->isolate()->global_handles()->RemoveObjectGroups();
@@ -2688,29 +3168,98 @@ void MarkCompactCollector::ClearNonLiveDependentCode(DependentCode* entries) {
 
 void MarkCompactCollector::ProcessWeakCollections() {
   GCTracer::Scope gc_scope(tracer_, GCTracer::Scope::MC_WEAKCOLLECTION_PROCESS);
+  // Weak collections are prepended to the list, so the ones that were not
+  // scanned yet come first.
   Object* weak_collection_obj = encountered_weak_collections();
-  while (weak_collection_obj != Smi::FromInt(0)) {
+  while (weak_collection_obj != scanned_weak_collections_) {
     ASSERT(MarkCompactCollector::IsMarked(
         HeapObject::cast(weak_collection_obj)));
     JSWeakCollection* weak_collection =
         reinterpret_cast<JSWeakCollection*>(weak_collection_obj);
     ObjectHashTable* table = ObjectHashTable::cast(weak_collection->table());
-    Object** anchor = reinterpret_cast<Object**>(table->address());
     for (int i = 0; i < table->Capacity(); i++) {
-      if (MarkCompactCollector::IsMarked(HeapObject::cast(table->KeyAt(i)))) {
-        Object** key_slot =
-            HeapObject::RawField(table, FixedArray::OffsetOfElementAt(
-                ObjectHashTable::EntryToIndex(i)));
-        RecordSlot(anchor, key_slot, *key_slot);
-        Object** value_slot =
-            HeapObject::RawField(table, FixedArray::OffsetOfElementAt(
-                ObjectHashTable::EntryToValueIndex(i)));
-        MarkCompactMarkingVisitor::MarkObjectByPointer(
-            this, anchor, value_slot);
+      HeapObject* key = HeapObject::cast(table->KeyAt(i));
+      Object** value_slot =
+          HeapObject::RawField(table, FixedArray::OffsetOfElementAt(
+              ObjectHashTable::EntryToValueIndex(i)));
+      Object* value = *value_slot;
+      if (!value->IsHeapObject()) continue;
+      MarkBit value_mark = Marking::MarkBitFrom(HeapObject::cast(value));
+      if (value_mark.Get()) continue;
+      if (MarkCompactCollector::IsMarked(key)) {
+        MarkObject(HeapObject::cast(value), value_mark);
+      } else {
+        AddEphemeron(key, value_slot);
       }
     }
     weak_collection_obj = weak_collection->next();
   }
+  scanned_weak_collections_ = encountered_weak_collections();
+}
+
+
+static bool EphemeronKeysMatch(void* key1, void* key2) {
+  return key1 == key2;
+}
+
+
+void MarkCompactCollector::AddEphemeron(HeapObject* key, Object** value_slot) {
+  if (ephemeron_keys_ == NULL) {
+    ephemeron_keys_ = new HashMap(&EphemeronKeysMatch);
+  }
+  HashMap::Entry* entry =
+      ephemeron_keys_->Lookup(key, ComputePointerHash(key), true);
+  Ephemeron ephemeron;
+  ephemeron.value_slot = value_slot;
+  ephemeron.next = static_cast<int>(reinterpret_cast<intptr_t>(entry->value));
+  ephemeron.next--;
+  ephemerons_.Add(ephemeron);
+  entry->value = reinterpret_cast<void*>(
+      static_cast<intptr_t>(ephemerons_.length()));
+}
+
+
+void MarkCompactCollector::DiscoverEphemeronKey(HeapObject* object) {
+  HashMap::Entry* entry =
+      ephemeron_keys_->Lookup(object, ComputePointerHash(object), false);
+  if (entry == NULL || entry->value == NULL) return;
+  int first = static_cast<int>(reinterpret_cast<intptr_t>(entry->value)) - 1;
+  discovered_ephemerons_.Add(first);
+  entry->value = NULL;
+}
+
+
+bool MarkCompactCollector::DiscoverMarkedEphemeronKeys() {
+  if (ephemeron_keys_ == NULL) return false;
+  bool found = false;
+  for (HashMap::Entry* entry = ephemeron_keys_->Start();
+       entry != NULL;
+       entry = ephemeron_keys_->Next(entry)) {
+    if (entry->value == NULL) continue;
+    if (!IsMarked(reinterpret_cast<HeapObject*>(entry->key))) continue;
+    int first = static_cast<int>(reinterpret_cast<intptr_t>(entry->value)) - 1;
+    discovered_ephemerons_.Add(first);
+    entry->value = NULL;
+    found = true;
+  }
+  return found;
+}
+
+
+void MarkCompactCollector::ProcessDiscoveredEphemerons() {
+  ProcessMarkingDeque();
+  while (!discovered_ephemerons_.is_empty()) {
+    int index = discovered_ephemerons_.RemoveLast();
+    while (index >= 0) {
+      Ephemeron ephemeron = ephemerons_[index];
+      Object* value = *ephemeron.value_slot;
+      ASSERT(value->IsHeapObject());
+      HeapObject* heap_value = HeapObject::cast(value);
+      MarkObject(heap_value, Marking::MarkBitFrom(heap_value));
+      index = ephemeron.next;
+    }
+    ProcessMarkingDeque();
+  }
 }
 
 
@@ -2723,13 +3272,42 @@ void MarkCompactCollector::ClearWeakCollections() {
     JSWeakCollection* weak_collection =
         reinterpret_cast<JSWeakCollection*>(weak_collection_obj);
     ObjectHashTable* table = ObjectHashTable::cast(weak_collection->table());
+    Object** anchor = reinterpret_cast<Object**>(table->address());
     for (int i = 0; i < table->Capacity(); i++) {
       if (!MarkCompactCollector::IsMarked(HeapObject::cast(table->KeyAt(i)))) {
         table->RemoveEntry(i);
+      } else {
+        Object** key_slot =
+            HeapObject::RawField(table, FixedArray::OffsetOfElementAt(
+                ObjectHashTable::EntryToIndex(i)));
+        RecordSlot(anchor, key_slot, *key_slot);
+        Object** value_slot =
+            HeapObject::RawField(table, FixedArray::OffsetOfElementAt(
+                ObjectHashTable::EntryToValueIndex(i)));
+        if ((*value_slot)->IsHeapObject()) {
+          RecordSlot(anchor, value_slot, *value_slot);
+        }
       }
     }
     weak_collection_obj = weak_collection->next();
-    weak_collection->set_next(Smi::FromInt(0));
+    weak_collection->set_next(heap()->undefined_value());
+  }
+  set_encountered_weak_collections(Smi::FromInt(0));
+  scanned_weak_collections_ = Smi::FromInt(0);
+  delete ephemeron_keys_;
+  ephemeron_keys_ = NULL;
+  ephemerons_.Clear();
+  ASSERT(discovered_ephemerons_.is_empty());
+}
+
+
+void MarkCompactCollector::AbortWeakCollections() {
+  Object* weak_collection_obj = encountered_weak_collections();
+  while (weak_collection_obj != Smi::FromInt(0)) {
+    JSWeakCollection* weak_collection =
+        reinterpret_cast<JSWeakCollection*>(weak_collection_obj);
+    weak_collection_obj = weak_collection->next();
+    weak_collection->set_next(heap()->undefined_value());
   }
   set_encountered_weak_collections(Smi::FromInt(0));
 }
@@ -2757,23 +3335,47 @@ void MarkCompactCollector::MigrateObject(Address dst,
   if (heap_profiler->is_profiling()) {
     heap_profiler->ObjectMoveEvent(src, dst, size);
   }
+  if (dest == CODE_SPACE) {
+    PROFILE(isolate(), CodeMoveEvent(src, dst));
+  }
+  MigrateObjectBody(dst, src, size, dest, &migration_slots_buffer_, NULL);
+}
+
+
+void MarkCompactCollector::MigrateObjectBody(
+    Address dst,
+    Address src,
+    int size,
+    AllocationSpace dest,
+    SlotsBuffer** migration_slots_buffer,
+    List<Address>* store_buffer_entries) {
   ASSERT(heap()->AllowedToBeMigrated(HeapObject::FromAddress(src), dest));
   ASSERT(dest != LO_SPACE && size <= Page::kMaxNonCodeHeapObjectSize);
   if (dest == OLD_POINTER_SPACE) {
     Address src_slot = src;
     Address dst_slot = dst;
     ASSERT(IsAligned(size, kPointerSize));
+    // Unboxed double fields are copied without being looked at.
+    Map* map = HeapObject::FromAddress(src)->map();
+    bool has_unboxed_doubles = map->HasUnboxedDoubleFields();
 
     for (int remaining = size / kPointerSize; remaining > 0; remaining--) {
       Object* value = Memory::Object_at(src_slot);
 
       Memory::Object_at(dst_slot) = value;
 
-      if (heap_->InNewSpace(value)) {
-        heap_->store_buffer()->Mark(dst_slot);
+      if (has_unboxed_doubles &&
+          map->IsUnboxedDoubleFieldOffset(static_cast<int>(src_slot - src))) {
+        // Nothing to record.
+      } else if (heap_->InNewSpace(value)) {
+        if (store_buffer_entries == NULL) {
+          heap_->store_buffer()->Mark(dst_slot);
+        } else {
+          store_buffer_entries->Add(dst_slot);
+        }
       } else if (value->IsHeapObject() && IsOnEvacuationCandidate(value)) {
         SlotsBuffer::AddTo(&slots_buffer_allocator_,
-                           &migration_slots_buffer_,
+                           migration_slots_buffer,
                            reinterpret_cast<Object**>(dst_slot),
                            SlotsBuffer::IGNORE_OVERFLOW);
       }
@@ -2788,17 +3390,16 @@ void MarkCompactCollector::MigrateObject(Address dst,
 
       if (Page::FromAddress(code_entry)->IsEvacuationCandidate()) {
         SlotsBuffer::AddTo(&slots_buffer_allocator_,
-                           &migration_slots_buffer_,
+                           migration_slots_buffer,
                            SlotsBuffer::CODE_ENTRY_SLOT,
                            code_entry_slot,
                            SlotsBuffer::IGNORE_OVERFLOW);
       }
     }
   } else if (dest == CODE_SPACE) {
-    PROFILE(isolate(), CodeMoveEvent(src, dst));
     heap()->MoveBlock(dst, src, size);
     SlotsBuffer::AddTo(&slots_buffer_allocator_,
-                       &migration_slots_buffer_,
+                       migration_slots_buffer,
                        SlotsBuffer::RELOCATED_CODE_OBJECT,
                        dst,
                        SlotsBuffer::IGNORE_OVERFLOW);
@@ -3065,6 +3666,509 @@ void MarkCompactCollector::EvacuatePages() {
 }
 
 
+// A linear allocation buffer that a parallel compaction task carves out of a
+// space, so that most objects can be moved without synchronizing with other
+// tasks.
+class CompactionAllocationBuffer {
+ public:
+  CompactionAllocationBuffer() : top_(NULL), limit_(NULL) { }
+
+  Address top() { return top_; }
+  Address limit() { return limit_; }
+
+  void Reset(Address top, Address limit) {
+    top_ = top;
+    limit_ = limit;
+  }
+
+  // Returns NULL if the buffer is exhausted.
+  Address Allocate(int size_in_bytes) {
+    if (limit_ - top_ < size_in_bytes) return NULL;
+    Address result = top_;
+    top_ += size_in_bytes;
+    return result;
+  }
+
+  static const int kSize = 16 * KB;
+  // Larger objects are allocated directly in the space.
+  static const int kMaxObjectSize = kSize / 4;
+
+ private:
+  Address top_;
+  Address limit_;
+};
+
+
+class ParallelCompactor;
+
+
+// One task of a parallel compaction.  During evacuation a task claims whole
+// candidate pages and moves their live objects into allocation buffers of its
+// own.  The slots of the copies that have to be recorded go to the task's own
+// slots buffer and store buffer entries, which the main thread takes over
+// when all tasks are done.  During slot updating a task claims slots buffers
+// and updates the slots recorded in them.
+class ParallelCompactionTask {
+ public:
+  ParallelCompactionTask(ParallelCompactor* compactor,
+                         MarkCompactCollector* collector)
+      : compactor_(compactor),
+        collector_(collector),
+        heap_(collector->heap()),
+        migration_slots_buffer_(NULL) { }
+
+  ~ParallelCompactionTask() {
+    collector_->slots_buffer_allocator_.DeallocateChain(
+        &migration_slots_buffer_);
+  }
+
+  void Run();
+
+  // Gives the unused parts of the allocation buffers back to their spaces.
+  // Must not be called while other tasks are running.
+  void Finish() {
+    CloseAllocationBuffer(heap_->old_pointer_space());
+    CloseAllocationBuffer(heap_->old_data_space());
+  }
+
+  SlotsBuffer* migration_slots_buffer() { return migration_slots_buffer_; }
+  List<Address>* store_buffer_entries() { return &store_buffer_entries_; }
+
+ private:
+  void EvacuatePage(Page* p);
+  Address AllocateRaw(PagedSpace* space, int size_in_bytes);
+  void CloseAllocationBuffer(PagedSpace* space);
+  CompactionAllocationBuffer* allocation_buffer(PagedSpace* space) {
+    switch (space->identity()) {
+      case OLD_POINTER_SPACE: return &old_pointer_space_buffer_;
+      case OLD_DATA_SPACE: return &old_data_space_buffer_;
+      default: UNREACHABLE();
+    }
+    return NULL;
+  }
+
+  ParallelCompactor* compactor_;
+  MarkCompactCollector* collector_;
+  Heap* heap_;
+  SlotsBuffer* migration_slots_buffer_;
+  List<Address> store_buffer_entries_;
+  CompactionAllocationBuffer old_pointer_space_buffer_;
+  CompactionAllocationBuffer old_data_space_buffer_;
+};
+
+
+// Shared state of a parallel compaction: the tasks and the pages or slots
+// buffers that are still to be processed in the current phase.
+class ParallelCompactor {
+ public:
+  enum Phase {
+    EVACUATE_PAGES,
+    UPDATE_SLOTS
+  };
+
+  ParallelCompactor(MarkCompactCollector* collector, int number_of_tasks)
+      : number_of_tasks_(number_of_tasks),
+        phase_(EVACUATE_PAGES),
+        pages_(NULL),
+        slots_buffers_(NULL),
+        code_slots_filtering_required_(false),
+        evacuation_aborted_(false) {
+    NoBarrier_Store(&next_item_, 0);
+    tasks_ = NewArray<ParallelCompactionTask*>(number_of_tasks);
+    for (int i = 0; i < number_of_tasks; i++) {
+      tasks_[i] = new ParallelCompactionTask(this, collector);
+    }
+  }
+
+  ~ParallelCompactor() {
+    for (int i = 0; i < number_of_tasks_; i++) delete tasks_[i];
+    DeleteArray(tasks_);
+  }
+
+  int number_of_tasks() { return number_of_tasks_; }
+  ParallelCompactionTask* task(int task_id) { return tasks_[task_id]; }
+
+  Phase phase() { return phase_; }
+
+  Mutex* allocation_mutex() { return &allocation_mutex_; }
+
+  bool code_slots_filtering_required() {
+    return code_slots_filtering_required_;
+  }
+
+  void PrepareForEvacuation(List<Page*>* pages) {
+    phase_ = EVACUATE_PAGES;
+    pages_ = pages;
+    evacuation_aborted_ = false;
+    NoBarrier_Store(&next_item_, 0);
+  }
+
+  void PrepareForSlotsUpdating(List<SlotsBuffer*>* slots_buffers,
+                               bool code_slots_filtering_required) {
+    phase_ = UPDATE_SLOTS;
+    slots_buffers_ = slots_buffers;
+    code_slots_filtering_required_ = code_slots_filtering_required;
+    NoBarrier_Store(&next_item_, 0);
+  }
+
+  // Hands out the next candidate page to evacuate.  Returns NULL once all
+  // pages have been claimed or evacuation was given up.
+  Page* ClaimPage() {
+    while (true) {
+      int index = static_cast<int>(NoBarrier_AtomicIncrement(&next_item_, 1));
+      if (index > pages_->length()) return NULL;
+      Page* p = pages_->at(index - 1);
+      if (!p->IsEvacuationCandidate()) continue;
+      LockGuard<Mutex> lock_guard(&allocation_mutex_);
+      if (evacuation_aborted_) return NULL;
+      // During compaction we might have to request a new page.  Without room
+      // for expansion evacuation is not guaranteed to succeed, so the
+      // remaining pages are abandoned.
+      if (!static_cast<PagedSpace*>(p->owner())->CanExpand()) {
+        evacuation_aborted_ = true;
+        return NULL;
+      }
+      return p;
+    }
+  }
+
+  // Hands out the next slots buffer to update.  Returns NULL once all
+  // buffers have been claimed.
+  SlotsBuffer* ClaimSlotsBuffer() {
+    int index = static_cast<int>(NoBarrier_AtomicIncrement(&next_item_, 1));
+    if (index > slots_buffers_->length()) return NULL;
+    return slots_buffers_->at(index - 1);
+  }
+
+ private:
+  int number_of_tasks_;
+  ParallelCompactionTask** tasks_;
+  Phase phase_;
+  List<Page*>* pages_;
+  List<SlotsBuffer*>* slots_buffers_;
+  bool code_slots_filtering_required_;
+  volatile AtomicWord next_item_;
+  Mutex allocation_mutex_;
+  // Guarded by allocation_mutex_.
+  bool evacuation_aborted_;
+};
+
+
+void ParallelCompactionTask::Run() {
+  if (compactor_->phase() == ParallelCompactor::EVACUATE_PAGES) {
+    Page* p;
+    while ((p = compactor_->ClaimPage()) != NULL) {
+      EvacuatePage(p);
+    }
+  } else {
+    bool code_slots_filtering_required =
+        compactor_->code_slots_filtering_required();
+    SlotsBuffer* buffer;
+    while ((buffer = compactor_->ClaimSlotsBuffer()) != NULL) {
+      if (code_slots_filtering_required) {
+        buffer->UpdateSlotsWithFilter(heap_);
+      } else {
+        buffer->UpdateSlots(heap_);
+      }
+    }
+  }
+}
+
+
+void ParallelCompactionTask::EvacuatePage(Page* p) {
+  PagedSpace* space = static_cast<PagedSpace*>(p->owner());
+  ASSERT(p->IsEvacuationCandidate() && !p->WasSwept());
+  p->MarkSweptPrecisely();
+
+  int offsets[16];
+
+  for (MarkBitCellIterator it(p); !it.Done(); it.Advance()) {
+    Address cell_base = it.CurrentCellBase();
+    MarkBit::CellType* cell = it.CurrentCell();
+
+    if (*cell == 0) continue;
+
+    int live_objects = MarkWordToObjectStarts(*cell, offsets);
+    for (int i = 0; i < live_objects; i++) {
+      Address object_addr = cell_base + offsets[i] * kPointerSize;
+      HeapObject* object = HeapObject::FromAddress(object_addr);
+      ASSERT(Marking::IsBlack(Marking::MarkBitFrom(object)));
+
+      int size = object->Size();
+
+      Address target = AllocateRaw(space, size);
+      if (target == NULL) {
+        // OS refused to give us memory.
+        V8::FatalProcessOutOfMemory("Evacuation");
+        return;
+      }
+
+      collector_->MigrateObjectBody(target,
+                                    object_addr,
+                                    size,
+                                    space->identity(),
+                                    &migration_slots_buffer_,
+                                    &store_buffer_entries_);
+      ASSERT(object->map_word().IsForwardingAddress());
+    }
+
+    // Clear marking bits for current cell.
+    *cell = 0;
+  }
+  p->ResetLiveBytes();
+}
+
+
+Address ParallelCompactionTask::AllocateRaw(PagedSpace* space,
+                                            int size_in_bytes) {
+  // Code objects are allocated directly, which keeps the skip lists of code
+  // pages up to date.
+  bool use_allocation_buffer = space->identity() != CODE_SPACE &&
+      size_in_bytes <= CompactionAllocationBuffer::kMaxObjectSize;
+  if (use_allocation_buffer) {
+    Address result = allocation_buffer(space)->Allocate(size_in_bytes);
+    if (result != NULL) return result;
+  }
+
+  LockGuard<Mutex> lock_guard(compactor_->allocation_mutex());
+  MaybeObject* maybe_result;
+  if (use_allocation_buffer) {
+    CloseAllocationBuffer(space);
+    maybe_result = space->AllocateRaw(CompactionAllocationBuffer::kSize,
+                                      PagedSpace::MOVE_OBJECT);
+    Object* buffer;
+    if (maybe_result->ToObject(&buffer)) {
+      Address start = HeapObject::cast(buffer)->address();
+      allocation_buffer(space)->Reset(
+          start, start + CompactionAllocationBuffer::kSize);
+      return allocation_buffer(space)->Allocate(size_in_bytes);
+    }
+  }
+  maybe_result = space->AllocateRaw(size_in_bytes, PagedSpace::MOVE_OBJECT);
+  Object* object;
+  if (!maybe_result->ToObject(&object)) return NULL;
+  return HeapObject::cast(object)->address();
+}
+
+
+void ParallelCompactionTask::CloseAllocationBuffer(PagedSpace* space) {
+  CompactionAllocationBuffer* buffer = allocation_buffer(space);
+  int size = static_cast<int>(buffer->limit() - buffer->top());
+  if (size > 0) space->Free(buffer->top(), size);
+  buffer->Reset(NULL, NULL);
+}
+
+
+bool MarkCompactCollector::AreObjectMovesObserved() {
+  return isolate()->logger()->is_logging() ||
+      isolate()->logger()->is_logging_code_events() ||
+      isolate()->cpu_profiler()->is_profiling() ||
+      (isolate()->heap_profiler() != NULL &&
+       isolate()->heap_profiler()->is_profiling());
+}
+
+
+bool MarkCompactCollector::CanCompactInParallel() {
+  // The compaction tasks do not report object moves.
+  return FLAG_parallel_compaction && !AreObjectMovesObserved();
+}
+
+
+void MarkCompactCollector::RunParallelCompactionTask(int task_id) {
+  if (string_table_pruner_ != NULL) {
+    string_table_pruner_->Run(task_id);
+    return;
+  }
+  ASSERT(parallel_compactor_ != NULL);
+  parallel_compactor_->task(task_id)->Run();
+}
+
+
+void MarkCompactCollector::RunParallelCompactionPhase() {
+  CompactionThread** threads = isolate()->compaction_threads();
+  for (int i = 0; i < FLAG_compaction_threads; i++) {
+    threads[i]->StartCompaction();
+  }
+  RunParallelCompactionTask(0);
+  for (int i = 0; i < FLAG_compaction_threads; i++) {
+    threads[i]->WaitForCompactionThread();
+  }
+}
+
+
+void MarkCompactCollector::EvacuatePagesInParallel() {
+  AlwaysAllocateScope always_allocate;
+  ParallelCompactor* compactor = parallel_compactor_;
+  compactor->PrepareForEvacuation(&evacuation_candidates_);
+  RunParallelCompactionPhase();
+
+  for (int i = 0; i < compactor->number_of_tasks(); i++) {
+    ParallelCompactionTask* task = compactor->task(i);
+    task->Finish();
+    List<Address>* store_buffer_entries = task->store_buffer_entries();
+    for (int j = 0; j < store_buffer_entries->length(); j++) {
+      heap()->store_buffer()->Mark(store_buffer_entries->at(j));
+    }
+    store_buffer_entries->Rewind(0);
+  }
+
+  // Abandon the pages that were not evacuated because a space could not be
+  // expanded, like EvacuatePages does.
+  int npages = evacuation_candidates_.length();
+  for (int i = 0; i < npages; i++) {
+    Page* p = evacuation_candidates_[i];
+    if (!p->IsEvacuationCandidate() || p->WasSwept()) continue;
+    slots_buffer_allocator_.DeallocateChain(p->slots_buffer_address());
+    p->ClearEvacuationCandidate();
+    p->SetFlag(Page::RESCAN_ON_EVACUATION);
+    p->InsertAfter(static_cast<PagedSpace*>(p->owner())->anchor());
+  }
+}
+
+
+static void AddSlotsBuffersInChain(List<SlotsBuffer*>* slots_buffers,
+                                   SlotsBuffer* buffer) {
+  while (buffer != NULL) {
+    slots_buffers->Add(buffer);
+    buffer = buffer->next();
+  }
+}
+
+
+void MarkCompactCollector::UpdateSlotsInParallel(
+    bool code_slots_filtering_required) {
+  ParallelCompactor* compactor = parallel_compactor_;
+  List<SlotsBuffer*> slots_buffers;
+  AddSlotsBuffersInChain(&slots_buffers, migration_slots_buffer_);
+  for (int i = 0; i < compactor->number_of_tasks(); i++) {
+    AddSlotsBuffersInChain(&slots_buffers,
+                           compactor->task(i)->migration_slots_buffer());
+  }
+  int npages = evacuation_candidates_.length();
+  for (int i = 0; i < npages; i++) {
+    Page* p = evacuation_candidates_[i];
+    if (p->IsEvacuationCandidate()) {
+      AddSlotsBuffersInChain(&slots_buffers, p->slots_buffer());
+    }
+  }
+
+  compactor->PrepareForSlotsUpdating(&slots_buffers,
+                                     code_slots_filtering_required);
+  RunParallelCompactionPhase();
+}
+
+
+static bool SeqOneByteStringsMatch(void* key1, void* key2) {
+  SeqOneByteString* string1 = reinterpret_cast<SeqOneByteString*>(key1);
+  SeqOneByteString* string2 = reinterpret_cast<SeqOneByteString*>(key2);
+  int length = string1->length();
+  if (length != string2->length()) return false;
+  return CompareChars(string1->GetChars(), string2->GetChars(), length) == 0;
+}
+
+
+void MarkCompactCollector::DeduplicateStrings() {
+  ASSERT(deduplicated_strings_.is_empty());
+  if (!FLAG_string_deduplication || AreObjectMovesObserved()) return;
+
+  bool has_candidates = false;
+  for (int i = 0; i < evacuation_candidates_.length(); i++) {
+    Page* p = evacuation_candidates_[i];
+    if (p->IsEvacuationCandidate() &&
+        p->owner()->identity() == OLD_DATA_SPACE) {
+      has_candidates = true;
+      break;
+    }
+  }
+  if (!has_candidates) return;
+
+  // Strings on pages that stay in place are entered first, so that as many
+  // duplicates as possible are merged into copies that do not move.
+  HashMap table(&SeqOneByteStringsMatch);
+  PageIterator it(heap()->old_data_space());
+  while (it.has_next()) {
+    Page* p = it.next();
+    if (!p->IsEvacuationCandidate()) DeduplicateStringsOnPage(p, &table);
+  }
+  for (int i = 0; i < evacuation_candidates_.length(); i++) {
+    Page* p = evacuation_candidates_[i];
+    if (p->IsEvacuationCandidate() &&
+        p->owner()->identity() == OLD_DATA_SPACE) {
+      DeduplicateStringsOnPage(p, &table);
+    }
+  }
+}
+
+
+void MarkCompactCollector::DeduplicateStringsOnPage(Page* p, HashMap* table) {
+  // Old data space only holds objects that survived promotion from new
+  // space, so every string seen here is old enough to be worth hashing.
+  Map* string_map = heap()->ascii_string_map();
+  bool on_candidate = p->IsEvacuationCandidate();
+  int offsets[16];
+
+  for (MarkBitCellIterator it(p); !it.Done(); it.Advance()) {
+    Address cell_base = it.CurrentCellBase();
+    MarkBit::CellType* cell = it.CurrentCell();
+
+    if (*cell == 0) continue;
+
+    int live_objects = MarkWordToObjectStarts(*cell, offsets);
+    for (int i = 0; i < live_objects; i++) {
+      HeapObject* object =
+          HeapObject::FromAddress(cell_base + offsets[i] * kPointerSize);
+      if (object->map() != string_map) continue;
+      SeqOneByteString* string = SeqOneByteString::cast(object);
+      if (string->length() < FLAG_string_deduplication_min_length) continue;
+
+      HashMap::Entry* entry = table->Lookup(string, string->Hash(), true);
+      if (entry->value == NULL) {
+        entry->value = string;
+        continue;
+      }
+      if (!on_candidate) continue;
+
+      // Drop the duplicate from the live objects of its page so that it is
+      // not evacuated, and forward it to the canonical copy.
+      MarkBit mark_bit = Marking::MarkBitFrom(object);
+      ASSERT(Marking::IsBlack(mark_bit));
+      mark_bit.Clear();
+      MemoryChunk::IncrementLiveBytesFromGC(object->address(),
+                                            -string->Size());
+      object->set_map_word(MapWord::FromForwardingAddress(
+          reinterpret_cast<HeapObject*>(entry->value)));
+      deduplicated_strings_.Add(object);
+    }
+  }
+}
+
+
+void MarkCompactCollector::FinishStringDeduplication() {
+  Map* string_map = heap()->ascii_string_map();
+  for (int i = 0; i < deduplicated_strings_.length(); i++) {
+    HeapObject* object = deduplicated_strings_[i];
+    HeapObject* canonical = object->map_word().ToForwardingAddress();
+    if (!IsOnEvacuationCandidate(object)) {
+      // Evacuation of the page was abandoned, so the duplicate stays alive
+      // in place.  The length field is intact and the map is known.
+      object->set_map_no_write_barrier(string_map);
+      Marking::MarkBlack(Marking::MarkBitFrom(object));
+      MemoryChunk::IncrementLiveBytesFromGC(object->address(), object->Size());
+      continue;
+    }
+    MapWord canonical_map_word = canonical->map_word();
+    if (canonical_map_word.IsForwardingAddress()) {
+      object->set_map_word(MapWord::FromForwardingAddress(
+          canonical_map_word.ToForwardingAddress()));
+    }
+    tracer_->increment_deduplicated_strings_size(
+        SeqOneByteString::SizeFor(
+            reinterpret_cast<SeqOneByteString*>(object)->length()));
+  }
+  deduplicated_strings_.Rewind(0);
+}
+
+
 class EvacuationWeakObjectRetainer : public WeakObjectRetainer {
  public:
   virtual Object* RetainAs(Object* object) {
@@ -3173,6 +4277,7 @@ static void SweepPrecisely(PagedSpace* space,
     for ( ; live_objects != 0; live_objects--) {
       Address free_end = cell_base + offsets[live_index++] * kPointerSize;
       if (free_end != free_start) {
+        space->heap()->store_buffer()->RemoveSlots(free_start, free_end);
         space->Free(free_start, static_cast<int>(free_end - free_start));
 #ifdef ENABLE_GDB_JIT_INTERFACE
         if (FLAG_gdbjit && space->identity() == CODE_SPACE) {
@@ -3204,6 +4309,7 @@ static void SweepPrecisely(PagedSpace* space,
     *cell = 0;
   }
   if (free_start != p->area_end()) {
+    space->heap()->store_buffer()->RemoveSlots(free_start, p->area_end());
     space->Free(free_start, static_cast<int>(p->area_end() - free_start));
 #ifdef ENABLE_GDB_JIT_INTERFACE
     if (FLAG_gdbjit && space->identity() == CODE_SPACE) {
@@ -3349,8 +4455,19 @@ void MarkCompactCollector::EvacuateNewSpaceAndCandidates() {
     EvacuateNewSpace();
   }
 
+  if (CanCompactInParallel()) {
+    parallel_compactor_ =
+        new ParallelCompactor(this, FLAG_compaction_threads + 1);
+  }
+
   { GCTracer::Scope gc_scope(tracer_, GCTracer::Scope::MC_EVACUATE_PAGES);
-    EvacuatePages();
+    DeduplicateStrings();
+    if (parallel_compactor_ != NULL) {
+      EvacuatePagesInParallel();
+    } else {
+      EvacuatePages();
+    }
+    FinishStringDeduplication();
   }
 
   // Second pass: find pointers to new space and update them.
@@ -3379,18 +4496,21 @@ void MarkCompactCollector::EvacuateNewSpaceAndCandidates() {
 
   { GCTracer::Scope gc_scope(tracer_,
                              GCTracer::Scope::MC_UPDATE_OLD_TO_NEW_POINTERS);
-    StoreBufferRebuildScope scope(heap_,
-                                  heap_->store_buffer(),
-                                  &Heap::ScavengeStoreBufferCallback);
+    StoreBufferRebuildScope scope(heap_->store_buffer());
     heap_->store_buffer()->IteratePointersToNewSpaceAndClearMaps(
         &UpdatePointer);
   }
 
   { GCTracer::Scope gc_scope(tracer_,
                              GCTracer::Scope::MC_UPDATE_POINTERS_TO_EVACUATED);
-    SlotsBuffer::UpdateSlotsRecordedIn(heap_,
-                                       migration_slots_buffer_,
-                                       code_slots_filtering_required);
+    if (parallel_compactor_ != NULL) {
+      // Also updates the slots buffers of the evacuation candidates.
+      UpdateSlotsInParallel(code_slots_filtering_required);
+    } else {
+      SlotsBuffer::UpdateSlotsRecordedIn(heap_,
+                                         migration_slots_buffer_,
+                                         code_slots_filtering_required);
+    }
     if (FLAG_trace_fragmentation) {
       PrintF("  migration slots buffer: %d\n",
              SlotsBuffer::SizeOfChain(migration_slots_buffer_));
@@ -3422,9 +4542,11 @@ void MarkCompactCollector::EvacuateNewSpaceAndCandidates() {
              p->IsFlagSet(Page::RESCAN_ON_EVACUATION));
 
       if (p->IsEvacuationCandidate()) {
-        SlotsBuffer::UpdateSlotsRecordedIn(heap_,
-                                           p->slots_buffer(),
-                                           code_slots_filtering_required);
+        if (parallel_compactor_ == NULL) {
+          SlotsBuffer::UpdateSlotsRecordedIn(heap_,
+                                             p->slots_buffer(),
+                                             code_slots_filtering_required);
+        }
         if (FLAG_trace_fragmentation) {
           PrintF("  page %p slots buffer: %d\n",
                  reinterpret_cast<void*>(p),
@@ -3525,6 +4647,9 @@ void MarkCompactCollector::EvacuateNewSpaceAndCandidates() {
 
   slots_buffer_allocator_.DeallocateChain(&migration_slots_buffer_);
   ASSERT(migration_slots_buffer_ == NULL);
+
+  delete parallel_compactor_;
+  parallel_compactor_ = NULL;
 }
 
 
@@ -3839,6 +4964,9 @@ static intptr_t Free(PagedSpace* space,
                      FreeList* free_list,
                      Address start,
                      int size) {
+  // Dead objects may have left slots in the remembered set that would be
+  // misread once the memory is reused.
+  space->heap()->store_buffer()->RemoveSlots(start, start + size);
   if (mode == MarkCompactCollector::SWEEP_SEQUENTIALLY) {
     return space->Free(start, size);
   } else {
@@ -3956,18 +5084,44 @@ intptr_t MarkCompactCollector::SweepConservatively(PagedSpace* space,
 }
 
 
-void MarkCompactCollector::SweepInParallel(PagedSpace* space,
+Page* MarkCompactCollector::ClaimPageForSweeping() {
+  int length = sweeping_queue_.length();
+  while (true) {
+    int index = static_cast<int>(
+        NoBarrier_AtomicIncrement(&sweeping_queue_next_, 1) - 1);
+    if (index >= length) return NULL;
+    Page* p = sweeping_queue_[index];
+    // The main thread may have swept the page on demand already.
+    if (p->TryParallelSweeping()) return p;
+  }
+}
+
+
+void MarkCompactCollector::SweepInParallel(Page* p,
                                            FreeList* private_free_list,
                                            FreeList* free_list) {
-  PageIterator it(space);
-  while (it.has_next()) {
-    Page* p = it.next();
+  PagedSpace* space = static_cast<PagedSpace*>(p->owner());
+  SweepConservatively<SWEEP_IN_PARALLEL>(space, private_free_list, p);
+  free_list->Concatenate(private_free_list);
+}
 
-    if (p->TryParallelSweeping()) {
-      SweepConservatively<SWEEP_IN_PARALLEL>(space, private_free_list, p);
-      free_list->Concatenate(private_free_list);
+
+intptr_t MarkCompactCollector::SweepOnDemand(PagedSpace* space,
+                                             intptr_t bytes_to_free) {
+  intptr_t freed_bytes = 0;
+  int length = sweeping_queue_.length();
+  int index = static_cast<int>(NoBarrier_Load(&sweeping_queue_next_));
+  for (; index < length && freed_bytes < bytes_to_free; index++) {
+    Page* p = sweeping_queue_[index];
+    if (p->owner() != space || !p->TryParallelSweeping()) continue;
+    if (FLAG_gc_verbose) {
+      PrintF("Sweeping 0x%" V8PRIxPTR " conservatively on demand.\n",
+             reinterpret_cast<intptr_t>(p));
     }
+    space->DecreaseUnsweptFreeBytes(p);
+    freed_bytes += SweepConservatively<SWEEP_SEQUENTIALLY>(space, NULL, p);
   }
+  return freed_bytes;
 }
 
 
@@ -4063,6 +5217,7 @@ void MarkCompactCollector::SweepSpace(PagedSpace* space, SweeperType sweeper) {
           }
           p->set_parallel_sweeping(1);
           space->IncreaseUnsweptFreeBytes(p);
+          sweeping_queue_.Add(p);
         }
         break;
       }
@@ -29,6 +29,7 @@
 #define V8_MARK_COMPACT_H_
 
 #include "compiler-intrinsics.h"
+#include "hashmap.h"
 #include "spaces.h"
 
 namespace v8 {
@@ -44,6 +45,9 @@ class CodeFlusher;
 class GCTracer;
 class MarkCompactCollector;
 class MarkingVisitor;
+class ParallelCompactor;
+class StringTablePruner;
+class ParallelMarker;
 class RootMarkingVisitor;
 
 
@@ -185,6 +189,8 @@ class MarkingDeque {
 
   inline bool IsEmpty() { return top_ == bottom_; }
 
+  inline int length() { return (top_ - bottom_) & mask_; }
+
   bool overflowed() const { return overflowed_; }
 
   void ClearOverflowed() { overflowed_ = false; }
@@ -697,12 +703,26 @@ class MarkCompactCollector {
 
   bool TryPromoteObject(HeapObject* object, int object_size);
 
+  // Runs one task of a parallel compaction phase or of the parallel string
+  // table pruning.  Task 0 runs on the main thread, the others on the
+  // compaction threads.
+  void RunParallelCompactionTask(int task_id);
+
   inline Object* encountered_weak_collections() {
     return encountered_weak_collections_;
   }
   inline void set_encountered_weak_collections(Object* weak_collection) {
     encountered_weak_collections_ = weak_collection;
   }
+  // Weak collections encountered by incremental marking stay on the list
+  // until the next full collection, so scavenges have to update its head.
+  inline Object** encountered_weak_collections_address() {
+    return &encountered_weak_collections_;
+  }
+
+  // Unlinks the weak collections encountered by an aborted incremental
+  // marking.
+  void AbortWeakCollections();
 
   void InvalidateCode(Code* code);
 
@@ -710,15 +730,26 @@ class MarkCompactCollector {
 
   bool abort_incremental_marking() const { return abort_incremental_marking_; }
 
+  bool flush_regexp_code() const { return flush_regexp_code_; }
+
   bool is_compacting() const { return compacting_; }
 
   MarkingParity marking_parity() { return marking_parity_; }
 
-  // Concurrent and parallel sweeping support.
-  void SweepInParallel(PagedSpace* space,
+  // Concurrent and parallel sweeping support. Pages left for the sweeper
+  // threads are queued in sweeping_queue_ and claimed one at a time, either
+  // by a sweeper thread or by the main thread sweeping on demand.
+  Page* ClaimPageForSweeping();
+
+  void SweepInParallel(Page* p,
                        FreeList* private_free_list,
                        FreeList* free_list);
 
+  // Sweeps queued pages of the given space on the main thread until at least
+  // the given number of bytes has been freed or no unclaimed page of that
+  // space is left. Returns the number of bytes freed.
+  intptr_t SweepOnDemand(PagedSpace* space, intptr_t bytes_to_free);
+
   void WaitUntilSweepingCompleted();
 
   intptr_t StealMemoryFromSweeperThreads(PagedSpace* space);
@@ -739,6 +770,16 @@ class MarkCompactCollector {
   // marking its contents.
   void MarkWeakObjectToCodeTable();
 
+  // Runs one task of a parallel marking phase.  Task 0 runs on the main
+  // thread, the others on the parallel marking threads.
+  void RunParallelMarkingTask(int task_id);
+
+  // Number of objects that the parallel marking threads visited during the
+  // last mark-compact.
+  int objects_marked_by_marking_threads() {
+    return objects_marked_by_marking_threads_;
+  }
+
  private:
   MarkCompactCollector();
   ~MarkCompactCollector();
@@ -776,6 +817,8 @@ class MarkCompactCollector {
 
   bool abort_incremental_marking_;
 
+  bool flush_regexp_code_;
+
   MarkingParity marking_parity_;
 
   // True if we are collecting slots to perform evacuation from evacuation
@@ -789,6 +832,11 @@ class MarkCompactCollector {
 
   bool sequential_sweeping_;
 
+  // Pages waiting to be swept concurrently and the index of the next
+  // unclaimed entry.
+  List<Page*> sweeping_queue_;
+  volatile AtomicWord sweeping_queue_next_;
+
   // A pointer to the current stack-allocated GC tracer object during a full
   // collection (NULL before and after).
   GCTracer* tracer_;
@@ -797,6 +845,10 @@ class MarkCompactCollector {
 
   SlotsBuffer* migration_slots_buffer_;
 
+  // Duplicate strings on evacuation candidates whose map word currently
+  // holds a forwarding address to their canonical copy.
+  List<HeapObject*> deduplicated_strings_;
+
   // Finishes GC, performs heap verification if enabled.
   void Finish();
 
@@ -868,6 +920,15 @@ class MarkCompactCollector {
   // overflow flag will be set.
   void EmptyMarkingDeque();
 
+  // Parallel marking support.  Once enough objects are on the marking stack,
+  // EmptyMarkingDeque hands them to the parallel marking threads, which trace
+  // them using work stealing and task-local marking stacks.
+  static const int kMinObjectsForParallelMarking = 1024;
+
+  bool CanMarkInParallel();
+
+  void EmptyMarkingDequeInParallel();
+
   // Refill the marking stack with overflowed objects from the heap.  This
   // function either leaves the marking stack full or clears the overflow
   // flag on the marking stack.
@@ -898,10 +959,28 @@ class MarkCompactCollector {
   void ReattachInitialMaps();
 
   // Mark all values associated with reachable keys in weak collections
-  // encountered so far.  This might push new object or even new weak maps onto
-  // the marking stack.
+  // encountered since the last call.  This might push new object or even new
+  // weak maps onto the marking stack.  Entries whose key is not marked yet
+  // are remembered as pending ephemerons, so every table is scanned only
+  // once per collection.
   void ProcessWeakCollections();
 
+  // Remembers an entry of a weak collection whose key and value are both
+  // unmarked.  Its value gets marked as soon as the key gets marked.
+  void AddEphemeron(HeapObject* key, Object** value_slot);
+
+  // Called whenever an object gets marked while there are pending
+  // ephemerons.  Queues the ephemerons keyed by the object for marking.
+  void DiscoverEphemeronKey(HeapObject* object);
+
+  // Queues the pending ephemerons whose keys got marked without being
+  // discovered.  Returns true if there were any.
+  bool DiscoverMarkedEphemeronKeys();
+
+  // Marks the values of the discovered ephemerons and everything reachable
+  // from them, until no more ephemerons are discovered.
+  void ProcessDiscoveredEphemerons();
+
   // After all reachable objects have been marked those weak map entries
   // with an unreachable key are removed from all encountered weak maps.
   // The linked list of all encountered weak maps is destroyed.
@@ -932,6 +1011,42 @@ class MarkCompactCollector {
 
   void EvacuatePages();
 
+  // Whether a logger or profiler needs to be told about every object that
+  // is moved.
+  bool AreObjectMovesObserved();
+
+  // Parallel compaction support.  Candidate pages are evacuated and slots
+  // buffers are updated by the compaction threads, one page or one buffer
+  // at a time.
+  bool CanCompactInParallel();
+
+  // String deduplication.  Before evacuation, live non-internalized
+  // sequential one-byte strings in old data space that equal an earlier
+  // string are forwarded to it if they are on an evacuation candidate.
+  // They are not copied, and updating the pointers to evacuated objects
+  // redirects their referrers to the canonical copy.
+  void DeduplicateStrings();
+  void DeduplicateStringsOnPage(Page* p, HashMap* table);
+  // Resolves forwarding addresses to canonical copies that were evacuated
+  // themselves, and revives duplicates whose page was not evacuated.
+  void FinishStringDeduplication();
+
+  void RunParallelCompactionPhase();
+
+  void EvacuatePagesInParallel();
+
+  void UpdateSlotsInParallel(bool code_slots_filtering_required);
+
+  // Copies the object and records the slots of the copy that point to new
+  // space or to evacuation candidates.  Slots pointing to new space are
+  // added to the store buffer, or to store_buffer_entries if given.
+  void MigrateObjectBody(Address dst,
+                         Address src,
+                         int size,
+                         AllocationSpace dest,
+                         SlotsBuffer** migration_slots_buffer,
+                         List<Address>* store_buffer_entries);
+
   void EvacuateNewSpaceAndCandidates();
 
   void SweepSpace(PagedSpace* space, SweeperType sweeper);
@@ -948,12 +1063,39 @@ class MarkCompactCollector {
   MarkingDeque marking_deque_;
   CodeFlusher* code_flusher_;
   Object* encountered_weak_collections_;
+  // Head of encountered_weak_collections_ when the tables were last scanned
+  // by ProcessWeakCollections.
+  Object* scanned_weak_collections_;
   bool have_code_to_deoptimize_;
 
+  // Pending ephemerons, chained per key.  The chains are found through
+  // ephemeron_keys_, which maps a key to the index of its first ephemeron
+  // plus one, or to NULL once the key is discovered.  It only exists while
+  // there are pending ephemerons.
+  struct Ephemeron {
+    Object** value_slot;
+    int next;
+  };
+  List<Ephemeron> ephemerons_;
+  HashMap* ephemeron_keys_;
+  // First ephemerons of the chains whose keys got marked.
+  List<int> discovered_ephemerons_;
+
+  // The shared state of the current parallel marking phase, if any.
+  ParallelMarker* parallel_marker_;
+  int objects_marked_by_marking_threads_;
+
+  // The shared state of the current parallel compaction, if any.
+  ParallelCompactor* parallel_compactor_;
+
+  // The shared state of the current parallel string table pruning, if any.
+  StringTablePruner* string_table_pruner_;
+
   List<Page*> evacuation_candidates_;
   List<Code*> invalidated_code_;
 
   friend class Heap;
+  friend class ParallelCompactionTask;
 };
 
 
@@ -331,6 +331,17 @@ void JSObject::JSObjectVerify() {
       if (descriptors->GetDetails(i).type() == FIELD) {
         Representation r = descriptors->GetDetails(i).representation();
         int field = descriptors->GetFieldIndex(i);
+        if (IsUnboxedDoubleField(field)) {
+          CHECK(r.IsDouble());
+          CHECK_LT(field, map()->inobject_properties());
+#ifdef DEBUG
+          // The scavenger must never visit the raw bits as a slot.
+          Address slot = address() + GetInObjectPropertyOffset(field);
+          CHECK(!FLAG_enable_slow_asserts || GetHeap()->InNewSpace(this) ||
+                !GetHeap()->store_buffer()->CellIsInStoreBuffer(slot));
+#endif
+          continue;
+        }
         Object* value = RawFastPropertyAt(field);
         if (r.IsDouble()) ASSERT(value->IsHeapNumber());
         if (value->IsUninitialized()) continue;
@@ -361,6 +372,7 @@ void Map::MapVerify() {
           instance_size() < heap->Capacity()));
   VerifyHeapPointer(prototype());
   VerifyHeapPointer(instance_descriptors());
+  CHECK(layout_descriptor() == 0 || instance_type() == JS_OBJECT_TYPE);
   SLOW_ASSERT(instance_descriptors()->IsSortedNoDuplicates());
   if (HasTransitionArray()) {
     SLOW_ASSERT(transitions()->IsSortedNoDuplicates());
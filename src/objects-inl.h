@@ -35,6 +35,7 @@
 #ifndef V8_OBJECTS_INL_H_
 #define V8_OBJECTS_INL_H_
 
+#include "atomicops.h"
 #include "elements.h"
 #include "objects.h"
 #include "contexts.h"
@@ -1233,6 +1234,23 @@ void HeapObject::set_map_word(MapWord map_word) {
 }
 
 
+MapWord HeapObject::acquire_map_word() {
+  return MapWord(static_cast<uintptr_t>(Acquire_Load(
+      reinterpret_cast<AtomicWord*>(FIELD_ADDR(this, kMapOffset)))));
+}
+
+
+bool HeapObject::release_compare_and_swap_map_word(MapWord old_map_word,
+                                                   MapWord new_map_word) {
+  AtomicWord old_value = static_cast<AtomicWord>(old_map_word.value_);
+  AtomicWord result = Release_CompareAndSwap(
+      reinterpret_cast<AtomicWord*>(FIELD_ADDR(this, kMapOffset)),
+      old_value,
+      static_cast<AtomicWord>(new_map_word.value_));
+  return result == old_value;
+}
+
+
 HeapObject* HeapObject::FromAddress(Address address) {
   ASSERT_TAG_ALIGNED(address);
   return reinterpret_cast<HeapObject*>(address + kHeapObjectTag);
@@ -1722,6 +1740,9 @@ void JSObject::SetInternalField(int index, Smi* value) {
 
 MaybeObject* JSObject::FastPropertyAt(Representation representation,
                                       int index) {
+  if (IsUnboxedDoubleField(index)) {
+    return GetHeap()->AllocateHeapNumber(RawFastDoublePropertyAt(index));
+  }
   Object* raw_value = RawFastPropertyAt(index);
   return raw_value->AllocateNewStorageFor(GetHeap(), representation);
 }
@@ -1731,6 +1752,7 @@ MaybeObject* JSObject::FastPropertyAt(Representation representation,
 // is needed to correctly distinguish between properties stored in-object and
 // properties stored in the properties array.
 Object* JSObject::RawFastPropertyAt(int index) {
+  ASSERT(!IsUnboxedDoubleField(index));
   // Adjust for the number of properties stored in the object.
   index -= map()->inobject_properties();
   if (index < 0) {
@@ -1744,6 +1766,11 @@ Object* JSObject::RawFastPropertyAt(int index) {
 
 
 void JSObject::FastPropertyAtPut(int index, Object* value) {
+  if (IsUnboxedDoubleField(index)) {
+    ASSERT(value->IsNumber());
+    RawFastDoublePropertyAtPut(index, value->Number());
+    return;
+  }
   // Adjust for the number of properties stored in the object.
   index -= map()->inobject_properties();
   if (index < 0) {
@@ -1757,6 +1784,24 @@ void JSObject::FastPropertyAtPut(int index, Object* value) {
 }
 
 
+bool JSObject::IsUnboxedDoubleField(int index) {
+  return map()->IsUnboxedDoubleField(index);
+}
+
+
+double JSObject::RawFastDoublePropertyAt(int index) {
+  ASSERT(IsUnboxedDoubleField(index));
+  return READ_DOUBLE_FIELD(this, GetInObjectPropertyOffset(index));
+}
+
+
+void JSObject::RawFastDoublePropertyAtPut(int index, double value) {
+  ASSERT(IsUnboxedDoubleField(index));
+  // No write barrier: the slot holds raw bits that no visitor looks at.
+  WRITE_DOUBLE_FIELD(this, GetInObjectPropertyOffset(index), value);
+}
+
+
 int JSObject::GetInObjectPropertyOffset(int index) {
   // Adjust for the number of properties stored in the object.
   index -= map()->inobject_properties();
@@ -1766,6 +1811,7 @@ int JSObject::GetInObjectPropertyOffset(int index) {
 
 
 Object* JSObject::InObjectPropertyAt(int index) {
+  ASSERT(!IsUnboxedDoubleField(index));
   // Adjust for the number of properties stored in the object.
   index -= map()->inobject_properties();
   ASSERT(index < 0);
@@ -4289,6 +4335,40 @@ uint32_t Map::bit_field3() {
 }
 
 
+int Map::layout_descriptor() {
+  Object* value = READ_FIELD(this, kLayoutDescriptorOffset);
+  return Smi::cast(value)->value();
+}
+
+
+void Map::set_layout_descriptor(int value) {
+  WRITE_FIELD(this, kLayoutDescriptorOffset, Smi::FromInt(value));
+}
+
+
+bool Map::HasUnboxedDoubleFields() {
+  int layout = layout_descriptor();
+  if (layout == 0) return false;
+  int inobject = inobject_properties();
+  if (inobject < kMaxUnboxedDoubleFields) layout &= (1 << inobject) - 1;
+  return layout != 0;
+}
+
+
+bool Map::IsUnboxedDoubleField(int field_index) {
+  if (field_index >= kMaxUnboxedDoubleFields) return false;
+  if (field_index >= inobject_properties()) return false;
+  return (layout_descriptor() & (1 << field_index)) != 0;
+}
+
+
+bool Map::IsUnboxedDoubleFieldOffset(int offset) {
+  int index = inobject_properties() -
+      ((instance_size() - offset) >> kPointerSizeLog2);
+  return index >= 0 && IsUnboxedDoubleField(index);
+}
+
+
 void Map::ClearTransitions(Heap* heap, WriteBarrierMode mode) {
   Object* back_pointer = GetBackPointer();
 
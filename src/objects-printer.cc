@@ -296,7 +296,11 @@ void JSObject::PrintProperties(FILE* out) {
       switch (descs->GetType(i)) {
         case FIELD: {
           int index = descs->GetFieldIndex(i);
-          RawFastPropertyAt(index)->ShortPrint(out);
+          if (IsUnboxedDoubleField(index)) {
+            PrintF(out, "%g", RawFastDoublePropertyAt(index));
+          } else {
+            RawFastPropertyAt(index)->ShortPrint(out);
+          }
           PrintF(out, " (field at offset %d)\n", index);
           break;
         }
@@ -537,6 +541,9 @@ void Map::MapPrint(FILE* out) {
   PrintF(out, "\n - pre-allocated property fields: %d\n",
       pre_allocated_property_fields());
   PrintF(out, " - unused property fields: %d\n", unused_property_fields());
+  if (HasUnboxedDoubleFields()) {
+    PrintF(out, " - layout descriptor: 0x%x\n", layout_descriptor());
+  }
   if (is_hidden_prototype()) {
     PrintF(out, " - hidden_prototype\n");
   }
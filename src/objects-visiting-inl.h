@@ -100,6 +100,8 @@ void StaticNewSpaceVisitor<StaticVisitor>::Initialize() {
   table_.template RegisterSpecializations<JSObjectVisitor,
                                           kVisitJSObject,
                                           kVisitJSObjectGeneric>();
+  table_.Register(kVisitJSObjectWithUnboxedDoubles,
+                  &JSObjectUnboxedVisitor::Visit);
   table_.template RegisterSpecializations<StructVisitor,
                                           kVisitStruct,
                                           kVisitStructGeneric>();
@@ -242,6 +244,9 @@ void StaticMarkingVisitor<StaticVisitor>::Initialize() {
                                           kVisitJSObject,
                                           kVisitJSObjectGeneric>();
 
+  table_.Register(kVisitJSObjectWithUnboxedDoubles,
+                  &JSObjectUnboxedVisitor::Visit);
+
   table_.template RegisterSpecializations<StructObjectVisitor,
                                           kVisitStruct,
                                           kVisitStructGeneric>();
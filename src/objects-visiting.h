@@ -75,6 +75,7 @@ class StaticVisitorBase : public AllStatic {
   V(JSObject8)                \
   V(JSObject9)                \
   V(JSObjectGeneric)          \
+  V(JSObjectWithUnboxedDoubles) \
   V(Struct2)                  \
   V(Struct3)                  \
   V(Struct4)                  \
@@ -129,6 +130,7 @@ class StaticVisitorBase : public AllStatic {
   static VisitorId GetVisitorId(int instance_type, int instance_size);
 
   static VisitorId GetVisitorId(Map* map) {
+    if (map->HasUnboxedDoubleFields()) return kVisitJSObjectWithUnboxedDoubles;
     return GetVisitorId(map->instance_type(), map->instance_size());
   }
 
@@ -266,6 +268,28 @@ class FixedBodyVisitor : public BodyVisitorBase<StaticVisitor> {
 };
 
 
+// Visits a JSObject whose map has unboxed double fields: the raw in-object
+// double slots are skipped and only the tagged runs in between are visited.
+template<typename StaticVisitor, typename ReturnType>
+class JSObjectWithUnboxedDoublesVisitor : public BodyVisitorBase<StaticVisitor> {
+ public:
+  INLINE(static ReturnType Visit(Map* map, HeapObject* object)) {
+    Heap* heap = map->GetHeap();
+    int object_size = map->instance_size();
+    int start = JSObject::BodyDescriptor::kStartOffset;
+    for (int offset = start; offset < object_size; offset += kPointerSize) {
+      if (!map->IsUnboxedDoubleFieldOffset(offset)) continue;
+      BodyVisitorBase<StaticVisitor>::IteratePointers(
+          heap, object, start, offset);
+      start = offset + kPointerSize;
+    }
+    BodyVisitorBase<StaticVisitor>::IteratePointers(
+        heap, object, start, object_size);
+    return static_cast<ReturnType>(object_size);
+  }
+};
+
+
 // Base class for visitors used for a linear new space iteration.
 // IterateBody returns size of visited object.
 // Certain types of objects (i.e. Code objects) are not handled
@@ -364,6 +388,9 @@ class StaticNewSpaceVisitor : public StaticVisitorBase {
                               JSObject::BodyDescriptor,
                               int> JSObjectVisitor;
 
+  typedef JSObjectWithUnboxedDoublesVisitor<StaticVisitor, int>
+      JSObjectUnboxedVisitor;
+
   typedef int (*Callback)(Map* map, HeapObject* object);
 
   static VisitorDispatchTable<Callback> table_;
@@ -459,6 +486,9 @@ class StaticMarkingVisitor : public StaticVisitorBase {
                               JSObject::BodyDescriptor,
                               void> JSObjectVisitor;
 
+  typedef JSObjectWithUnboxedDoublesVisitor<StaticVisitor, void>
+      JSObjectUnboxedVisitor;
+
   typedef FlexibleBodyVisitor<StaticVisitor,
                               StructBodyDescriptor,
                               void> StructObjectVisitor;
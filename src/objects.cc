@@ -1257,9 +1257,11 @@ bool String::MakeExternal(v8::String::ExternalStringResource* resource) {
   self->set_resource(resource);
   if (is_internalized) self->Hash();  // Force regeneration of the hash value.
 
-  // Fill the remainder of the string with dead wood.
+  // Fill the remainder of the string with dead wood.  The pointer fields of
+  // a cons or sliced string now hold the resource or lie in the filler.
   int new_size = this->Size();  // Byte size of the external String object.
   heap->CreateFillerObjectAt(this->address() + new_size, size - new_size);
+  heap->ClearRecordedSlotRange(this->address(), this->address() + size);
   if (Marking::IsBlack(Marking::MarkBitFrom(this))) {
     MemoryChunk::IncrementLiveBytesFromMutator(this->address(),
                                                new_size - size);
@@ -1307,9 +1309,11 @@ bool String::MakeExternal(v8::String::ExternalAsciiStringResource* resource) {
   self->set_resource(resource);
   if (is_internalized) self->Hash();  // Force regeneration of the hash value.
 
-  // Fill the remainder of the string with dead wood.
+  // Fill the remainder of the string with dead wood.  The pointer fields of
+  // a cons or sliced string now hold the resource or lie in the filler.
   int new_size = this->Size();  // Byte size of the external String object.
   heap->CreateFillerObjectAt(this->address() + new_size, size - new_size);
+  heap->ClearRecordedSlotRange(this->address(), this->address() + size);
   if (Marking::IsBlack(Marking::MarkBitFrom(this))) {
     MemoryChunk::IncrementLiveBytesFromMutator(this->address(),
                                                new_size - size);
@@ -1760,6 +1764,16 @@ void HeapObject::IterateBody(InstanceType type, int object_size,
     case FIXED_DOUBLE_ARRAY_TYPE:
       break;
     case JS_OBJECT_TYPE:
+      // The map word is not a map while the path tracer has marked the
+      // object; it visits objects with unboxed double fields itself.
+      if (FLAG_unbox_double_fields && !map_word().IsForwardingAddress() &&
+          map()->HasUnboxedDoubleFields()) {
+        reinterpret_cast<JSObject*>(this)
+            ->JSObjectIterateBodyWithUnboxedDoubles(map(), object_size, v);
+        break;
+      }
+      JSObject::BodyDescriptor::IterateBody(this, object_size, v);
+      break;
     case JS_CONTEXT_EXTENSION_OBJECT_TYPE:
     case JS_GENERATOR_OBJECT_TYPE:
     case JS_MODULE_TYPE:
@@ -1847,6 +1861,19 @@ void HeapObject::IterateBody(InstanceType type, int object_size,
 }
 
 
+void JSObject::JSObjectIterateBodyWithUnboxedDoubles(Map* map,
+                                                     int object_size,
+                                                     ObjectVisitor* v) {
+  int start = BodyDescriptor::kStartOffset;
+  for (int offset = start; offset < object_size; offset += kPointerSize) {
+    if (!map->IsUnboxedDoubleFieldOffset(offset)) continue;
+    v->VisitPointers(RawField(this, start), RawField(this, offset));
+    start = offset + kPointerSize;
+  }
+  v->VisitPointers(RawField(this, start), RawField(this, object_size));
+}
+
+
 bool HeapNumber::HeapNumberBooleanValue() {
   // NaN, +0, and -0 should return the false object
 #if __BYTE_ORDER == __LITTLE_ENDIAN
@@ -1930,6 +1957,24 @@ static Handle<Object> NewStorageFor(Isolate* isolate,
 }
 
 
+// Forgets the recorded old-to-new slots of the in-object fields that the
+// object's new map stores unboxed and |old_map| did not.  The next scavenge
+// would otherwise take the raw doubles written there for pointers.
+static void ClearRecordedSlotsOfUnboxedFields(JSObject* object, Map* old_map) {
+  Map* new_map = object->map();
+  if (!new_map->HasUnboxedDoubleFields()) return;
+  Heap* heap = object->GetHeap();
+  if (heap->InNewSpace(object)) return;
+  int inobject = new_map->inobject_properties();
+  for (int i = 0; i < inobject; i++) {
+    if (!new_map->IsUnboxedDoubleField(i)) continue;
+    if (old_map->IsUnboxedDoubleField(i)) continue;
+    Address slot = object->address() + object->GetInObjectPropertyOffset(i);
+    heap->ClearRecordedSlotRange(slot, slot + kPointerSize);
+  }
+}
+
+
 void JSObject::AddFastPropertyUsingMap(Handle<JSObject> object,
                                        Handle<Map> new_map,
                                        Handle<Name> name,
@@ -1939,8 +1984,9 @@ void JSObject::AddFastPropertyUsingMap(Handle<JSObject> object,
   Isolate* isolate = object->GetIsolate();
 
   // This method is used to transition to a field. If we are transitioning to a
-  // double field, allocate new storage.
-  Handle<Object> storage = NewStorageFor(isolate, value, representation);
+  // double field, allocate new storage unless the field is stored unboxed.
+  Handle<Object> storage = new_map->IsUnboxedDoubleField(field_index)
+      ? value : NewStorageFor(isolate, value, representation);
 
   if (object->map()->unused_property_fields() == 0) {
     int new_unused = new_map->unused_property_fields();
@@ -1950,7 +1996,9 @@ void JSObject::AddFastPropertyUsingMap(Handle<JSObject> object,
     object->set_properties(*values);
   }
 
+  Map* old_map = object->map();
   object->set_map(*new_map);
+  ClearRecordedSlotsOfUnboxedFields(*object, old_map);
   object->FastPropertyAtPut(field_index, *storage);
 }
 
@@ -2297,6 +2345,7 @@ static void RightTrimFixedArray(Heap* heap, FixedArray* elms, int to_trim) {
   // debug mode which iterates through the heap), but to play safer
   // we still do it.
   heap->CreateFillerObjectAt(new_end, size_delta);
+  heap->ClearRecordedSlotRange(new_end, new_end + size_delta);
 
   elms->set_length(len - to_trim);
 
@@ -2327,6 +2376,9 @@ bool Map::InstancesNeedRewriting(Map* target,
   ASSERT(target_number_of_fields >= number_of_fields);
   if (target_number_of_fields != number_of_fields) return true;
 
+  // If fields were boxed or unboxed, rewrite.
+  if (layout_descriptor() != target->layout_descriptor()) return true;
+
   if (FLAG_track_double_fields) {
     // If smi descriptors were replaced by double descriptors, rewrite.
     DescriptorArray* old_desc = instance_descriptors();
@@ -2404,10 +2456,9 @@ void JSObject::MigrateToMap(Handle<JSObject> object, Handle<Map> new_map) {
     }
     ASSERT(old_details.type() == CONSTANT ||
            old_details.type() == FIELD);
-    Object* raw_value = old_details.type() == CONSTANT
-        ? old_descriptors->GetValue(i)
-        : object->RawFastPropertyAt(old_descriptors->GetFieldIndex(i));
-    Handle<Object> value(raw_value, isolate);
+    Handle<Object> value = old_details.type() == CONSTANT
+        ? handle(old_descriptors->GetValue(i), isolate)
+        : TaggedFastPropertyAt(object, old_descriptors->GetFieldIndex(i));
     if (FLAG_track_double_fields &&
         !old_details.representation().IsDouble() &&
         details.representation().IsDouble()) {
@@ -2427,6 +2478,10 @@ void JSObject::MigrateToMap(Handle<JSObject> object, Handle<Map> new_map) {
   // From here on we cannot fail and we shouldn't GC anymore.
   DisallowHeapAllocation no_allocation;
 
+  // Install the new map first, so that fields it unboxes receive raw doubles.
+  object->set_map(*new_map);
+  ClearRecordedSlotsOfUnboxedFields(*object, *old_map);
+
   // Copy (real) inobject properties. If necessary, stop at number_of_fields to
   // avoid overwriting |one_pointer_filler_map|.
   int limit = Min(inobject, number_of_fields);
@@ -2440,6 +2495,8 @@ void JSObject::MigrateToMap(Handle<JSObject> object, Handle<Map> new_map) {
   ASSERT(instance_size_delta >= 0);
   Address address = object->address() + new_instance_size;
   isolate->heap()->CreateFillerObjectAt(address, instance_size_delta);
+  isolate->heap()->ClearRecordedSlotRange(address,
+                                          address + instance_size_delta);
 
   // If there are properties in the new backing store, trim it to the correct
   // size and install the backing store into the object.
@@ -2447,8 +2504,17 @@ void JSObject::MigrateToMap(Handle<JSObject> object, Handle<Map> new_map) {
     RightTrimFixedArray<FROM_MUTATOR>(isolate->heap(), *array, inobject);
     object->set_properties(*array);
   }
+}
 
-  object->set_map(*new_map);
+
+Handle<Object> JSObject::TaggedFastPropertyAt(Handle<JSObject> object,
+                                              int index) {
+  Isolate* isolate = object->GetIsolate();
+  if (object->IsUnboxedDoubleField(index)) {
+    return isolate->factory()->NewHeapNumber(
+        object->RawFastDoublePropertyAt(index));
+  }
+  return handle(object->RawFastPropertyAt(index), isolate);
 }
 
 
@@ -2483,6 +2549,30 @@ int Map::NumberOfFields() {
 }
 
 
+void Map::UpdateLayoutDescriptor() {
+  if (!FLAG_unbox_double_fields) return;
+  int layout = 0;
+  // Raw doubles can only share a slot with tagged values where both are the
+  // same width.
+  if (kDoubleSize == kPointerSize && instance_type() == JS_OBJECT_TYPE) {
+    DescriptorArray* descriptors = instance_descriptors();
+    int limit = NumberOfOwnDescriptors();
+    for (int i = 0; i < limit; i++) {
+      PropertyDetails details = descriptors->GetDetails(i);
+      if (details.type() != FIELD) continue;
+      if (!details.representation().IsDouble()) continue;
+      int field_index = descriptors->GetFieldIndex(i);
+      if (field_index < kMaxUnboxedDoubleFields) {
+        layout |= 1 << field_index;
+      }
+    }
+  }
+  if (layout == layout_descriptor()) return;
+  set_layout_descriptor(layout);
+  set_visitor_id(StaticVisitorBase::GetVisitorId(this));
+}
+
+
 Handle<Map> Map::CopyGeneralizeAllRepresentations(Handle<Map> map,
                                                   int modify_index,
                                                   StoreMode store_mode,
@@ -2508,6 +2598,7 @@ Handle<Map> Map::CopyGeneralizeAllRepresentations(Handle<Map> map,
     }
     new_map->set_unused_property_fields(unused_property_fields);
   }
+  new_map->UpdateLayoutDescriptor();
 
   if (FLAG_trace_generalization) {
     map->PrintGeneralization(stdout, reason, modify_index,
@@ -3372,6 +3463,7 @@ void JSObject::LocalLookupRealNamedProperty(Name* name, LookupResult* result) {
     // occur as fields.
     if (result->IsField() &&
         result->IsReadOnly() &&
+        !IsUnboxedDoubleField(result->GetFieldIndex().field_index()) &&
         RawFastPropertyAt(result->GetFieldIndex().field_index())->IsTheHole()) {
       result->DisallowCaching();
     }
@@ -3940,8 +4032,14 @@ static void SetPropertyToField(LookupResult* lookup,
   }
 
   if (FLAG_track_double_fields && representation.IsDouble()) {
-    HeapNumber* storage = HeapNumber::cast(lookup->holder()->RawFastPropertyAt(
-        lookup->GetFieldIndex().field_index()));
+    int field_index = lookup->GetFieldIndex().field_index();
+    if (lookup->holder()->IsUnboxedDoubleField(field_index)) {
+      lookup->holder()->RawFastDoublePropertyAtPut(field_index,
+                                                   value->Number());
+      return;
+    }
+    HeapNumber* storage = HeapNumber::cast(
+        lookup->holder()->RawFastPropertyAt(field_index));
     storage->set_value(value->Number());
     return;
   }
@@ -4567,8 +4665,8 @@ void JSObject::NormalizeProperties(Handle<JSObject> object,
       }
       case FIELD: {
         Handle<Name> key(descs->GetKey(i));
-        Handle<Object> value(
-            object->RawFastPropertyAt(descs->GetFieldIndex(i)), isolate);
+        Handle<Object> value =
+            TaggedFastPropertyAt(object, descs->GetFieldIndex(i));
         PropertyDetails d =
             PropertyDetails(details.attributes(), NORMAL, i + 1);
         dictionary = NameDictionaryAdd(dictionary, key, value, d);
@@ -4610,6 +4708,9 @@ void JSObject::NormalizeProperties(Handle<JSObject> object,
   ASSERT(instance_size_delta >= 0);
   isolate->heap()->CreateFillerObjectAt(object->address() + new_instance_size,
                                         instance_size_delta);
+  isolate->heap()->ClearRecordedSlotRange(
+      object->address() + new_instance_size,
+      object->address() + map->instance_size());
   if (Marking::IsBlack(Marking::MarkBitFrom(*object))) {
     MemoryChunk::IncrementLiveBytesFromMutator(object->address(),
                                                -instance_size_delta);
@@ -4618,6 +4719,15 @@ void JSObject::NormalizeProperties(Handle<JSObject> object,
   object->set_map(*new_map);
   map->NotifyLeafMapLayoutChange();
 
+  // Kept inobject slots that held unboxed doubles are tagged from now on.
+  if (map->HasUnboxedDoubleFields()) {
+    int inobject = new_map->inobject_properties();
+    for (int i = 0; i < inobject; i++) {
+      if (!map->IsUnboxedDoubleField(i)) continue;
+      object->InObjectPropertyAtPut(i, Smi::FromInt(0), SKIP_WRITE_BARRIER);
+    }
+  }
+
   object->set_properties(*dictionary);
 
   isolate->counters()->props_to_dictionary()->Increment();
@@ -5773,6 +5883,8 @@ Handle<JSObject> JSObjectWalkVisitor::StructureWalk(Handle<JSObject> object) {
       PropertyDetails details = descriptors->GetDetails(i);
       if (details.type() != FIELD) continue;
       int index = descriptors->GetFieldIndex(i);
+      // Unboxed doubles were copied with the object and hold no references.
+      if (copy->IsUnboxedDoubleField(index)) continue;
       Handle<Object> value(object->RawFastPropertyAt(index), isolate);
       if (value->IsJSObject()) {
         value = VisitElementOrProperty(copy, Handle<JSObject>::cast(value));
@@ -6621,7 +6733,15 @@ Object* JSObject::SlowReverseLookup(Object* value) {
     DescriptorArray* descs = map()->instance_descriptors();
     for (int i = 0; i < number_of_own_descriptors; i++) {
       if (descs->GetType(i) == FIELD) {
-        Object* property = RawFastPropertyAt(descs->GetFieldIndex(i));
+        int field_index = descs->GetFieldIndex(i);
+        if (IsUnboxedDoubleField(field_index)) {
+          if (value->IsNumber() &&
+              RawFastDoublePropertyAt(field_index) == value->Number()) {
+            return descs->GetKey(i);
+          }
+          continue;
+        }
+        Object* property = RawFastPropertyAt(field_index);
         if (FLAG_track_double_fields &&
             descs->GetDetails(i).representation().IsDouble()) {
           ASSERT(property->IsHeapNumber());
@@ -6828,6 +6948,7 @@ MaybeObject* Map::CopyReplaceDescriptors(DescriptorArray* descriptors,
     result->SetBackPointer(this);
   } else {
     descriptors->InitializeRepresentations(Representation::Tagged());
+    result->UpdateLayoutDescriptor();
   }
 
   return result;
@@ -14983,6 +15104,13 @@ MaybeObject* StringTable::LookupKey(HashTableKey* key, Object** s) {
 }
 
 
+MaybeObject* StringTable::Shrink() {
+  // The key is only used to rehash the existing entries.
+  InternalizedStringKey key(GetHeap()->empty_string());
+  return HashTable<StringTableShape, HashTableKey*>::Shrink(&key);
+}
+
+
 // The key for the script compilation cache is dependent on the mode flags,
 // because they change the global language mode and thus binding behaviour.
 // If flags change at some point, we must ensure that we do not hit the cache
@@ -1723,6 +1723,14 @@ class HeapObject: public Object {
   inline MapWord map_word();
   inline void set_map_word(MapWord map_word);
 
+  // Versions of the map word accessors that can be used while several
+  // threads install forwarding addresses concurrently (parallel scavenges).
+  // The compare-and-swap returns true if the map word was still
+  // |old_map_word| and has been replaced by |new_map_word|.
+  inline MapWord acquire_map_word();
+  inline bool release_compare_and_swap_map_word(MapWord old_map_word,
+                                                MapWord new_map_word);
+
   // The Heap the object was allocated in. Used also to access Isolate.
   inline Heap* GetHeap();
 
@@ -2509,6 +2517,14 @@ class JSObject: public JSReceiver {
   inline Object* RawFastPropertyAt(int index);
   inline void FastPropertyAtPut(int index, Object* value);
 
+  // Access to fields whose double value is stored unboxed in the object.
+  // Use TaggedFastPropertyAt to read a field that may be unboxed.
+  inline bool IsUnboxedDoubleField(int index);
+  inline double RawFastDoublePropertyAt(int index);
+  inline void RawFastDoublePropertyAtPut(int index, double value);
+  static Handle<Object> TaggedFastPropertyAt(Handle<JSObject> object,
+                                             int index);
+
   // Access to in object properties.
   inline int GetInObjectPropertyOffset(int index);
   inline Object* InObjectPropertyAt(int index);
@@ -2651,6 +2667,11 @@ class JSObject: public JSReceiver {
     static inline int SizeOf(Map* map, HeapObject* object);
   };
 
+  // Visits the tagged slots of an object whose map has unboxed double fields.
+  void JSObjectIterateBodyWithUnboxedDoubles(Map* map,
+                                             int object_size,
+                                             ObjectVisitor* v);
+
   // Enqueue change record for Object.observe. May cause GC.
   static void EnqueueChangeRecord(Handle<JSObject> object,
                                   const char* type,
@@ -3732,6 +3753,10 @@ class StringTable: public HashTable<StringTableShape, HashTableKey*> {
   bool LookupStringIfExists(String* str, String** result);
   bool LookupTwoCharsStringIfExists(uint16_t c1, uint16_t c2, String** result);
 
+  // Returns a smaller copy of the table if it is sparse, e.g. after many
+  // strings died, or the table itself otherwise.
+  MUST_USE_RESULT MaybeObject* Shrink();
+
   // Casting.
   static inline StringTable* cast(Object* obj);
 
@@ -4108,6 +4133,7 @@ class ObjectHashTable: public HashTable<ObjectHashTableShape<2>, Object*> {
                                      Handle<Object> value);
 
  private:
+  friend class IncrementalMarking;
   friend class MarkCompactCollector;
 
   void AddEntry(int entry, Object* key, Object* value);
@@ -5673,6 +5699,24 @@ class Map: public HeapObject {
   class IsUnstable:                 public BitField<bool, 29,  1> {};
   class IsMigrationTarget:          public BitField<bool, 30,  1> {};
 
+  // Layout descriptor. Bit i is set when the field with index i holds a
+  // double stored unboxed in the object, i.e. the 8 bytes of the in-object
+  // slot are the raw value rather than a tagged pointer. Only maintained for
+  // JS_OBJECT_TYPE maps when --unbox-double-fields is on, and only the first
+  // kMaxUnboxedDoubleFields fields are considered. A bit is only meaningful
+  // while the field is in-object, which is checked at query time so that the
+  // descriptor survives changes to inobject_properties().
+  inline int layout_descriptor();
+  inline void set_layout_descriptor(int value);
+  inline bool HasUnboxedDoubleFields();
+  inline bool IsUnboxedDoubleField(int field_index);
+  inline bool IsUnboxedDoubleFieldOffset(int offset);
+  // Recomputes the layout descriptor from the own descriptors and updates
+  // the visitor id if the set of unboxed fields changed.
+  void UpdateLayoutDescriptor();
+
+  static const int kMaxUnboxedDoubleFields = 31;
+
   // Tells whether the object in the prototype property will be used
   // for instances created from this function.  If the prototype
   // property is set to a value that is not a JSObject, the prototype
@@ -5977,6 +6021,7 @@ class Map: public HeapObject {
   void SetNumberOfOwnDescriptors(int number) {
     ASSERT(number <= instance_descriptors()->number_of_descriptors());
     set_bit_field3(NumberOfOwnDescriptorsBits::update(bit_field3(), number));
+    UpdateLayoutDescriptor();
   }
 
   inline Cell* RetrieveDescriptorsPointer();
@@ -6223,12 +6268,14 @@ class Map: public HeapObject {
   static const int kCodeCacheOffset = kDescriptorsOffset + kPointerSize;
   static const int kDependentCodeOffset = kCodeCacheOffset + kPointerSize;
   static const int kBitField3Offset = kDependentCodeOffset + kPointerSize;
-  static const int kSize = kBitField3Offset + kPointerSize;
+  static const int kLayoutDescriptorOffset = kBitField3Offset + kPointerSize;
+  static const int kSize = kLayoutDescriptorOffset + kPointerSize;
 
   // Layout of pointer fields. Heap iteration code relies on them
   // being continuously allocated.
   static const int kPointerFieldsBeginOffset = Map::kPrototypeOffset;
-  static const int kPointerFieldsEndOffset = kBitField3Offset + kPointerSize;
+  static const int kPointerFieldsEndOffset =
+      kLayoutDescriptorOffset + kPointerSize;
 
   // Byte offsets within kInstanceSizesOffset.
   static const int kInstanceSizeOffset = kInstanceSizesOffset + 0;
@@ -39,6 +39,8 @@ namespace internal {
 
 OptimizingCompilerThread::~OptimizingCompilerThread() {
   ASSERT_EQ(0, input_queue_length_);
+  for (int i = 0; i < number_of_workers_; i++) delete workers_[i];
+  DeleteArray(workers_);
   DeleteArray(input_queue_);
   if (FLAG_concurrent_osr) {
 #ifdef DEBUG
@@ -51,10 +53,23 @@ OptimizingCompilerThread::~OptimizingCompilerThread() {
 }
 
 
-void OptimizingCompilerThread::Run() {
+void OptimizingCompilerThread::Start() {
+  for (int i = 0; i < number_of_workers_; i++) workers_[i]->Start();
+}
+
+
+int OptimizingCompilerThread::NumberOfWorkers() {
+  // The HTracer and the HStatistics are shared by all jobs and are written
+  // to from OptimizeGraph without synchronization.
+  if (FLAG_trace_hydrogen || FLAG_hydrogen_stats) return 1;
+  return Max(1, FLAG_concurrent_recompilation_threads);
+}
+
+
+void OptimizingCompilerThread::Run(WorkerThread* worker) {
 #ifdef DEBUG
   { LockGuard<Mutex> lock_guard(&thread_id_mutex_);
-    thread_id_ = ThreadId::Current().ToInteger();
+    thread_ids_.Add(ThreadId::Current().ToInteger());
   }
 #endif
   Isolate::SetIsolateThreadLocals(isolate_, NULL);
@@ -79,17 +94,15 @@ void OptimizingCompilerThread::Run() {
         break;
       case STOP:
         if (FLAG_trace_concurrent_recompilation) {
-          time_spent_total_ = total_timer.Elapsed();
+          worker->time_spent_total_ = total_timer.Elapsed();
         }
         stop_semaphore_.Signal();
         return;
       case FLUSH:
-        // The main thread is blocked, waiting for the stop semaphore.
-        { AllowHandleDereference allow_handle_dereference;
-          FlushInputQueue(true);
-        }
-        Release_Store(&stop_thread_, static_cast<AtomicWord>(CONTINUE));
+        // The main thread flushes the input queue once all workers are
+        // parked here.
         stop_semaphore_.Signal();
+        resume_semaphore_.Wait();
         // Return to start of consumer loop.
         continue;
     }
@@ -100,7 +113,7 @@ void OptimizingCompilerThread::Run() {
     CompileNext();
 
     if (FLAG_trace_concurrent_recompilation) {
-      time_spent_compiling_ += compiling_timer.Elapsed();
+      worker->time_spent_compiling_ += compiling_timer.Elapsed();
     }
   }
 }
@@ -120,6 +133,7 @@ RecompileJob* OptimizingCompilerThread::NextInput() {
 void OptimizingCompilerThread::CompileNext() {
   RecompileJob* job = NextInput();
   ASSERT_NE(NULL, job);
+  job->MarkDequeued();
 
   // The function may have already been optimized by OSR.  Simply continue.
   RecompileJob::Status status = job->OptimizeGraph();
@@ -129,7 +143,10 @@ void OptimizingCompilerThread::CompileNext() {
   // The function may have already been optimized by OSR.  Simply continue.
   // Use a mutex to make sure that functions marked for install
   // are always also queued.
-  output_queue_.Enqueue(job);
+  job->MarkCompiled();
+  { LockGuard<Mutex> access_output_queue(&output_queue_mutex_);
+    output_queue_.Enqueue(job);
+  }
   isolate_->stack_guard()->RequestInstallCode();
 }
 
@@ -189,8 +206,13 @@ void OptimizingCompilerThread::Flush() {
   ASSERT(!IsOptimizerThread());
   Release_Store(&stop_thread_, static_cast<AtomicWord>(FLUSH));
   if (FLAG_block_concurrent_recompilation) Unblock();
-  input_queue_semaphore_.Signal();
-  stop_semaphore_.Wait();
+  for (int i = 0; i < number_of_workers_; i++) input_queue_semaphore_.Signal();
+  for (int i = 0; i < number_of_workers_; i++) stop_semaphore_.Wait();
+  // Each worker consumed one signal of the input queue semaphore to park,
+  // so the remaining signals match the jobs left in the input queue.
+  FlushInputQueue(true);
+  Release_Store(&stop_thread_, static_cast<AtomicWord>(CONTINUE));
+  for (int i = 0; i < number_of_workers_; i++) resume_semaphore_.Signal();
   FlushOutputQueue(true);
   if (FLAG_concurrent_osr) FlushOsrBuffer(true);
   if (FLAG_trace_concurrent_recompilation) {
@@ -203,8 +225,8 @@ void OptimizingCompilerThread::Stop() {
   ASSERT(!IsOptimizerThread());
   Release_Store(&stop_thread_, static_cast<AtomicWord>(STOP));
   if (FLAG_block_concurrent_recompilation) Unblock();
-  input_queue_semaphore_.Signal();
-  stop_semaphore_.Wait();
+  for (int i = 0; i < number_of_workers_; i++) input_queue_semaphore_.Signal();
+  for (int i = 0; i < number_of_workers_; i++) stop_semaphore_.Wait();
 
   if (FLAG_concurrent_recompilation_delay != 0) {
     // At this point the optimizing compiler thread's event loop has stopped.
@@ -219,8 +241,13 @@ void OptimizingCompilerThread::Stop() {
   if (FLAG_concurrent_osr) FlushOsrBuffer(false);
 
   if (FLAG_trace_concurrent_recompilation) {
-    double percentage = time_spent_compiling_.PercentOf(time_spent_total_);
-    PrintF("  ** Compiler thread did %.2f%% useful work\n", percentage);
+    for (int i = 0; i < number_of_workers_; i++) {
+      WorkerThread* worker = workers_[i];
+      double percentage = worker->time_spent_compiling_.PercentOf(
+          worker->time_spent_total_);
+      PrintF("  ** Compiler thread %d did %.2f%% useful work\n",
+             i, percentage);
+    }
   }
 
   if ((FLAG_trace_osr || FLAG_trace_concurrent_recompilation) &&
@@ -228,7 +255,7 @@ void OptimizingCompilerThread::Stop() {
     PrintF("[COSR hit rate %d / %d]\n", osr_hits_, osr_attempts_);
   }
 
-  Join();
+  for (int i = 0; i < number_of_workers_; i++) workers_[i]->Join();
 }
 
 
@@ -237,7 +264,13 @@ void OptimizingCompilerThread::InstallOptimizedFunctions() {
   HandleScope handle_scope(isolate_);
 
   RecompileJob* job;
+  // The latency histograms are only sampled here, on the main thread.
+  Counters* counters = isolate_->counters();
   while (output_queue_.Dequeue(&job)) {
+    counters->concurrent_recompilation_queue_latency()->AddSample(
+        static_cast<int>(job->time_in_queue().InMilliseconds()));
+    counters->concurrent_recompilation_install_latency()->AddSample(
+        static_cast<int>(job->time_since_compiled().InMilliseconds()));
     CompilationInfo* info = job->info();
     if (info->is_osr()) {
       if (FLAG_trace_osr) {
@@ -258,6 +291,7 @@ void OptimizingCompilerThread::InstallOptimizedFunctions() {
 void OptimizingCompilerThread::QueueForOptimization(RecompileJob* job) {
   ASSERT(IsQueueAvailable());
   ASSERT(!IsOptimizerThread());
+  job->MarkQueued();
   CompilationInfo* info = job->info();
   if (info->is_osr()) {
     if (FLAG_trace_concurrent_recompilation) {
@@ -373,7 +407,7 @@ void OptimizingCompilerThread::AddToOsrBuffer(RecompileJob* job) {
 bool OptimizingCompilerThread::IsOptimizerThread() {
   if (!FLAG_concurrent_recompilation) return false;
   LockGuard<Mutex> lock_guard(&thread_id_mutex_);
-  return ThreadId::Current().ToInteger() == thread_id_;
+  return thread_ids_.Contains(ThreadId::Current().ToInteger());
 }
 #endif
 
@@ -43,20 +43,23 @@ class HOptimizedGraphBuilder;
 class RecompileJob;
 class SharedFunctionInfo;
 
-class OptimizingCompilerThread : public Thread {
+// Runs the OptimizeGraph phase of recompile jobs on a pool of
+// --concurrent-recompilation-threads worker threads.  The workers share one
+// input queue, in which OSR jobs go ahead of regular ones, and one output
+// queue that the main thread drains in batches.
+class OptimizingCompilerThread {
  public:
   explicit OptimizingCompilerThread(Isolate *isolate) :
-      Thread("OptimizingCompilerThread"),
-#ifdef DEBUG
-      thread_id_(0),
-#endif
       isolate_(isolate),
+      number_of_workers_(NumberOfWorkers()),
       stop_semaphore_(0),
+      resume_semaphore_(0),
       input_queue_semaphore_(0),
-      input_queue_capacity_(FLAG_concurrent_recompilation_queue_length),
+      input_queue_capacity_(FLAG_concurrent_recompilation_queue_length *
+                            number_of_workers_),
       input_queue_length_(0),
       input_queue_shift_(0),
-      osr_buffer_capacity_(FLAG_concurrent_recompilation_queue_length + 4),
+      osr_buffer_capacity_(input_queue_capacity_ + 4),
       osr_buffer_cursor_(0),
       osr_hits_(0),
       osr_attempts_(0),
@@ -68,11 +71,15 @@ class OptimizingCompilerThread : public Thread {
       osr_buffer_ = NewArray<RecompileJob*>(osr_buffer_capacity_);
       for (int i = 0; i < osr_buffer_capacity_; i++) osr_buffer_[i] = NULL;
     }
+    workers_ = NewArray<WorkerThread*>(number_of_workers_);
+    for (int i = 0; i < number_of_workers_; i++) {
+      workers_[i] = new WorkerThread(this);
+    }
   }
 
   ~OptimizingCompilerThread();
 
-  void Run();
+  void Start();
   void Stop();
   void Flush();
   void QueueForOptimization(RecompileJob* optimizing_compiler);
@@ -103,6 +110,23 @@ class OptimizingCompilerThread : public Thread {
  private:
   enum StopFlag { CONTINUE, STOP, FLUSH };
 
+  class WorkerThread : public Thread {
+   public:
+    explicit WorkerThread(OptimizingCompilerThread* pool)
+        : Thread("OptimizingCompilerThread"), pool_(pool) { }
+
+    void Run() { pool_->Run(this); }
+
+    OptimizingCompilerThread* pool_;
+    TimeDelta time_spent_compiling_;
+    TimeDelta time_spent_total_;
+  };
+
+  // The number of worker threads to start.  Flags that make OptimizeGraph
+  // write to isolate-wide sinks that are not thread-safe limit it to one.
+  static int NumberOfWorkers();
+
+  void Run(WorkerThread* worker);
   void FlushInputQueue(bool restore_function_code);
   void FlushOutputQueue(bool restore_function_code);
   void FlushOsrBuffer(bool restore_function_code);
@@ -121,15 +145,22 @@ class OptimizingCompilerThread : public Thread {
   }
 
 #ifdef DEBUG
-  int thread_id_;
+  List<int> thread_ids_;
   Mutex thread_id_mutex_;
 #endif
 
   Isolate* isolate_;
+  WorkerThread** workers_;
+  int number_of_workers_;
+
+  // Every worker signals the stop semaphore once when it stops or parks for
+  // a flush.  Parked workers wait on the resume semaphore.
   Semaphore stop_semaphore_;
+  Semaphore resume_semaphore_;
   Semaphore input_queue_semaphore_;
 
-  // Circular queue of incoming recompilation tasks (including OSR).
+  // Circular queue of incoming recompilation tasks.  OSR tasks are added to
+  // the front, since the function is running and waits for the code.
   RecompileJob** input_queue_;
   int input_queue_capacity_;
   int input_queue_length_;
@@ -137,7 +168,10 @@ class OptimizingCompilerThread : public Thread {
   Mutex input_queue_mutex_;
 
   // Queue of recompilation tasks ready to be installed (excluding OSR).
+  // UnboundQueue supports a single producer only, so the workers serialize
+  // their Enqueue calls on the mutex.  The main thread is the only consumer.
   UnboundQueue<RecompileJob*> output_queue_;
+  Mutex output_queue_mutex_;
 
   // Cyclic buffer of recompilation tasks for OSR.
   RecompileJob** osr_buffer_;
@@ -145,8 +179,6 @@ class OptimizingCompilerThread : public Thread {
   int osr_buffer_cursor_;
 
   volatile AtomicWord stop_thread_;
-  TimeDelta time_spent_compiling_;
-  TimeDelta time_spent_total_;
 
   int osr_hits_;
   int osr_attempts_;
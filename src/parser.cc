@@ -5774,13 +5774,47 @@ int ScriptDataImpl::ReadNumber(byte** source) {
 }
 
 
+static unsigned ComputeSourceHash(Utf16CharacterStream* source) {
+  uint32_t hash = 0;
+  for (int32_t c = source->Advance(); c >= 0; c = source->Advance()) {
+    hash = StringHasher::AddCharacterCore(hash, static_cast<uint16_t>(c));
+  }
+  return StringHasher::GetHashCore(hash);
+}
+
+
+void ScriptDataImpl::SetSourceAndFlagHash(Utf16CharacterStream* source) {
+  ASSERT(owns_store_);
+  store_[PreparseDataConstants::kSourceHashOffset] = ComputeSourceHash(source);
+  store_[PreparseDataConstants::kFlagHashOffset] = FlagList::Hash();
+}
+
+
+bool ScriptDataImpl::Matches(Handle<String> source) {
+  ASSERT(SanityCheck());
+  if (flag_hash() != FlagList::Hash()) return false;
+  GenericStringUtf16CharacterStream stream(source, 0, source->length());
+  return source_hash() == ComputeSourceHash(&stream);
+}
+
+
 // Create a Scanner for the preparser to use as input, and preparse the source.
 ScriptDataImpl* PreParserApi::PreParse(Isolate* isolate,
                                        Utf16CharacterStream* source) {
-  CompleteParserRecorder recorder;
   HistogramTimerScope timer(isolate->counters()->pre_parse());
-  Scanner scanner(isolate->unicode_cache());
-  intptr_t stack_limit = isolate->stack_guard()->real_climit();
+  ScriptDataImpl* data = PreParse(isolate->unicode_cache(),
+                                  isolate->stack_guard()->real_climit(),
+                                  source);
+  if (data == NULL) isolate->StackOverflow();
+  return data;
+}
+
+
+ScriptDataImpl* PreParserApi::PreParse(UnicodeCache* unicode_cache,
+                                       uintptr_t stack_limit,
+                                       Utf16CharacterStream* source) {
+  CompleteParserRecorder recorder;
+  Scanner scanner(unicode_cache);
   PreParser preparser(&scanner, &recorder, stack_limit);
   preparser.set_allow_lazy(true);
   preparser.set_allow_generators(FLAG_harmony_generators);
@@ -5789,10 +5823,7 @@ ScriptDataImpl* PreParserApi::PreParse(Isolate* isolate,
   preparser.set_allow_harmony_numeric_literals(FLAG_harmony_numeric_literals);
   scanner.Initialize(source);
   PreParser::PreParseResult result = preparser.PreParseProgram();
-  if (result == PreParser::kPreParseStackOverflow) {
-    isolate->StackOverflow();
-    return NULL;
-  }
+  if (result == PreParser::kPreParseStackOverflow) return NULL;
 
   // Extract the accumulated data from the recorder as a single
   // contiguous vector that we are responsible for disposing.
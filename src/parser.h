@@ -135,6 +135,19 @@ class ScriptDataImpl : public ScriptData {
   bool has_error() { return store_[PreparseDataConstants::kHasErrorOffset]; }
   unsigned magic() { return store_[PreparseDataConstants::kMagicOffset]; }
   unsigned version() { return store_[PreparseDataConstants::kVersionOffset]; }
+  unsigned source_hash() {
+    return store_[PreparseDataConstants::kSourceHashOffset];
+  }
+  unsigned flag_hash() {
+    return store_[PreparseDataConstants::kFlagHashOffset];
+  }
+
+  // Records the source and the flags the data is produced for, so that
+  // data kept by the embedder across runs can be checked before use.
+  void SetSourceAndFlagHash(Utf16CharacterStream* source);
+  // Returns true if the data was produced for the given source with the
+  // current flags.
+  bool Matches(Handle<String> source);
 
  private:
   Vector<unsigned> store_;
@@ -172,6 +185,12 @@ class PreParserApi {
   // the preparser doesn't know about ScriptDataImpl.
   static ScriptDataImpl* PreParse(Isolate* isolate,
                                   Utf16CharacterStream* source);
+
+  // Same as above, but does not use the isolate so that it can be called on
+  // a background thread.  Returns NULL on stack overflow.
+  static ScriptDataImpl* PreParse(UnicodeCache* unicode_cache,
+                                  uintptr_t stack_limit,
+                                  Utf16CharacterStream* source);
 };
 
 
@@ -52,7 +52,9 @@ FunctionLoggingParserRecorder::FunctionLoggingParserRecorder()
   preamble_[PreparseDataConstants::kFunctionsSizeOffset] = 0;
   preamble_[PreparseDataConstants::kSymbolCountOffset] = 0;
   preamble_[PreparseDataConstants::kSizeOffset] = 0;
-  ASSERT_EQ(6, PreparseDataConstants::kHeaderSize);
+  preamble_[PreparseDataConstants::kSourceHashOffset] = 0;
+  preamble_[PreparseDataConstants::kFlagHashOffset] = 0;
+  ASSERT_EQ(8, PreparseDataConstants::kHeaderSize);
 #ifdef DEBUG
   prev_start_ = -1;
 #endif
@@ -155,6 +155,11 @@ class PropertyIndex {
     return field_index() < holder->map()->inobject_properties();
   }
 
+  bool is_unboxed_double(Handle<JSObject> holder) {
+    if (is_header_index()) return false;
+    return holder->map()->IsUnboxedDoubleField(field_index());
+  }
+
   int translate(Handle<JSObject> holder) {
     if (is_header_index()) return header_index();
     int index = field_index() - holder->map()->inobject_properties();
@@ -351,6 +356,10 @@ class LookupResult BASE_EMBEDDED {
   Object* GetLazyValue() {
     switch (type()) {
       case FIELD:
+        // Callers look for heap objects only, which unboxed doubles are not.
+        if (holder()->IsUnboxedDoubleField(GetFieldIndex().field_index())) {
+          return isolate()->heap()->undefined_value();
+        }
         return holder()->RawFastPropertyAt(GetFieldIndex().field_index());
       case NORMAL: {
         Object* value;
@@ -733,7 +733,7 @@ bool Runtime::SetupArrayBufferAllocatingData(
 
   SetupArrayBuffer(isolate, array_buffer, false, data, allocated_length);
 
-  isolate->heap()->AdjustAmountOfExternalAllocatedMemory(allocated_length);
+  isolate->heap()->array_buffer_tracker()->RegisterNew(*array_buffer);
 
   return true;
 }
@@ -1492,12 +1492,24 @@ RUNTIME_FUNCTION(MaybeObject*, Runtime_MapGetSize) {
 }
 
 
+// Installs a new backing table.  Incremental marking may have marked the old
+// table black without scanning it or recording its slots, so it is zapped.
+static void WeakCollectionReplaceTable(JSWeakCollection* weak_collection,
+                                       ObjectHashTable* new_table) {
+  Object* old_table = weak_collection->table();
+  weak_collection->set_table(new_table);
+  if (old_table->IsHashTable() && old_table != new_table) {
+    FixedArray* old_array = FixedArray::cast(old_table);
+    for (int i = 0; i < old_array->length(); i++) old_array->set_the_hole(i);
+  }
+}
+
+
 static JSWeakCollection* WeakCollectionInitialize(Isolate* isolate,
     Handle<JSWeakCollection> weak_collection) {
   ASSERT(weak_collection->map()->inobject_properties() == 0);
   Handle<ObjectHashTable> table = isolate->factory()->NewObjectHashTable(0);
-  weak_collection->set_table(*table);
-  weak_collection->set_next(Smi::FromInt(0));
+  WeakCollectionReplaceTable(*weak_collection, *table);
   return *weak_collection;
 }
 
@@ -1544,7 +1556,7 @@ RUNTIME_FUNCTION(MaybeObject*, Runtime_WeakCollectionDelete) {
   Handle<Object> lookup(table->Lookup(*key), isolate);
   Handle<ObjectHashTable> new_table =
       ObjectHashTable::Put(table, key, isolate->factory()->the_hole_value());
-  weak_collection->set_table(*new_table);
+  WeakCollectionReplaceTable(*weak_collection, *new_table);
   return isolate->heap()->ToBoolean(!lookup->IsTheHole());
 }
 
@@ -1558,7 +1570,7 @@ RUNTIME_FUNCTION(MaybeObject*, Runtime_WeakCollectionSet) {
   Handle<ObjectHashTable> table(
       ObjectHashTable::cast(weak_collection->table()));
   Handle<ObjectHashTable> new_table = ObjectHashTable::Put(table, key, value);
-  weak_collection->set_table(*new_table);
+  WeakCollectionReplaceTable(*weak_collection, *new_table);
   return isolate->heap()->undefined_value();
 }
 
@@ -14832,14 +14844,21 @@ void Runtime::PerformGC(Object* result, Isolate* isolate) {
 
     // Try to do a garbage collection; ignore it if it fails. The C
     // entry stub will throw an out-of-memory exception in that case.
+    AllocationFailureGCScope gc_scope(isolate->heap());
     isolate->heap()->CollectGarbage(failure->allocation_space(),
                                     "Runtime::PerformGC");
   } else {
     // Handle last resort GC and make sure to allow future allocations
     // to grow the heap without causing GCs (if possible).
     isolate->counters()->gc_last_resort_from_js()->Increment();
-    isolate->heap()->CollectAllGarbage(Heap::kNoGCFlags,
-                                       "Runtime::PerformGC");
+    {
+      AllocationFailureGCScope gc_scope(isolate->heap());
+      isolate->heap()->CollectAllGarbage(Heap::kNoGCFlags,
+                                         "Runtime::PerformGC");
+    }
+    if (isolate->heap()->IsCloseToOutOfMemory()) {
+      isolate->heap()->InvokeNearHeapLimitCallback();
+    }
   }
 }
 
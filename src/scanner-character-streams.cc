@@ -302,6 +302,118 @@ void Utf8ToUtf16CharacterStream::SetRawPosition(unsigned target_position) {
 }
 
 
+// ----------------------------------------------------------------------------
+// StreamingUtf16CharacterStream
+
+StreamingUtf16CharacterStream::StreamingUtf16CharacterStream(Encoding encoding)
+    : BufferedUtf16CharacterStream(),
+      encoding_(encoding),
+      end_of_input_(false),
+      data_added_(0) { }
+
+
+StreamingUtf16CharacterStream::~StreamingUtf16CharacterStream() { }
+
+
+void StreamingUtf16CharacterStream::AddChunk(const byte* data,
+                                             unsigned length) {
+  {
+    LockGuard<Mutex> lock_guard(&mutex_);
+    ASSERT(!end_of_input_);
+    added_data_.AddAll(Vector<byte>(const_cast<byte*>(data), length));
+  }
+  data_added_.Signal();
+}
+
+
+void StreamingUtf16CharacterStream::SignalEndOfInput() {
+  {
+    LockGuard<Mutex> lock_guard(&mutex_);
+    end_of_input_ = true;
+  }
+  data_added_.Signal();
+}
+
+
+void StreamingUtf16CharacterStream::Rewind() {
+  pushback_limit_ = NULL;
+  buffer_cursor_ = buffer_;
+  buffer_end_ = buffer_;
+  pos_ = 0;
+}
+
+
+unsigned StreamingUtf16CharacterStream::BufferSeekForward(unsigned delta) {
+  unsigned old_pos = pos_;
+  DecodeUntil(pos_ + delta);
+  pos_ = Min(pos_ + delta, static_cast<unsigned>(characters_.length()));
+  ReadBlock();
+  return pos_ - old_pos;
+}
+
+
+unsigned StreamingUtf16CharacterStream::FillBuffer(unsigned position,
+                                                   unsigned length) {
+  DecodeUntil(position + length);
+  unsigned available = static_cast<unsigned>(characters_.length());
+  if (position >= available) return 0;
+  length = Min(length, available - position);
+  CopyChars(buffer_, &characters_[position], length);
+  return length;
+}
+
+
+void StreamingUtf16CharacterStream::DecodeUntil(unsigned length) {
+  bool end_of_input = false;
+  while (static_cast<unsigned>(characters_.length()) < length &&
+         !end_of_input) {
+    {
+      LockGuard<Mutex> lock_guard(&mutex_);
+      raw_data_.AddAll(added_data_);
+      added_data_.Rewind(0);
+      end_of_input = end_of_input_;
+    }
+    int decoded = characters_.length();
+    Decode(end_of_input);
+    // Wait for the producer if nothing could be decoded.  Signals for data
+    // that has already been taken are harmless, they just cause another
+    // iteration.
+    if (characters_.length() == decoded && !end_of_input) {
+      data_added_.Wait();
+    }
+  }
+}
+
+
+void StreamingUtf16CharacterStream::Decode(bool end_of_input) {
+  static const unibrow::uchar kMaxUtf16Character = 0xffff;
+  unsigned raw_length = static_cast<unsigned>(raw_data_.length());
+  unsigned pos = 0;
+  while (pos < raw_length) {
+    unibrow::uchar c = raw_data_[pos];
+    if (encoding_ == ONE_BYTE || c <= unibrow::Utf8::kMaxOneByteChar) {
+      pos++;
+    } else {
+      unsigned sequence_length = c < 0xE0 ? 2 : (c < 0xF0 ? 3 : 4);
+      if (pos + sequence_length > raw_length && !end_of_input) break;
+      c = unibrow::Utf8::CalculateValue(&raw_data_[pos],
+                                        raw_length - pos,
+                                        &pos);
+    }
+    if (c > kMaxUtf16Character) {
+      characters_.Add(unibrow::Utf16::LeadSurrogate(c));
+      characters_.Add(unibrow::Utf16::TrailSurrogate(c));
+    } else {
+      characters_.Add(static_cast<uc16>(c));
+    }
+  }
+  // Keep the bytes of an incomplete sequence at the start of raw_data_.
+  unsigned remaining = raw_length - pos;
+  for (unsigned i = 0; i < remaining; i++) raw_data_[i] = raw_data_[pos + i];
+  raw_data_.Rewind(remaining);
+}
+
+
 // ----------------------------------------------------------------------------
 // ExternalTwoByteStringUtf16CharacterStream
 
@@ -28,6 +28,8 @@
 #ifndef V8_SCANNER_CHARACTER_STREAMS_H_
 #define V8_SCANNER_CHARACTER_STREAMS_H_
 
+#include "platform/mutex.h"
+#include "platform/semaphore.h"
 #include "scanner.h"
 
 namespace v8 {
@@ -97,6 +99,50 @@ class Utf8ToUtf16CharacterStream: public BufferedUtf16CharacterStream {
 };
 
 
+// Utf16 stream based on a Latin-1 or UTF-8 source that arrives in chunks,
+// possibly from another thread.  Reading past the data that has been added
+// so far blocks until more data is added or the end of input is signalled.
+class StreamingUtf16CharacterStream: public BufferedUtf16CharacterStream {
+ public:
+  enum Encoding { ONE_BYTE, UTF8 };
+
+  explicit StreamingUtf16CharacterStream(Encoding encoding);
+  virtual ~StreamingUtf16CharacterStream();
+
+  // Called by the producer.  The data is copied.
+  void AddChunk(const byte* data, unsigned length);
+  void SignalEndOfInput();
+
+  // Moves back to the start of the source so that it can be read again.
+  void Rewind();
+
+ protected:
+  virtual unsigned BufferSeekForward(unsigned delta);
+  virtual unsigned FillBuffer(unsigned position, unsigned length);
+
+ private:
+  // Decodes added data until |length| characters are available or the end
+  // of input has been reached.
+  void DecodeUntil(unsigned length);
+  // Decodes the complete characters in raw_data_.  An incomplete UTF-8
+  // sequence at the end is kept for the next chunk unless the end of input
+  // has been reached.
+  void Decode(bool end_of_input);
+
+  Encoding encoding_;
+  // Characters decoded so far, and the bytes still to be decoded.  Only
+  // accessed by the consumer.
+  List<uc16> characters_;
+  List<byte> raw_data_;
+
+  // Data added by the producer and not yet taken by the consumer.
+  Mutex mutex_;
+  List<byte> added_data_;
+  bool end_of_input_;
+  Semaphore data_added_;
+};
+
+
 // UTF16 buffer to read characters from an external string.
 class ExternalTwoByteStringUtf16CharacterStream: public Utf16CharacterStream {
  public:
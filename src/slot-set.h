@@ -0,0 +1,234 @@
+// Copyright 2013 the V8 project authors. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Google Inc. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef V8_SLOT_SET_H_
+#define V8_SLOT_SET_H_
+
+#include "allocation.h"
+#include "atomicops.h"
+#include "compiler-intrinsics.h"
+#include "globals.h"
+#include "utils.h"
+#include "v8globals.h"
+
+namespace v8 {
+namespace internal {
+
+// A set of pointer-sized slots in a region of 1 << kPageSizeBits bytes, used
+// by memory chunks to remember their slots that point to new space.  The set
+// is a bitmap with one bit per slot.  The bitmap is split into buckets that
+// are allocated when the first slot in them is inserted, so that regions with
+// only a few slots stay small.
+//
+// Cells are updated atomically because sweeper threads remove the slots of
+// the memory they free while the main thread inserts slots into the same
+// pages.  Only the main thread or the scavenger threads allocate buckets.
+class SlotSet : public Malloced {
+ public:
+  enum EmptyBucketMode {
+    FREE_EMPTY_BUCKETS,
+    // Used while sweeper threads may still be reading the buckets.
+    KEEP_EMPTY_BUCKETS
+  };
+
+  SlotSet() {
+    for (int i = 0; i < kBuckets; i++) buckets_[i] = NULL;
+  }
+
+  ~SlotSet() {
+    for (int i = 0; i < kBuckets; i++) ReleaseBucket(i);
+  }
+
+  // The offset is the offset of the slot from the start of the region.
+  void Insert(int slot_offset) {
+    int bucket_index, cell_index;
+    uint32_t mask;
+    SlotToIndices(slot_offset, &bucket_index, &cell_index, &mask);
+    uint32_t* bucket = LoadBucket(bucket_index);
+    if (bucket == NULL) bucket = AllocateBucket(bucket_index);
+    SetCellBits(&bucket[cell_index], mask);
+  }
+
+  bool Contains(int slot_offset) {
+    int bucket_index, cell_index;
+    uint32_t mask;
+    SlotToIndices(slot_offset, &bucket_index, &cell_index, &mask);
+    uint32_t* bucket = LoadBucket(bucket_index);
+    if (bucket == NULL) return false;
+    return (LoadCell(&bucket[cell_index]) & mask) != 0;
+  }
+
+  // Removes all slots in [start_offset, end_offset).  Both offsets are
+  // relative to the start of the region and end_offset may be the size of
+  // the region.  Buckets are never released here, so this is safe to call
+  // from sweeper threads.
+  void RemoveRange(int start_offset, int end_offset) {
+    ASSERT(IsAligned(start_offset, kPointerSize));
+    ASSERT(IsAligned(end_offset, kPointerSize));
+    ASSERT(0 <= start_offset && start_offset <= end_offset);
+    ASSERT(end_offset <= (1 << kPageSizeBits));
+    int slot = start_offset >> kPointerSizeLog2;
+    int end_slot = end_offset >> kPointerSizeLog2;
+    while (slot < end_slot) {
+      int bucket_index = slot >> kBitsPerBucketLog2;
+      uint32_t* bucket = LoadBucket(bucket_index);
+      if (bucket == NULL) {
+        slot = (bucket_index + 1) << kBitsPerBucketLog2;
+        continue;
+      }
+      int cell_index = (slot >> kBitsPerCellLog2) & (kCellsPerBucket - 1);
+      int bit_index = slot & (kBitsPerCell - 1);
+      int bits = Min(kBitsPerCell - bit_index, end_slot - slot);
+      uint32_t mask = (bits == kBitsPerCell)
+          ? ~0u
+          : ((1u << bits) - 1) << bit_index;
+      ClearCellBits(&bucket[cell_index], mask);
+      slot += bits;
+    }
+  }
+
+  // Removes all slots from the set and calls visitor->VisitSlot(address) for
+  // each of them in address order.  The visitor may insert slots again,
+  // including the one it is called for.  Buckets that are empty afterwards
+  // are released unless the mode is KEEP_EMPTY_BUCKETS.
+  template<typename Visitor>
+  void Iterate(Address region_start,
+               Visitor* visitor,
+               EmptyBucketMode mode) {
+    for (int bucket_index = 0; bucket_index < kBuckets; bucket_index++) {
+      uint32_t* bucket = LoadBucket(bucket_index);
+      if (bucket == NULL) continue;
+      for (int cell_index = 0; cell_index < kCellsPerBucket; cell_index++) {
+        if (LoadCell(&bucket[cell_index]) == 0) continue;
+        uint32_t cell = static_cast<uint32_t>(NoBarrier_AtomicExchange(
+            reinterpret_cast<volatile Atomic32*>(&bucket[cell_index]), 0));
+        int cell_start =
+            bucket_index * kBitsPerBucket + cell_index * kBitsPerCell;
+        while (cell != 0) {
+          int bit_index = CompilerIntrinsics::CountTrailingZeros(cell);
+          cell &= cell - 1;
+          visitor->VisitSlot(
+              region_start + ((cell_start + bit_index) << kPointerSizeLog2));
+        }
+      }
+      if (mode == FREE_EMPTY_BUCKETS && IsBucketEmpty(bucket_index)) {
+        ReleaseBucket(bucket_index);
+      }
+    }
+  }
+
+ private:
+  static const int kBitsPerCell = 32;
+  static const int kBitsPerCellLog2 = 5;
+  static const int kBitsPerBucket = 1024;
+  static const int kBitsPerBucketLog2 = 10;
+  static const int kCellsPerBucket = kBitsPerBucket / kBitsPerCell;
+  static const int kBuckets =
+      (1 << (kPageSizeBits - kPointerSizeLog2)) / kBitsPerBucket;
+
+  void SlotToIndices(int slot_offset,
+                     int* bucket_index,
+                     int* cell_index,
+                     uint32_t* mask) {
+    ASSERT(IsAligned(slot_offset, kPointerSize));
+    ASSERT(slot_offset >= 0 && slot_offset < (1 << kPageSizeBits));
+    int slot = slot_offset >> kPointerSizeLog2;
+    *bucket_index = slot >> kBitsPerBucketLog2;
+    *cell_index = (slot >> kBitsPerCellLog2) & (kCellsPerBucket - 1);
+    *mask = 1u << (slot & (kBitsPerCell - 1));
+  }
+
+  uint32_t* LoadBucket(int bucket_index) {
+    return reinterpret_cast<uint32_t*>(Acquire_Load(
+        reinterpret_cast<volatile AtomicWord*>(&buckets_[bucket_index])));
+  }
+
+  // Publishes a zeroed bucket.  If another scavenger thread got there first
+  // its bucket is used instead.
+  uint32_t* AllocateBucket(int bucket_index) {
+    uint32_t* bucket = NewArray<uint32_t>(kCellsPerBucket);
+    for (int i = 0; i < kCellsPerBucket; i++) bucket[i] = 0;
+    AtomicWord previous = Release_CompareAndSwap(
+        reinterpret_cast<volatile AtomicWord*>(&buckets_[bucket_index]),
+        0,
+        reinterpret_cast<AtomicWord>(bucket));
+    if (previous == 0) return bucket;
+    DeleteArray(bucket);
+    return reinterpret_cast<uint32_t*>(previous);
+  }
+
+  static uint32_t LoadCell(uint32_t* cell) {
+    return static_cast<uint32_t>(
+        NoBarrier_Load(reinterpret_cast<volatile Atomic32*>(cell)));
+  }
+
+  static void SetCellBits(uint32_t* cell, uint32_t mask) {
+    volatile Atomic32* atomic_cell = reinterpret_cast<volatile Atomic32*>(cell);
+    Atomic32 old_value = NoBarrier_Load(atomic_cell);
+    while ((static_cast<uint32_t>(old_value) & mask) != mask) {
+      Atomic32 new_value = static_cast<Atomic32>(old_value | mask);
+      Atomic32 result =
+          NoBarrier_CompareAndSwap(atomic_cell, old_value, new_value);
+      if (result == old_value) return;
+      old_value = result;
+    }
+  }
+
+  static void ClearCellBits(uint32_t* cell, uint32_t mask) {
+    volatile Atomic32* atomic_cell = reinterpret_cast<volatile Atomic32*>(cell);
+    Atomic32 old_value = NoBarrier_Load(atomic_cell);
+    while ((static_cast<uint32_t>(old_value) & mask) != 0) {
+      Atomic32 new_value = static_cast<Atomic32>(old_value & ~mask);
+      Atomic32 result =
+          NoBarrier_CompareAndSwap(atomic_cell, old_value, new_value);
+      if (result == old_value) return;
+      old_value = result;
+    }
+  }
+
+  bool IsBucketEmpty(int bucket_index) {
+    uint32_t* bucket = buckets_[bucket_index];
+    for (int i = 0; i < kCellsPerBucket; i++) {
+      if (LoadCell(&bucket[i]) != 0) return false;
+    }
+    return true;
+  }
+
+  void ReleaseBucket(int bucket_index) {
+    if (buckets_[bucket_index] != NULL) {
+      DeleteArray(buckets_[bucket_index]);
+      buckets_[bucket_index] = NULL;
+    }
+  }
+
+  uint32_t* buckets_[kBuckets];
+};
+
+} }  // namespace v8::internal
+
+#endif  // V8_SLOT_SET_H_
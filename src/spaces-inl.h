@@ -323,6 +323,18 @@ MaybeObject* PagedSpace::AllocateRaw(int size_in_bytes,
 // NewSpace
 
 
+int NewSpace::SurvivorAge(Address from_space_address) {
+  NewSpacePage* page = NewSpacePage::FromAddress(from_space_address);
+  Address mark = age_mark();
+  if (!page->IsFlagSet(MemoryChunk::NEW_SPACE_BELOW_AGE_MARK) ||
+      (page->ContainsLimit(mark) && from_space_address >= mark)) {
+    return 0;
+  }
+  if (from_space_ages_->is_empty()) return 1;
+  return from_space_ages_->AgeOf(from_space_address);
+}
+
+
 MaybeObject* NewSpace::AllocateRaw(int size_in_bytes) {
   Address old_top = allocation_info_.top();
 #ifdef DEBUG
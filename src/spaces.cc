@@ -31,6 +31,8 @@
 #include "mark-compact.h"
 #include "msan.h"
 #include "platform.h"
+#include "slot-set.h"
+#include "unmapper-thread.h"
 
 namespace v8 {
 namespace internal {
@@ -124,8 +126,9 @@ bool HeapObjectIterator::AdvanceToNextPage() {
 // CodeRange
 
 
-CodeRange::CodeRange(Isolate* isolate)
+CodeRange::CodeRange(Isolate* isolate, Executability executable)
     : isolate_(isolate),
+      executable_(executable),
       code_range_(NULL),
       free_list_(0),
       allocation_list_(0),
@@ -133,10 +136,13 @@ CodeRange::CodeRange(Isolate* isolate)
 }
 
 
-bool CodeRange::SetUp(const size_t requested) {
+bool CodeRange::SetUp(const size_t requested, const size_t alignment) {
   ASSERT(code_range_ == NULL);
+  ASSERT(IsAligned(alignment, MemoryChunk::kAlignment));
 
-  code_range_ = new VirtualMemory(requested);
+  code_range_ = alignment > MemoryChunk::kAlignment
+      ? new VirtualMemory(requested, alignment)
+      : new VirtualMemory(requested);
   CHECK(code_range_ != NULL);
   if (!code_range_->IsReserved()) {
     delete code_range_;
@@ -149,8 +155,7 @@ bool CodeRange::SetUp(const size_t requested) {
   LOG(isolate_, NewEvent("CodeRange", code_range_->address(), requested));
   Address base = reinterpret_cast<Address>(code_range_->address());
   Address aligned_base =
-      RoundUp(reinterpret_cast<Address>(code_range_->address()),
-              MemoryChunk::kAlignment);
+      RoundUp(reinterpret_cast<Address>(code_range_->address()), alignment);
   size_t size = code_range_->size() - (aligned_base - base);
   allocation_list_.Add(FreeBlock(aligned_base, size));
   current_allocation_block_index_ = 0;
@@ -160,10 +165,10 @@ bool CodeRange::SetUp(const size_t requested) {
 
 int CodeRange::CompareFreeBlockAddress(const FreeBlock* left,
                                        const FreeBlock* right) {
-  // The entire point of CodeRange is that the difference between two
-  // addresses in the range can be represented as a signed 32-bit int,
-  // so the cast is semantically correct.
-  return static_cast<int>(left->start - right->start);
+  // The difference between two addresses in a heap cage does not always fit
+  // in a signed 32-bit int, so compare instead of subtracting.
+  if (left->start == right->start) return 0;
+  return left->start < right->start ? -1 : 1;
 }
 
 
@@ -229,12 +234,21 @@ Address CodeRange::AllocateRawMemory(const size_t requested_size,
   }
   ASSERT(*allocated <= current.size);
   ASSERT(IsAddressAligned(current.start, MemoryChunk::kAlignment));
-  if (!isolate_->memory_allocator()->CommitExecutableMemory(code_range_,
-                                                            current.start,
-                                                            commit_size,
-                                                            *allocated)) {
-    *allocated = 0;
-    return NULL;
+  if (executable_ == EXECUTABLE) {
+    if (!isolate_->memory_allocator()->CommitExecutableMemory(code_range_,
+                                                              current.start,
+                                                              commit_size,
+                                                              *allocated)) {
+      *allocated = 0;
+      return NULL;
+    }
+  } else if (commit_size > 0) {
+    if (!isolate_->memory_allocator()->CommitMemory(current.start,
+                                                    commit_size,
+                                                    NOT_EXECUTABLE)) {
+      *allocated = 0;
+      return NULL;
+    }
   }
   allocation_list_[current_allocation_block_index_].start += *allocated;
   allocation_list_[current_allocation_block_index_].size -= *allocated;
@@ -246,7 +260,7 @@ Address CodeRange::AllocateRawMemory(const size_t requested_size,
 
 
 bool CodeRange::CommitRawMemory(Address start, size_t length) {
-  return isolate_->memory_allocator()->CommitMemory(start, length, EXECUTABLE);
+  return isolate_->memory_allocator()->CommitMemory(start, length, executable_);
 }
 
 
@@ -281,7 +295,8 @@ MemoryAllocator::MemoryAllocator(Isolate* isolate)
       size_(0),
       size_executable_(0),
       lowest_ever_allocated_(reinterpret_cast<void*>(-1)),
-      highest_ever_allocated_(reinterpret_cast<void*>(0)) {
+      highest_ever_allocated_(reinterpret_cast<void*>(0)),
+      pending_unmap_size_(0) {
 }
 
 
@@ -298,6 +313,9 @@ bool MemoryAllocator::SetUp(intptr_t capacity, intptr_t capacity_executable) {
 
 
 void MemoryAllocator::TearDown() {
+  // The unmapper thread has been stopped already.
+  UnmapQueuedChunks();
+  ReleasePooledChunks();
   // Check that spaces were torn down before MemoryAllocator.
   ASSERT(size_ == 0);
   // TODO(gc) this will be true again when we fix FreeMemory.
@@ -356,6 +374,10 @@ void MemoryAllocator::FreeMemory(Address base,
   if (isolate_->code_range()->contains(static_cast<Address>(base))) {
     ASSERT(executable == EXECUTABLE);
     isolate_->code_range()->FreeRawMemory(base, size);
+  } else if (isolate_->heap_cage() != NULL &&
+             isolate_->heap_cage()->contains(static_cast<Address>(base))) {
+    ASSERT(executable == NOT_EXECUTABLE);
+    isolate_->heap_cage()->FreeRawMemory(base, size);
   } else {
     ASSERT(executable == NOT_EXECUTABLE || !isolate_->code_range()->exists());
     bool result = VirtualMemory::ReleaseRegion(base, size);
@@ -379,6 +401,19 @@ Address MemoryAllocator::ReserveAlignedMemory(size_t size,
 }
 
 
+Address MemoryAllocator::ReserveCagedMemory(size_t size, size_t alignment) {
+  size_t allocated;
+  Address base = isolate_->heap_cage()->AllocateRawMemory(size, 0, &allocated);
+  if (base == NULL) return NULL;
+  ASSERT(allocated == size);
+  ASSERT(IsAddressAligned(base, alignment));
+  size_ += allocated;
+  isolate_->counters()->memory_allocated()->
+      Increment(static_cast<int>(allocated));
+  return base;
+}
+
+
 Address MemoryAllocator::AllocateAlignedMemory(size_t reserve_size,
                                                size_t commit_size,
                                                size_t alignment,
@@ -480,6 +515,11 @@ MemoryChunk* MemoryChunk::Initialize(Heap* heap,
   chunk->InitializeReservedMemory();
   chunk->slots_buffer_ = NULL;
   chunk->skip_list_ = NULL;
+  chunk->old_to_new_slots_ = NULL;
+  // Pooled chunks are reused without clearing their memory.
+  chunk->next_chunk_ = NULL;
+  chunk->prev_chunk_ = NULL;
+  chunk->store_buffer_counter_ = 0;
   chunk->write_barrier_counter_ = kWriteBarrierCounterGranularity;
   chunk->progress_bar_ = 0;
   chunk->high_water_mark_ = static_cast<int>(area_start - base);
@@ -532,8 +572,10 @@ bool MemoryChunk::CommitArea(size_t requested) {
         return false;
       }
     } else {
-      CodeRange* code_range = heap_->isolate()->code_range();
-      ASSERT(code_range->exists() && IsFlagSet(IS_EXECUTABLE));
+      CodeRange* code_range = IsFlagSet(IS_EXECUTABLE)
+          ? heap_->isolate()->code_range()
+          : heap_->isolate()->heap_cage();
+      ASSERT(code_range != NULL && code_range->exists());
       if (!code_range->CommitRawMemory(start, length)) return false;
     }
 
@@ -548,8 +590,10 @@ bool MemoryChunk::CommitArea(size_t requested) {
     if (reservation_.IsReserved()) {
       if (!reservation_.Uncommit(start, length)) return false;
     } else {
-      CodeRange* code_range = heap_->isolate()->code_range();
-      ASSERT(code_range->exists() && IsFlagSet(IS_EXECUTABLE));
+      CodeRange* code_range = IsFlagSet(IS_EXECUTABLE)
+          ? heap_->isolate()->code_range()
+          : heap_->isolate()->heap_cage();
+      ASSERT(code_range != NULL && code_range->exists());
       if (!code_range->UncommitRawMemory(start, length)) return false;
     }
   }
@@ -590,6 +634,19 @@ void MemoryChunk::Unlink() {
 }
 
 
+SlotSet* MemoryChunk::AllocateOldToNewSlots() {
+  ASSERT(old_to_new_slots_ == NULL);
+  old_to_new_slots_ = new SlotSet[NumberOfSlotSets()];
+  return old_to_new_slots_;
+}
+
+
+void MemoryChunk::ReleaseOldToNewSlots() {
+  delete[] old_to_new_slots_;
+  old_to_new_slots_ = NULL;
+}
+
+
 MemoryChunk* MemoryAllocator::AllocateChunk(intptr_t reserve_area_size,
                                             intptr_t commit_area_size,
                                             Executability executable,
@@ -683,11 +740,29 @@ MemoryChunk* MemoryAllocator::AllocateChunk(intptr_t reserve_area_size,
                          OS::CommitPageSize());
     size_t commit_size = RoundUp(MemoryChunk::kObjectStartOffset +
                                  commit_area_size, OS::CommitPageSize());
-    base = AllocateAlignedMemory(chunk_size,
-                                 commit_size,
-                                 MemoryChunk::kAlignment,
-                                 executable,
-                                 &reservation);
+    if (isolate_->heap_cage() != NULL) {
+      // Chunks in the heap cage have no reservation of their own and are
+      // never pooled; the cage keeps track of its free blocks itself.
+      base = isolate_->heap_cage()->AllocateRawMemory(chunk_size,
+                                                      commit_size,
+                                                      &chunk_size);
+      if (base == NULL) return NULL;
+      size_ += chunk_size;
+    } else if (chunk_size == static_cast<size_t>(Page::kPageSize) &&
+               commit_size == chunk_size &&
+               !pooled_chunks_.is_empty()) {
+      MemoryChunk* pooled = pooled_chunks_.RemoveLast();
+      base = pooled->address();
+      ASSERT(base == pooled->reserved_memory()->address());
+      reservation.TakeControl(pooled->reserved_memory());
+      size_ += chunk_size;
+    } else {
+      base = AllocateAlignedMemory(chunk_size,
+                                   commit_size,
+                                   MemoryChunk::kAlignment,
+                                   executable,
+                                   &reservation);
+    }
 
     if (base == NULL) return NULL;
 
@@ -768,10 +843,22 @@ void MemoryAllocator::Free(MemoryChunk* chunk) {
 
   delete chunk->slots_buffer();
   delete chunk->skip_list();
+  chunk->ReleaseOldToNewSlots();
 
   VirtualMemory* reservation = chunk->reserved_memory();
   if (reservation->IsReserved()) {
-    FreeMemory(reservation, chunk->executable());
+    if (reservation->size() == static_cast<size_t>(Page::kPageSize) &&
+        chunk->executable() == NOT_EXECUTABLE &&
+        pooled_chunks_.length() < kMaxPooledChunks) {
+      size_ -= Page::kPageSize;
+      isolate_->counters()->memory_allocated()->Decrement(Page::kPageSize);
+      pooled_chunks_.Add(chunk);
+    } else if (FLAG_concurrent_unmapping &&
+               isolate_->unmapper_thread() != NULL) {
+      QueueForUnmapping(reservation, chunk->executable());
+    } else {
+      FreeMemory(reservation, chunk->executable());
+    }
   } else {
     FreeMemory(chunk->address(),
                chunk->size(),
@@ -780,6 +867,65 @@ void MemoryAllocator::Free(MemoryChunk* chunk) {
 }
 
 
+void MemoryAllocator::QueueForUnmapping(VirtualMemory* reservation,
+                                        Executability executable) {
+  size_t size = reservation->size();
+  ASSERT(size_ >= size);
+  size_ -= size;
+  isolate_->counters()->memory_allocated()->Decrement(static_cast<int>(size));
+  if (executable == EXECUTABLE) {
+    ASSERT(size_executable_ >= size);
+    size_executable_ -= size;
+  }
+
+  UnmapRegion region;
+  region.base = static_cast<Address>(reservation->address());
+  region.size = size;
+  // The reservation lives in the chunk header, which is about to be unmapped
+  // concurrently.
+  reservation->Reset();
+  {
+    LockGuard<Mutex> lock_guard(&unmap_queue_mutex_);
+    unmap_queue_.Add(region);
+    pending_unmap_size_ += size;
+  }
+  isolate_->unmapper_thread()->StartUnmapping();
+}
+
+
+void MemoryAllocator::UnmapQueuedChunks() {
+  while (true) {
+    UnmapRegion region;
+    {
+      LockGuard<Mutex> lock_guard(&unmap_queue_mutex_);
+      if (unmap_queue_.is_empty()) return;
+      region = unmap_queue_.RemoveLast();
+    }
+    bool result = VirtualMemory::ReleaseRegion(region.base, region.size);
+    USE(result);
+    ASSERT(result);
+    LockGuard<Mutex> lock_guard(&unmap_queue_mutex_);
+    pending_unmap_size_ -= region.size;
+  }
+}
+
+
+intptr_t MemoryAllocator::PendingUnmapSize() {
+  LockGuard<Mutex> lock_guard(&unmap_queue_mutex_);
+  return pending_unmap_size_;
+}
+
+
+void MemoryAllocator::ReleasePooledChunks() {
+  while (!pooled_chunks_.is_empty()) {
+    MemoryChunk* chunk = pooled_chunks_.RemoveLast();
+    VirtualMemory reservation;
+    reservation.TakeControl(chunk->reserved_memory());
+    reservation.Release();
+  }
+}
+
+
 bool MemoryAllocator::CommitBlock(Address start,
                                   size_t size,
                                   Executability executable) {
@@ -1033,6 +1179,13 @@ bool PagedSpace::CanExpand() {
 }
 
 
+void PagedSpace::SetMaxCapacity(intptr_t max_capacity) {
+  max_capacity_ = (RoundDown(max_capacity, Page::kPageSize) / Page::kPageSize)
+      * AreaSize();
+  if (max_capacity_ < Capacity()) max_capacity_ = Capacity();
+}
+
+
 bool PagedSpace::Expand() {
   if (!CanExpand()) return false;
 
@@ -1233,10 +1386,18 @@ bool NewSpace::SetUp(int reserved_semispace_capacity,
   int initial_semispace_capacity = heap()->InitialSemiSpaceSize();
 
   size_t size = 2 * reserved_semispace_capacity;
-  Address base =
-      heap()->isolate()->memory_allocator()->ReserveAlignedMemory(
-          size, size, &reservation_);
-  if (base == NULL) return false;
+  Address base = NULL;
+  if (heap()->isolate()->heap_cage() != NULL) {
+    // The new space is the first thing allocated in the heap cage, whose
+    // start is aligned to the cage size and hence to the new space size.
+    base = heap()->isolate()->memory_allocator()->ReserveCagedMemory(size,
+                                                                     size);
+    if (base == NULL) return false;
+  } else {
+    base = heap()->isolate()->memory_allocator()->ReserveAlignedMemory(
+        size, size, &reservation_);
+    if (base == NULL) return false;
+  }
 
   chunk_base_ = base;
   chunk_size_ = static_cast<uintptr_t>(size);
@@ -1270,6 +1431,9 @@ bool NewSpace::SetUp(int reserved_semispace_capacity,
   }
   ASSERT(!from_space_.is_committed());  // No need to use memory yet.
 
+  promotion_age_ = Max(0, Min(FLAG_scavenges_before_promotion,
+                              kMaxSurvivorAge));
+
   start_ = chunk_base_;
   address_mask_ = ~(2 * reserved_semispace_capacity - 1);
   object_mask_ = address_mask_ | kHeapObjectTagMask;
@@ -1300,16 +1464,101 @@ void NewSpace::TearDown() {
 
   LOG(heap()->isolate(), DeleteEvent("InitialChunk", chunk_base_));
 
-  ASSERT(reservation_.IsReserved());
-  heap()->isolate()->memory_allocator()->FreeMemory(&reservation_,
-                                                    NOT_EXECUTABLE);
+  if (heap()->isolate()->heap_cage() != NULL) {
+    heap()->isolate()->memory_allocator()->FreeMemory(chunk_base_,
+                                                      chunk_size_,
+                                                      NOT_EXECUTABLE);
+  } else {
+    ASSERT(reservation_.IsReserved());
+    heap()->isolate()->memory_allocator()->FreeMemory(&reservation_,
+                                                      NOT_EXECUTABLE);
+  }
   chunk_base_ = NULL;
   chunk_size_ = 0;
 }
 
 
 void NewSpace::Flip() {
+  ASSERT(!has_open_survivor_areas());
   SemiSpace::Swap(&from_space_, &to_space_);
+  SurvivorAgeTable* ages = from_space_ages_;
+  from_space_ages_ = to_space_ages_;
+  to_space_ages_ = ages;
+  to_space_ages_->Clear();
+}
+
+
+int SurvivorAgeTable::AgeOf(Address address) {
+  int low = 0;
+  int high = areas_.length() - 1;
+  while (low <= high) {
+    int middle = low + (high - low) / 2;
+    const Area& area = areas_[middle];
+    if (address < area.start) {
+      high = middle - 1;
+    } else if (address >= area.end) {
+      low = middle + 1;
+    } else {
+      return area.age;
+    }
+  }
+  return 1;
+}
+
+
+MaybeObject* NewSpace::AllocateSurvivor(int size_in_bytes, int age) {
+  if (age <= 1) return AllocateRaw(size_in_bytes);
+  ASSERT(age <= kMaxSurvivorAge);
+  AllocationInfo* area = &survivor_areas_[age];
+  if (area->limit() - area->top() >= size_in_bytes) {
+    HeapObject* object = HeapObject::FromAddress(area->top());
+    area->set_top(area->top() + size_in_bytes);
+    return object;
+  }
+
+  Object* result;
+  if (size_in_bytes > kSurvivorAreaSize / 4) {
+    // Large survivors get an area of their own.
+    MaybeObject* maybe_result = AllocateRaw(size_in_bytes);
+    if (!maybe_result->ToObject(&result)) return maybe_result;
+    Address start = HeapObject::cast(result)->address();
+    to_space_ages_->Add(start, start + size_in_bytes, age);
+    return result;
+  }
+
+  CloseSurvivorArea(age);
+  MaybeObject* maybe_result = AllocateRaw(kSurvivorAreaSize);
+  if (!maybe_result->ToObject(&result)) return AllocateRaw(size_in_bytes);
+  Address start = HeapObject::cast(result)->address();
+  to_space_ages_->Add(start, start + kSurvivorAreaSize, age);
+  area->set_top(start + size_in_bytes);
+  area->set_limit(start + kSurvivorAreaSize);
+  open_survivor_areas_++;
+  return result;
+}
+
+
+void NewSpace::CloseSurvivorArea(int age) {
+  AllocationInfo* area = &survivor_areas_[age];
+  if (area->top() == NULL) return;
+  int size = static_cast<int>(area->limit() - area->top());
+  if (size > 0) heap()->CreateFillerObjectAt(area->top(), size);
+  area->set_top(NULL);
+  area->set_limit(NULL);
+  open_survivor_areas_--;
+}
+
+
+void NewSpace::CloseSurvivorAreaAt(Address address) {
+  for (int age = 2; age <= kMaxSurvivorAge; age++) {
+    if (survivor_areas_[age].top() == address) CloseSurvivorArea(age);
+  }
+}
+
+
+void NewSpace::CloseSurvivorAreas() {
+  for (int age = 2; age <= kMaxSurvivorAge; age++) CloseSurvivorArea(age);
+  ASSERT(!has_open_survivor_areas());
 }
 
 
@@ -2660,11 +2909,13 @@ bool PagedSpace::EnsureSweeperProgress(intptr_t size_in_bytes) {
   MarkCompactCollector* collector = heap()->mark_compact_collector();
   if (collector->AreSweeperThreadsActivated()) {
     if (collector->IsConcurrentSweepingInProgress()) {
-      if (collector->StealMemoryFromSweeperThreads(this) < size_in_bytes) {
-        if (!collector->sequential_sweeping()) {
-          collector->WaitUntilSweepingCompleted();
-          return true;
-        }
+      intptr_t freed_bytes = collector->StealMemoryFromSweeperThreads(this);
+      if (freed_bytes < size_in_bytes && !collector->sequential_sweeping()) {
+        // Sweep the pages the sweeper threads have not claimed yet on this
+        // thread rather than blocking until they are done. Sweeping is
+        // complete for this space once no unclaimed page is left.
+        intptr_t needed_bytes = size_in_bytes - freed_bytes;
+        return collector->SweepOnDemand(this, needed_bytes) < needed_bytes;
       }
       return false;
     }
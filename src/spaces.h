@@ -293,6 +293,7 @@ class Bitmap {
 
 
 class SkipList;
+class SlotSet;
 class SlotsBuffer;
 
 // MemoryChunk represents a memory region owned by a specific space.
@@ -531,6 +532,14 @@ class MemoryChunk {
 
   static void IncrementLiveBytesFromMutator(Address address, int by);
 
+  // Used by parallel marking, where several threads may update the live
+  // byte count of the same chunk at the same time.
+  static void IncrementLiveBytesFromGCConcurrently(Address address, int by) {
+    MemoryChunk* chunk = MemoryChunk::FromAddress(address);
+    NoBarrier_AtomicIncrement(
+        reinterpret_cast<volatile Atomic32*>(&chunk->live_byte_count_), by);
+  }
+
   static const intptr_t kAlignment =
       (static_cast<uintptr_t>(1) << kPageSizeBits);
 
@@ -550,7 +559,7 @@ class MemoryChunk {
 
   static const size_t kHeaderSize = kWriteBarrierCounterOffset + kPointerSize +
                                     kIntSize + kIntSize + kPointerSize +
-                                    5 * kPointerSize;
+                                    6 * kPointerSize;
 
   static const int kBodyOffset =
       CODE_POINTER_ALIGN(kHeaderSize + Bitmap::kSize);
@@ -646,6 +655,18 @@ class MemoryChunk {
     return &slots_buffer_;
   }
 
+  // The remembered set of slots on this chunk that point to new space, one
+  // SlotSet per kPageSize bytes of the chunk.  NULL until the first slot is
+  // recorded.
+  SlotSet* old_to_new_slots() { return old_to_new_slots_; }
+  SlotSet* AllocateOldToNewSlots();
+  void ReleaseOldToNewSlots();
+
+  int NumberOfSlotSets() {
+    return static_cast<int>((size_ + (1 << kPageSizeBits) - 1) >>
+                            kPageSizeBits);
+  }
+
   void MarkEvacuationCandidate() {
     ASSERT(slots_buffer_ == NULL);
     SetFlag(EVACUATION_CANDIDATE);
@@ -711,6 +732,8 @@ class MemoryChunk {
   intptr_t available_in_huge_free_list_;
   intptr_t non_available_small_blocks_;
 
+  SlotSet* old_to_new_slots_;
+
   static MemoryChunk* Initialize(Heap* heap,
                                  Address base,
                                  size_t size,
@@ -910,13 +933,15 @@ class Space : public Malloced {
 // manages a range of virtual memory.
 class CodeRange {
  public:
-  explicit CodeRange(Isolate* isolate);
+  explicit CodeRange(Isolate* isolate, Executability executable = EXECUTABLE);
   ~CodeRange() { TearDown(); }
 
   // Reserves a range of virtual memory, but does not commit any of it.
-  // Can only be called once, at heap initialization time.
+  // Can only be called once, at heap initialization time.  The start of
+  // the range is aligned to the given alignment.
   // Returns false on failure.
-  bool SetUp(const size_t requested_size);
+  bool SetUp(const size_t requested_size,
+             const size_t alignment = MemoryChunk::kAlignment);
 
   // Frees the range of virtual memory, and frees the data structures used to
   // manage it.
@@ -946,6 +971,9 @@ class CodeRange {
  private:
   Isolate* isolate_;
 
+  // Whether the memory committed in the range is executable.
+  Executability executable_;
+
   // The reserved range of virtual memory that all code objects are put in.
   VirtualMemory* code_range_;
   // Plain old data class, just a struct plus a constructor.
@@ -988,6 +1016,21 @@ class CodeRange {
 };
 
 
+// ----------------------------------------------------------------------------
+// The heap cage is a non-executable code range that holds the new space and
+// every non-executable chunk of the heap when --heap-cage is set.  Its start
+// is aligned to its size, so the offset of a heap pointer from the start fits
+// in 32 bits.  Nothing relies on that yet.
+class HeapCage : public CodeRange {
+ public:
+  explicit HeapCage(Isolate* isolate) : CodeRange(isolate, NOT_EXECUTABLE) {}
+
+  bool SetUp(const size_t requested_size) {
+    return CodeRange::SetUp(requested_size, requested_size);
+  }
+};
+
+
 class SkipList {
  public:
   SkipList() {
@@ -1063,6 +1106,21 @@ class MemoryAllocator {
 
   void Free(MemoryChunk* chunk);
 
+  // Returns the number of bytes in freed pages that are kept committed for
+  // reuse by AllocateChunk.
+  intptr_t PooledSize() { return pooled_chunks_.length() * Page::kPageSize; }
+
+  // Returns the number of bytes in freed chunks that the unmapper thread has
+  // not yet returned to the OS.
+  intptr_t PendingUnmapSize();
+
+  // Returns the memory of all pooled pages to the OS.
+  void ReleasePooledChunks();
+
+  // Returns the memory of the chunks queued by Free to the OS.  Runs on the
+  // unmapper thread, or on the main thread if there is none.
+  void UnmapQueuedChunks();
+
   // Returns the maximum available bytes of heaps.
   intptr_t Available() { return capacity_ < size_ ? 0 : capacity_ - size_; }
 
@@ -1106,6 +1164,9 @@ class MemoryAllocator {
   Address ReserveAlignedMemory(size_t requested,
                                size_t alignment,
                                VirtualMemory* controller);
+  // Reserves memory from the heap cage without committing it.  It is
+  // released with FreeMemory(base, size, NOT_EXECUTABLE).
+  Address ReserveCagedMemory(size_t requested, size_t alignment);
   Address AllocateAlignedMemory(size_t reserve_size,
                                 size_t commit_size,
                                 size_t alignment,
@@ -1185,6 +1246,25 @@ class MemoryAllocator {
   void* lowest_ever_allocated_;
   void* highest_ever_allocated_;
 
+  // Freed pages of regular size stay committed in this pool, so that most
+  // page allocations after a GC do not need to map memory.
+  static const int kMaxPooledChunks = 4;
+  List<MemoryChunk*> pooled_chunks_;
+
+  // Regions of freed chunks that still have to be unmapped.  The queue is
+  // shared with the unmapper thread.
+  struct UnmapRegion {
+    Address base;
+    size_t size;
+  };
+  List<UnmapRegion> unmap_queue_;
+  intptr_t pending_unmap_size_;
+  Mutex unmap_queue_mutex_;
+
+  // Hands the reserved memory of a freed chunk to the unmapper thread.
+  void QueueForUnmapping(VirtualMemory* reservation,
+                         Executability executable);
+
   struct MemoryAllocationCallbackRegistration {
     MemoryAllocationCallbackRegistration(MemoryAllocationCallback callback,
                                          ObjectSpace space,
@@ -1891,6 +1971,9 @@ class PagedSpace : public Space {
 
   bool CanExpand();
 
+  // Changes the maximum capacity, but never below the current capacity.
+  void SetMaxCapacity(intptr_t max_capacity);
+
   // Returns the number of total pages in this space.
   int CountTotalPages();
 
@@ -2343,6 +2426,44 @@ class NewSpacePageIterator BASE_EMBEDDED {
 };
 
 
+// -----------------------------------------------------------------------------
+// Survivor ages in new space
+//
+// Objects below the age mark of a semispace have survived at least one
+// scavenge.  When objects stay in new space for more than one scavenge, older
+// survivors are copied into separate survivor areas of to space and the table
+// records the age of each area.  Areas are added in allocation order, so they
+// are sorted by address.
+
+class SurvivorAgeTable {
+ public:
+  SurvivorAgeTable() : areas_(0) { }
+
+  void Add(Address start, Address end, int age) {
+    ASSERT(areas_.is_empty() || areas_.last().end <= start);
+    Area area = { start, end, age };
+    areas_.Add(area);
+  }
+
+  void Clear() { areas_.Rewind(0); }
+
+  bool is_empty() { return areas_.is_empty(); }
+
+  // Returns the age of the area containing the address, or one if the
+  // address is below the age mark but not in a survivor area.
+  int AgeOf(Address address);
+
+ private:
+  struct Area {
+    Address start;
+    Address end;
+    int age;
+  };
+
+  List<Area> areas_;
+};
+
+
 // -----------------------------------------------------------------------------
 // The young generation space.
 //
@@ -2357,6 +2478,10 @@ class NewSpace : public Space {
       to_space_(heap, kToSpace),
       from_space_(heap, kFromSpace),
       reservation_(),
+      promotion_age_(1),
+      from_space_ages_(&survivor_ages_[0]),
+      to_space_ages_(&survivor_ages_[1]),
+      open_survivor_areas_(0),
       inline_allocation_limit_step_(0) {}
 
   // Sets up the new space using the given chunk.
@@ -2467,6 +2592,37 @@ class NewSpace : public Space {
   // Set the age mark in the active semispace.
   void set_age_mark(Address mark) { to_space_.set_age_mark(mark); }
 
+  // The number of scavenges an object survives in new space before it is
+  // promoted, taken from --scavenges_before_promotion.
+  int promotion_age() { return promotion_age_; }
+
+  // Returns the number of scavenges survived by the object at the given
+  // address in from space.
+  inline int SurvivorAge(Address from_space_address);
+
+  // Allocates room in to space for an object that has survived the given
+  // number of scavenges.  Survivors older than one scavenge are put into
+  // survivor areas, falling back to plain allocation when none can be
+  // carved out of to space.
+  MUST_USE_RESULT MaybeObject* AllocateSurvivor(int size_in_bytes, int age);
+
+  // Records a survivor area that a parallel scavenge task carved out of
+  // to space.
+  void RecordSurvivorArea(Address start, Address end, int age) {
+    to_space_ages_->Add(start, end, age);
+  }
+
+  // The scavenger treats to space as a queue of objects to scan.  When the
+  // front of the queue reaches the unused part of an open survivor area, the
+  // area is closed so that the queue can move past it.
+  bool has_open_survivor_areas() { return open_survivor_areas_ > 0; }
+  void CloseSurvivorAreaAt(Address address);
+  void CloseSurvivorAreas();
+
+  // Oldest age that is recorded for survivors.
+  static const int kMaxSurvivorAge = 8;
+  static const int kSurvivorAreaSize = 4 * KB;
+
   // The start address of the space and a bit mask. Anding an address in the
   // new space with the mask will result in the start address.
   Address start() { return start_; }
@@ -2588,6 +2744,8 @@ class NewSpace : public Space {
   // Update allocation info to match the current to-space page.
   void UpdateAllocationInfo();
 
+  void CloseSurvivorArea(int age);
+
   Address chunk_base_;
   uintptr_t chunk_size_;
 
@@ -2597,6 +2755,16 @@ class NewSpace : public Space {
   VirtualMemory reservation_;
   int pages_used_;
 
+  int promotion_age_;
+  // The ages of survivors in from space and in to space.  The tables are
+  // swapped when the semispaces are flipped.
+  SurvivorAgeTable survivor_ages_[2];
+  SurvivorAgeTable* from_space_ages_;
+  SurvivorAgeTable* to_space_ages_;
+  // The linear allocation areas for survivors, indexed by age.
+  AllocationInfo survivor_areas_[kMaxSurvivorAge + 1];
+  int open_survivor_areas_;
+
   // Start address and bit mask for containment testing.
   Address start_;
   uintptr_t address_mask_;
@@ -2807,6 +2975,8 @@ class LargeObjectSpace : public Space {
     return chunk_size - Page::kPageSize - Page::kObjectStartOffset;
   }
 
+  void SetMaxCapacity(intptr_t max_capacity) { max_capacity_ = max_capacity; }
+
   // Shared implementation of AllocateRaw, AllocateRawCode and
   // AllocateRawFixedArray.
   MUST_USE_RESULT MaybeObject* AllocateRaw(int object_size,
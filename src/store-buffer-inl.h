@@ -25,9 +25,11 @@
 // (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+
 #ifndef V8_STORE_BUFFER_INL_H_
 #define V8_STORE_BUFFER_INL_H_
 
+#include "slot-set.h"
 #include "store-buffer.h"
 
 namespace v8 {
@@ -60,17 +62,47 @@ void StoreBuffer::EnterDirectlyIntoStoreBuffer(Address addr) {
                 !heap_->code_space()->Contains(addr) &&
                 !heap_->old_data_space()->Contains(addr) &&
                 !heap_->new_space()->Contains(addr));
-    Address* top = old_top_;
-    *top++ = addr;
-    old_top_ = top;
-    old_buffer_is_sorted_ = false;
-    old_buffer_is_filtered_ = false;
-    if (top >= old_limit_) {
-      ASSERT(callback_ != NULL);
-      (*callback_)(heap_,
-                   MemoryChunk::FromAnyPointerAddress(heap_, addr),
-                   kStoreBufferFullEvent);
-    }
+    MemoryChunk* chunk = ChunkContaining(addr);
+    if (chunk != NULL) InsertIntoRememberedSet(chunk, addr);
+  }
+}
+
+
+MemoryChunk* StoreBuffer::ChunkContaining(Address addr) {
+  MemoryChunk* chunk = MemoryChunk::FromAddress(addr);
+  // Slots beyond the first page of a large object do not have a chunk header
+  // in front of them.  The owner field of such a fake header is part of a
+  // fixed array, which cannot contain something tagged like an owner.
+  if (chunk->owner() == NULL) chunk = heap_->lo_space()->FindPage(addr);
+  if (chunk == NULL || chunk->IsFlagSet(MemoryChunk::ABOUT_TO_BE_FREED)) {
+    return NULL;
+  }
+  return chunk;
+}
+
+
+void StoreBuffer::InsertIntoRememberedSet(MemoryChunk* chunk, Address addr) {
+  SlotSet* slots = chunk->old_to_new_slots();
+  if (slots == NULL) slots = chunk->AllocateOldToNewSlots();
+  uintptr_t offset = addr - chunk->address();
+  slots[offset >> kPageSizeBits].Insert(
+      static_cast<int>(offset & Page::kPageAlignmentMask));
+}
+
+
+template<typename Visitor>
+void StoreBuffer::IterateAndClearSlots(MemoryChunk* chunk, Visitor* visitor) {
+  SlotSet* slots = chunk->old_to_new_slots();
+  if (slots == NULL) return;
+  // Sweeper threads may be removing slots of this chunk concurrently, so its
+  // buckets have to stay alive until sweeping is done.
+  SlotSet::EmptyBucketMode mode =
+      chunk->heap()->mark_compact_collector()->IsConcurrentSweepingInProgress()
+          ? SlotSet::KEEP_EMPTY_BUCKETS
+          : SlotSet::FREE_EMPTY_BUCKETS;
+  int number_of_slot_sets = chunk->NumberOfSlotSets();
+  for (int i = 0; i < number_of_slot_sets; i++) {
+    slots[i].Iterate(chunk->address() + i * Page::kPageSize, visitor, mode);
   }
 }
 
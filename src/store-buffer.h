@@ -25,6 +25,7 @@
 // (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+
 #ifndef V8_STORE_BUFFER_H_
 #define V8_STORE_BUFFER_H_
 
@@ -37,6 +38,7 @@
 namespace v8 {
 namespace internal {
 
+class MemoryChunk;
 class Page;
 class PagedSpace;
 class StoreBuffer;
@@ -49,7 +51,11 @@ typedef void (StoreBuffer::*RegionCallback)(Address start,
                                             bool clear_maps);
 
 // Used to implement the write barrier by collecting addresses of pointers
-// between spaces.
+// between spaces.  The mutator appends the addresses to a small buffer.  When
+// the buffer overflows, and before the old-to-new pointers are iterated, its
+// entries are moved to the remembered sets of the memory chunks that contain
+// the slots.  A remembered set is a bitmap per page (see SlotSet), so it never
+// overflows and a scavenge only has to visit the chunks that have slots.
 class StoreBuffer {
  public:
   explicit StoreBuffer(Heap* heap);
@@ -66,18 +72,8 @@ class StoreBuffer {
 
   // This is used by the heap traversal to enter the addresses into the store
   // buffer that should still be in the store buffer after GC.  It enters
-  // addresses directly into the old buffer because the GC starts by wiping the
-  // old buffer and thereafter only visits each cell once so there is no need
-  // to attempt to remove any dupes.  During the first part of a GC we
-  // are using the store buffer to access the old spaces and at the same time
-  // we are rebuilding the store buffer using this function.  There is, however
-  // no issue of overwriting the buffer we are iterating over, because this
-  // stage of the scavenge can only reduce the number of addresses in the store
-  // buffer (some objects are promoted so pointers to them do not need to be in
-  // the store buffer).  The later parts of the GC scan the pages that are
-  // exempt from the store buffer and process the promotion queue.  These steps
-  // can overflow this buffer.  We check for this and on overflow we call the
-  // callback set up with the StoreBufferRebuildScope object.
+  // addresses directly into the remembered sets.  Addresses are only entered
+  // while the store buffer is being rebuilt, see StoreBufferRebuildScope.
   inline void EnterDirectlyIntoStoreBuffer(Address addr);
 
   // Iterates over all pointers that go from old space to new space.  It will
@@ -89,108 +85,75 @@ class StoreBuffer {
   // referenced from the store buffer that do not contain a forwarding pointer.
   void IteratePointersToNewSpaceAndClearMaps(ObjectSlotCallback callback);
 
+  // Removes the slots of the given chunk from its remembered set and calls
+  // visitor->VisitSlot(address) for each of them.  Used by the parallel
+  // scavenger, whose tasks each process whole chunks after Compact has been
+  // called.
+  template<typename Visitor>
+  static inline void IterateAndClearSlots(MemoryChunk* chunk,
+                                          Visitor* visitor);
+
   static const int kStoreBufferOverflowBit = 1 << (14 + kPointerSizeLog2);
   static const int kStoreBufferSize = kStoreBufferOverflowBit;
   static const int kStoreBufferLength = kStoreBufferSize / sizeof(Address);
-  static const int kOldStoreBufferLength = kStoreBufferLength * 16;
-  static const int kHashSetLengthLog2 = 12;
-  static const int kHashSetLength = 1 << kHashSetLengthLog2;
 
+  // Moves the entries of the mutator's buffer to the remembered sets.
   void Compact();
 
+  // Removes the slots in [start, end), which must lie in one chunk, from the
+  // remembered set of that chunk.  The mutator's buffer is not touched, so
+  // this may be called by sweeper threads for the memory they free.  The main
+  // thread has to call Compact first, see Heap::ClearRecordedSlotRange.
+  void RemoveSlots(Address start, Address end);
+
   void GCPrologue();
   void GCEpilogue();
 
-  Object*** Limit() { return reinterpret_cast<Object***>(old_limit_); }
-  Object*** Start() { return reinterpret_cast<Object***>(old_start_); }
-  Object*** Top() { return reinterpret_cast<Object***>(old_top_); }
-  void SetTop(Object*** top) {
-    ASSERT(top >= Start());
-    ASSERT(top <= Limit());
-    old_top_ = reinterpret_cast<Address*>(top);
-  }
-
-  bool old_buffer_is_sorted() { return old_buffer_is_sorted_; }
-  bool old_buffer_is_filtered() { return old_buffer_is_filtered_; }
-
-  // Goes through the store buffer removing pointers to things that have
-  // been promoted.  Rebuilds the store buffer completely if it overflowed.
-  void SortUniq();
-
-  void EnsureSpace(intptr_t space_needed);
   void Verify();
 
-  bool PrepareForIteration();
-
 #ifdef DEBUG
-  void Clean();
   // Slow, for asserts only.
   bool CellIsInStoreBuffer(Address cell);
 #endif
 
-  void Filter(int flag);
-
  private:
+  class SlotCallbackVisitor;
+
   Heap* heap_;
 
-  // The store buffer is divided up into a new buffer that is constantly being
-  // filled by mutator activity and an old buffer that is filled with the data
-  // from the new buffer after compression.
+  // The buffer that is filled by mutator activity.
   Address* start_;
   Address* limit_;
 
-  Address* old_start_;
-  Address* old_limit_;
-  Address* old_top_;
-  Address* old_reserved_limit_;
-  VirtualMemory* old_virtual_memory_;
-
-  bool old_buffer_is_sorted_;
-  bool old_buffer_is_filtered_;
   bool during_gc_;
   // The garbage collector iterates over many pointers to new space that are not
   // handled by the store buffer.  This flag indicates whether the pointers
   // found by the callbacks should be added to the store buffer or not.
   bool store_buffer_rebuilding_enabled_;
-  StoreBufferCallback callback_;
-  bool may_move_store_buffer_entries_;
 
   VirtualMemory* virtual_memory_;
 
-  // Two hash sets used for filtering.
-  // If address is in the hash set then it is guaranteed to be in the
-  // old part of the store buffer.
-  uintptr_t* hash_set_1_;
-  uintptr_t* hash_set_2_;
-  bool hash_sets_are_empty_;
+  // Returns the chunk containing the given slot, or NULL if the chunk is about
+  // to be freed.
+  inline MemoryChunk* ChunkContaining(Address addr);
 
-  void ClearFilteringHashSets();
-
-  bool SpaceAvailable(intptr_t space_needed);
-  void Uniq();
-  void ExemptPopularPages(int prime_sample_step, int threshold);
+  // Enters the slot into the remembered set of the given chunk.
+  static inline void InsertIntoRememberedSet(MemoryChunk* chunk, Address addr);
 
   // Set the map field of the object to NULL if contains a map.
   inline void ClearDeadObject(HeapObject *object);
 
   void IteratePointersToNewSpace(ObjectSlotCallback callback, bool clear_maps);
 
+  inline void ProcessSlot(Address slot_address,
+                          ObjectSlotCallback slot_callback,
+                          bool clear_maps);
+
   void FindPointersToNewSpaceInRegion(Address start,
                                       Address end,
                                       ObjectSlotCallback slot_callback,
                                       bool clear_maps);
 
-  // For each region of pointers on a page in use from an old space call
-  // visit_pointer_region callback.
-  // If either visit_pointer_region or callback can cause an allocation
-  // in old space and changes in allocation watermark then
-  // can_preallocate_during_iteration should be set to true.
-  void IteratePointersOnPage(
-      PagedSpace* space,
-      Page* page,
-      RegionCallback region_callback,
-      ObjectSlotCallback slot_callback);
-
   void FindPointersToNewSpaceInMaps(
     Address start,
     Address end,
@@ -210,56 +173,27 @@ class StoreBuffer {
     ObjectSlotCallback slot_callback,
     bool clear_maps);
 
-  void IteratePointersInStoreBuffer(ObjectSlotCallback slot_callback,
-                                    bool clear_maps);
-
 #ifdef VERIFY_HEAP
   void VerifyPointers(PagedSpace* space, RegionCallback region_callback);
   void VerifyPointers(LargeObjectSpace* space);
 #endif
 
   friend class StoreBufferRebuildScope;
-  friend class DontMoveStoreBufferEntriesScope;
 };
 
 
 class StoreBufferRebuildScope {
  public:
-  explicit StoreBufferRebuildScope(Heap* heap,
-                                   StoreBuffer* store_buffer,
-                                   StoreBufferCallback callback)
+  explicit StoreBufferRebuildScope(StoreBuffer* store_buffer)
       : store_buffer_(store_buffer),
-        stored_state_(store_buffer->store_buffer_rebuilding_enabled_),
-        stored_callback_(store_buffer->callback_) {
+        stored_state_(store_buffer->store_buffer_rebuilding_enabled_) {
     store_buffer_->store_buffer_rebuilding_enabled_ = true;
-    store_buffer_->callback_ = callback;
-    (*callback)(heap, NULL, kStoreBufferStartScanningPagesEvent);
   }
 
   ~StoreBufferRebuildScope() {
-    store_buffer_->callback_ = stored_callback_;
     store_buffer_->store_buffer_rebuilding_enabled_ = stored_state_;
   }
 
- private:
-  StoreBuffer* store_buffer_;
-  bool stored_state_;
-  StoreBufferCallback stored_callback_;
-};
-
-
-class DontMoveStoreBufferEntriesScope {
- public:
-  explicit DontMoveStoreBufferEntriesScope(StoreBuffer* store_buffer)
-      : store_buffer_(store_buffer),
-        stored_state_(store_buffer->may_move_store_buffer_entries_) {
-    store_buffer_->may_move_store_buffer_entries_ = false;
-  }
-
-  ~DontMoveStoreBufferEntriesScope() {
-    store_buffer_->may_move_store_buffer_entries_ = stored_state_;
-  }
-
  private:
   StoreBuffer* store_buffer_;
   bool stored_state_;
@@ -0,0 +1,104 @@
+// Copyright 2013 the V8 project authors. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Google Inc. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "streaming-preparser.h"
+
+#include "v8.h"
+
+namespace v8 {
+namespace internal {
+
+static const int kStreamingPreParserStackSize = 1 * MB;
+// Stack used above PreParse by the thread entry and not accounted for in
+// the stack limit of the preparser.
+static const int kStreamingPreParserStackSlack = 64 * KB;
+
+
+StreamingPreParser::PreParserThread::PreParserThread(
+    StreamingPreParser* streamer)
+    : Thread(Thread::Options("v8:StreamingPreParser",
+                             kStreamingPreParserStackSize)),
+      streamer_(streamer) { }
+
+
+void StreamingPreParser::PreParserThread::Run() {
+  streamer_->PreParse();
+}
+
+
+StreamingPreParser::StreamingPreParser(
+    StreamingUtf16CharacterStream::Encoding encoding)
+    : stream_(encoding),
+      thread_(this),
+      result_(NULL),
+      finished_(false) {
+  thread_.Start();
+}
+
+
+StreamingPreParser::~StreamingPreParser() {
+  if (!finished_) {
+    stream_.SignalEndOfInput();
+    thread_.Join();
+  }
+  delete result_;
+}
+
+
+void StreamingPreParser::AddChunk(const char* data, int length) {
+  ASSERT(!finished_);
+  ASSERT(length >= 0);
+  stream_.AddChunk(reinterpret_cast<const byte*>(data),
+                   static_cast<unsigned>(length));
+}
+
+
+v8::ScriptData* StreamingPreParser::Finish() {
+  ASSERT(!finished_);
+  stream_.SignalEndOfInput();
+  thread_.Join();
+  finished_ = true;
+  ScriptDataImpl* result = result_;
+  result_ = NULL;
+  return result;
+}
+
+
+void StreamingPreParser::PreParse() {
+  // The stack limit of the isolate is the one of the main thread.
+  uintptr_t stack_position = reinterpret_cast<uintptr_t>(&stack_position);
+  uintptr_t stack_limit = stack_position - kStreamingPreParserStackSize +
+                          kStreamingPreParserStackSlack;
+  result_ = PreParserApi::PreParse(&unicode_cache_, stack_limit, &stream_);
+  if (result_ != NULL) {
+    stream_.Rewind();
+    result_->SetSourceAndFlagHash(&stream_);
+  }
+}
+
+} }  // namespace v8::internal
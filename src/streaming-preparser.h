@@ -0,0 +1,74 @@
+// Copyright 2013 the V8 project authors. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Google Inc. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef V8_STREAMING_PREPARSER_H_
+#define V8_STREAMING_PREPARSER_H_
+
+#include "../include/v8.h"
+
+#include "parser.h"
+#include "platform.h"
+#include "scanner-character-streams.h"
+
+namespace v8 {
+namespace internal {
+
+// Pre-parses a script on a background thread while its source is being
+// added chunk by chunk.  The preparser does not touch the heap, so the
+// thread does not need the isolate.
+class StreamingPreParser : public v8::ScriptStreamer {
+ public:
+  explicit StreamingPreParser(StreamingUtf16CharacterStream::Encoding encoding);
+  virtual ~StreamingPreParser();
+
+  virtual void AddChunk(const char* data, int length);
+  virtual v8::ScriptData* Finish();
+
+ private:
+  class PreParserThread : public Thread {
+   public:
+    explicit PreParserThread(StreamingPreParser* streamer);
+    virtual void Run();
+
+   private:
+    StreamingPreParser* streamer_;
+  };
+
+  // Called on the background thread.
+  void PreParse();
+
+  StreamingUtf16CharacterStream stream_;
+  UnicodeCache unicode_cache_;
+  PreParserThread thread_;
+  ScriptDataImpl* result_;
+  bool finished_;
+};
+
+} }  // namespace v8::internal
+
+#endif  // V8_STREAMING_PREPARSER_H_
@@ -375,7 +375,12 @@ void StringStream::PrintUsingMap(JSObject* js_object) {
           key->ShortPrint();
         }
         Add(": ");
-        Object* value = js_object->RawFastPropertyAt(descs->GetFieldIndex(i));
+        int index = descs->GetFieldIndex(i);
+        if (js_object->IsUnboxedDoubleField(index)) {
+          Add("%g\n", FmtElm(js_object->RawFastDoublePropertyAt(index)));
+          continue;
+        }
+        Object* value = js_object->RawFastPropertyAt(index);
         Add("%o\n", value);
       }
     }
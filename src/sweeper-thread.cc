@@ -68,12 +68,19 @@ void SweeperThread::Run() {
       return;
     }
 
-    collector_->SweepInParallel(heap_->old_data_space(),
-                                &private_free_list_old_data_space_,
-                                &free_list_old_data_space_);
-    collector_->SweepInParallel(heap_->old_pointer_space(),
-                                &private_free_list_old_pointer_space_,
-                                &free_list_old_pointer_space_);
+    Page* p;
+    while ((p = collector_->ClaimPageForSweeping()) != NULL) {
+      if (p->owner()->identity() == OLD_DATA_SPACE) {
+        collector_->SweepInParallel(p,
+                                    &private_free_list_old_data_space_,
+                                    &free_list_old_data_space_);
+      } else {
+        ASSERT(p->owner()->identity() == OLD_POINTER_SPACE);
+        collector_->SweepInParallel(p,
+                                    &private_free_list_old_pointer_space_,
+                                    &free_list_old_pointer_space_);
+      }
+    }
     end_sweeping_semaphore_.Signal();
   }
 }
@@ -48,7 +48,12 @@ namespace internal {
   /* Total compilation times. */                                      \
   HT(compile, V8.Compile)                                             \
   HT(compile_eval, V8.CompileEval)                                    \
-  HT(compile_lazy, V8.CompileLazy)
+  HT(compile_lazy, V8.CompileLazy)                                    \
+  /* Concurrent recompilation latencies. */                           \
+  HT(concurrent_recompilation_queue_latency,                          \
+     V8.ConcurrentRecompilationQueueLatency)                          \
+  HT(concurrent_recompilation_install_latency,                        \
+     V8.ConcurrentRecompilationInstallLatency)
 
 #define HISTOGRAM_PERCENTAGE_LIST(HP)                                 \
   /* Heap fragmentation. */                                           \
@@ -146,6 +151,8 @@ namespace internal {
   SC(total_preparse_skipped, V8.TotalPreparseSkipped)                 \
   /* Number of symbol lookups skipped using preparsing */             \
   SC(total_preparse_symbols_skipped, V8.TotalPreparseSymbolSkipped)   \
+  /* Number of times preparse data was ignored as it was stale. */    \
+  SC(total_preparse_data_rejected, V8.TotalPreparseDataRejected)      \
   /* Amount of compiled source code. */                               \
   SC(total_compile_size, V8.TotalCompileSize)                         \
   /* Amount of source code compiled with the full codegen. */         \
@@ -227,6 +227,59 @@ void V8::InitializeOncePerProcessImpl() {
     FLAG_sweeper_threads = 0;
   }
 
+  if (FLAG_parallel_scavenging) {
+    if (FLAG_scavenger_threads <= 0) {
+      FLAG_scavenger_threads = SystemThreadManager::
+          NumberOfParallelSystemThreads(
+              SystemThreadManager::PARALLEL_SCAVENGING);
+    }
+    if (FLAG_scavenger_threads == 0) {
+      FLAG_parallel_scavenging = false;
+    }
+  } else {
+    FLAG_scavenger_threads = 0;
+  }
+
+  if (FLAG_parallel_marking) {
+    if (FLAG_marking_threads <= 0) {
+      FLAG_marking_threads = SystemThreadManager::
+          NumberOfParallelSystemThreads(
+              SystemThreadManager::PARALLEL_MARKING);
+    }
+    if (FLAG_marking_threads == 0) {
+      FLAG_parallel_marking = false;
+    }
+  } else {
+    FLAG_marking_threads = 0;
+  }
+
+  if (FLAG_parallel_compaction || FLAG_parallel_weak_processing) {
+    if (FLAG_compaction_threads <= 0) {
+      FLAG_compaction_threads = SystemThreadManager::
+          NumberOfParallelSystemThreads(
+              SystemThreadManager::PARALLEL_COMPACTION);
+    }
+    if (FLAG_compaction_threads == 0) {
+      FLAG_parallel_compaction = false;
+      FLAG_parallel_weak_processing = false;
+    }
+  } else {
+    FLAG_compaction_threads = 0;
+  }
+
+  if (FLAG_concurrent_marking &&
+      (!FLAG_incremental_marking ||
+       SystemThreadManager::NumberOfParallelSystemThreads(
+           SystemThreadManager::CONCURRENT_MARKING) == 0)) {
+    FLAG_concurrent_marking = false;
+  }
+
+  if (FLAG_concurrent_unmapping &&
+      SystemThreadManager::NumberOfParallelSystemThreads(
+          SystemThreadManager::CONCURRENT_UNMAPPING) == 0) {
+    FLAG_concurrent_unmapping = false;
+  }
+
   if (FLAG_concurrent_recompilation &&
       SystemThreadManager::NumberOfParallelSystemThreads(
           SystemThreadManager::PARALLEL_RECOMPILATION) == 0) {
@@ -304,19 +304,6 @@ enum InlineCacheHolderFlag {
 };
 
 
-// The Store Buffer (GC).
-typedef enum {
-  kStoreBufferFullEvent,
-  kStoreBufferStartScanningPagesEvent,
-  kStoreBufferScanningPageEvent
-} StoreBufferEvent;
-
-
-typedef void (*StoreBufferCallback)(Heap* heap,
-                                    MemoryChunk* page,
-                                    StoreBufferEvent event);
-
-
 // Union used for fast testing of specific double values.
 union DoubleRepresentation {
   double  value;
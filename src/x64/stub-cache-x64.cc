@@ -824,6 +824,9 @@ void StoreStubCompiler::GenerateStoreTransition(MacroAssembler* masm,
   PropertyDetails details = descriptors->GetDetails(descriptor);
   Representation representation = details.representation();
   ASSERT(!representation.IsNone());
+  // Unboxed double fields are written in place, without allocating a box.
+  bool unboxed_double = details.type() == FIELD &&
+      transition->IsUnboxedDoubleField(descriptors->GetFieldIndex(descriptor));
 
   if (details.type() == CONSTANT) {
     Handle<Object> constant(descriptors->GetValue(descriptor), masm->isolate());
@@ -835,7 +838,9 @@ void StoreStubCompiler::GenerateStoreTransition(MacroAssembler* masm,
     __ JumpIfSmi(value_reg, miss_label);
   } else if (FLAG_track_double_fields && representation.IsDouble()) {
     Label do_store, heap_number;
-    __ AllocateHeapNumber(storage_reg, scratch1, slow);
+    if (!unboxed_double) {
+      __ AllocateHeapNumber(storage_reg, scratch1, slow);
+    }
 
     __ JumpIfNotSmi(value_reg, &heap_number);
     __ SmiToInteger32(scratch1, value_reg);
@@ -848,7 +853,9 @@ void StoreStubCompiler::GenerateStoreTransition(MacroAssembler* masm,
     __ movsd(xmm0, FieldOperand(value_reg, HeapNumber::kValueOffset));
 
     __ bind(&do_store);
-    __ movsd(FieldOperand(storage_reg, HeapNumber::kValueOffset), xmm0);
+    if (!unboxed_double) {
+      __ movsd(FieldOperand(storage_reg, HeapNumber::kValueOffset), xmm0);
+    }
   }
 
   // Stub never generated for non-global objects that require access
@@ -873,6 +880,16 @@ void StoreStubCompiler::GenerateStoreTransition(MacroAssembler* masm,
     return;
   }
 
+  if (unboxed_double) {
+    // Store the raw double before installing the map that describes the slot
+    // as raw; the write barrier for the map below may clobber xmm0.
+    int index = descriptors->GetFieldIndex(descriptor) -
+        object->map()->inobject_properties();
+    ASSERT(index < 0);
+    int offset = object->map()->instance_size() + (index * kPointerSize);
+    __ movsd(FieldOperand(receiver_reg, offset), xmm0);
+  }
+
   // Update the map of the object.
   __ Move(scratch1, transition);
   __ movq(FieldOperand(receiver_reg, HeapObject::kMapOffset), scratch1);
@@ -886,7 +903,7 @@ void StoreStubCompiler::GenerateStoreTransition(MacroAssembler* masm,
                       OMIT_REMEMBERED_SET,
                       OMIT_SMI_CHECK);
 
-  if (details.type() == CONSTANT) {
+  if (details.type() == CONSTANT || unboxed_double) {
     ASSERT(value_reg.is(rax));
     __ ret(0);
     return;
@@ -978,8 +995,13 @@ void StoreStubCompiler::GenerateStoreField(MacroAssembler* masm,
   } else if (FLAG_track_heap_object_fields && representation.IsHeapObject()) {
     __ JumpIfSmi(value_reg, miss_label);
   } else if (FLAG_track_double_fields && representation.IsDouble()) {
-    // Load the double storage.
-    if (index < 0) {
+    // Load the double storage. An unboxed field is its own storage.
+    Register storage = scratch1;
+    int storage_offset = HeapNumber::kValueOffset;
+    if (lookup->GetFieldIndex().is_unboxed_double(object)) {
+      storage = receiver_reg;
+      storage_offset = object->map()->instance_size() + (index * kPointerSize);
+    } else if (index < 0) {
       int offset = object->map()->instance_size() + (index * kPointerSize);
       __ movq(scratch1, FieldOperand(receiver_reg, offset));
     } else {
@@ -1001,7 +1023,7 @@ void StoreStubCompiler::GenerateStoreField(MacroAssembler* masm,
                 miss_label, DONT_DO_SMI_CHECK);
     __ movsd(xmm0, FieldOperand(value_reg, HeapNumber::kValueOffset));
     __ bind(&do_store);
-    __ movsd(FieldOperand(scratch1, HeapNumber::kValueOffset), xmm0);
+    __ movsd(FieldOperand(storage, storage_offset), xmm0);
     // Return the value (register rax).
     ASSERT(value_reg.is(rax));
     __ ret(0);
@@ -1281,12 +1303,14 @@ void LoadStubCompiler::GenerateLoadField(Register reg,
   if (kind() == Code::LOAD_IC) {
     LoadFieldStub stub(field.is_inobject(holder),
                        field.translate(holder),
-                       representation);
+                       representation,
+                       field.is_unboxed_double(holder));
     GenerateTailCall(masm(), stub.GetCode(isolate()));
   } else {
     KeyedLoadFieldStub stub(field.is_inobject(holder),
                             field.translate(holder),
-                            representation);
+                            representation,
+                            field.is_unboxed_double(holder));
     GenerateTailCall(masm(), stub.GetCode(isolate()));
   }
 }
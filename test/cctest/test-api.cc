@@ -6934,6 +6934,79 @@ THREADED_TEST(IndependentWeakHandle) {
 }
 
 
+struct PhantomWrapper {
+  v8::Persistent<v8::Object> handle;
+  void* field1;
+  void* field2;
+  int callback_count;
+};
+
+
+static void PhantomResetAndRecordFields(
+    const v8::PhantomCallbackData<PhantomWrapper>& data) {
+  PhantomWrapper* wrapper = data.GetParameter();
+  wrapper->handle.Reset();
+  wrapper->field1 = data.GetInternalField1();
+  wrapper->field2 = data.GetInternalField2();
+  wrapper->callback_count++;
+}
+
+
+THREADED_TEST(PhantomHandles) {
+  v8::Isolate* iso = CcTest::isolate();
+  v8::HandleScope scope(iso);
+  v8::Handle<Context> context = Context::New(iso);
+  Context::Scope context_scope(context);
+
+  v8::Handle<v8::ObjectTemplate> templ = v8::ObjectTemplate::New();
+  templ->SetInternalFieldCount(2);
+  static const int kCount = 3;
+  static int fields[kCount][2];
+  PhantomWrapper wrappers[kCount];
+  for (int i = 0; i < kCount; i++) {
+    v8::HandleScope handle_scope(iso);
+    v8::Local<v8::Object> object = templ->NewInstance();
+    object->SetAlignedPointerInInternalField(0, &fields[i][0]);
+    object->SetAlignedPointerInInternalField(1, &fields[i][1]);
+    wrappers[i].handle.Reset(iso, object);
+    wrappers[i].field1 = wrappers[i].field2 = NULL;
+    wrappers[i].callback_count = 0;
+    wrappers[i].handle.SetPhantom(&wrappers[i], &PhantomResetAndRecordFields);
+  }
+  // An object without internal fields yields NULL fields.
+  PhantomWrapper plain;
+  {
+    v8::HandleScope handle_scope(iso);
+    plain.handle.Reset(iso, v8::Object::New());
+  }
+  plain.field1 = plain.field2 = &plain;
+  plain.callback_count = 0;
+  plain.handle.SetPhantom(&plain, &PhantomResetAndRecordFields);
+  CHECK(plain.handle.IsWeak());
+
+  // Independent phantom handles are processed by a scavenge.
+  wrappers[0].handle.MarkIndependent();
+  CcTest::heap()->PerformScavenge();
+  CHECK_EQ(1, wrappers[0].callback_count);
+  CHECK(wrappers[0].handle.IsEmpty());
+  CHECK_EQ(&fields[0][0], wrappers[0].field1);
+  CHECK_EQ(&fields[0][1], wrappers[0].field2);
+
+  // A single full collection clears the rest, nothing is kept for a second
+  // cycle.
+  CcTest::heap()->CollectAllGarbage(i::Heap::kNoGCFlags);
+  for (int i = 1; i < kCount; i++) {
+    CHECK_EQ(1, wrappers[i].callback_count);
+    CHECK(wrappers[i].handle.IsEmpty());
+    CHECK_EQ(&fields[i][0], wrappers[i].field1);
+    CHECK_EQ(&fields[i][1], wrappers[i].field2);
+  }
+  CHECK_EQ(1, plain.callback_count);
+  CHECK_EQ(NULL, plain.field1);
+  CHECK_EQ(NULL, plain.field2);
+}
+
+
 static void InvokeScavenge() {
   CcTest::heap()->PerformScavenge();
 }
@@ -14326,6 +14399,49 @@ TEST(PreCompileInvalidPreparseDataError) {
 }
 
 
+// Verifies that stale pre-compilation data, e.g. from an on-disk cache, is
+// ignored instead of being used to parse a different source.
+TEST(PreCompileDataRejectedOnMismatch) {
+  v8::V8::Initialize();
+  v8::Isolate* isolate = CcTest::isolate();
+  LocalContext context;
+  v8::HandleScope scope(context->GetIsolate());
+
+  const char* script = "function foo(){ return 5;}\n"
+      "function bar(){ return 6 + 7;}  foo();";
+  const int kHeaderSize = i::PreparseDataConstants::kHeaderSize;
+  const int kFunctionEntryEndOffset = 1;
+  const int kHashOffsets[] = {
+    i::PreparseDataConstants::kSourceHashOffset,
+    i::PreparseDataConstants::kFlagHashOffset
+  };
+  Local<String> source = String::New(script);
+
+  for (int i = 0; i < 2; i++) {
+    v8::ScriptData* sd =
+        v8::ScriptData::PreCompile(isolate, script, i::StrLength(script));
+    CHECK(!sd->HasError());
+    unsigned* sd_data =
+        reinterpret_cast<unsigned*>(const_cast<char*>(sd->Data()));
+    // Corrupt the data so that using it would throw, then make it look
+    // like it was produced for another source or with other flags.
+    sd_data[kHeaderSize + i::FunctionEntry::kSize + kFunctionEntryEndOffset] =
+        0;
+    sd_data[kHashOffsets[i]]++;
+
+    // Round-trip through the serialized form like an embedder cache would.
+    v8::ScriptData* cached = v8::ScriptData::New(sd->Data(), sd->Length());
+    v8::TryCatch try_catch;
+    Local<Script> compiled_script = Script::New(source, NULL, cached);
+    CHECK(!try_catch.HasCaught());
+    CHECK_EQ(5, compiled_script->Run()->Int32Value());
+
+    delete cached;
+    delete sd;
+  }
+}
+
+
 // Verifies that the Handle<String> and const char* versions of the API produce
 // the same results (at least for one trivial case).
 TEST(PreCompileAPIVariationsAreSame) {
@@ -17032,6 +17148,28 @@ TEST(IdleNotificationWithLargeHint) {
 }
 
 
+// Test that idle notification with a deadline eventually collects garbage.
+TEST(IdleNotificationDeadline) {
+  const intptr_t MB = 1024 * 1024;
+  const double kIdlePauseInSeconds = 0.1;
+  LocalContext env;
+  v8::HandleScope scope(env->GetIsolate());
+  intptr_t initial_size = CcTest::heap()->SizeOfObjects();
+  CreateGarbageInOldSpace();
+  intptr_t size_with_garbage = CcTest::heap()->SizeOfObjects();
+  CHECK_GT(size_with_garbage, initial_size + MB);
+  bool finished = false;
+  for (int i = 0; i < 200 && !finished; i++) {
+    double now_in_seconds = i::OS::TimeCurrentMillis() / 1000;
+    finished = v8::V8::IdleNotificationDeadline(
+        now_in_seconds + kIdlePauseInSeconds);
+  }
+  intptr_t final_size = CcTest::heap()->SizeOfObjects();
+  CHECK(finished);
+  CHECK_LT(final_size, initial_size + 1);
+}
+
+
 TEST(Regress2107) {
   const intptr_t MB = 1024 * 1024;
   const int kShortIdlePauseInMs = 100;
@@ -386,6 +386,89 @@ TEST(OptimizedCodeSharing) {
 }
 
 
+// Test that a function excluded by --hydrogen-filter is not queued for
+// concurrent recompilation over and over again.
+TEST(ConcurrentRecompilationHonorsHydrogenFilter) {
+  FLAG_allow_natives_syntax = true;
+  FLAG_hydrogen_filter = "foo";
+  CcTest::InitializeVM();
+  if (!FLAG_concurrent_recompilation) return;
+  if (!CcTest::i_isolate()->use_crankshaft()) return;
+  v8::HandleScope scope(CcTest::isolate());
+  LocalContext env;
+  CompileRun("function bar(x) { return x + 1; }"
+             "bar(1);"
+             "bar(2);"
+             "%OptimizeFunctionOnNextCall(bar, 'concurrent');"
+             "bar(3);");
+  Handle<JSFunction> bar = v8::Utils::OpenHandle(
+      *v8::Local<v8::Function>::Cast(env->Global()->Get(v8_str("bar"))));
+  CHECK(!bar->IsInRecompileQueue());
+  CHECK(!bar->IsMarkedForConcurrentRecompilation());
+  CHECK(!bar->IsOptimized());
+  CHECK(!bar->IsOptimizable());
+  CHECK(!bar->shared()->code()->optimizable());
+}
+
+
+// Test that a concurrent recompilation request that is turned down because
+// only the full compiler may run leaves the function optimizable.
+TEST(ConcurrentRecompilationWithFullCompilerOnly) {
+  FLAG_allow_natives_syntax = true;
+  FLAG_always_full_compiler = true;
+  CcTest::InitializeVM();
+  if (!FLAG_concurrent_recompilation) return;
+  if (!CcTest::i_isolate()->use_crankshaft()) return;
+  v8::HandleScope scope(CcTest::isolate());
+  LocalContext env;
+  CompileRun("function bar(x) { return x + 1; }"
+             "bar(1);"
+             "bar(2);"
+             "%OptimizeFunctionOnNextCall(bar, 'concurrent');"
+             "bar(3);");
+  Handle<JSFunction> bar = v8::Utils::OpenHandle(
+      *v8::Local<v8::Function>::Cast(env->Global()->Get(v8_str("bar"))));
+  CHECK(!bar->IsInRecompileQueue());
+  CHECK(!bar->IsMarkedForConcurrentRecompilation());
+  CHECK(!bar->IsOptimized());
+  CHECK(bar->shared()->code()->optimizable());
+}
+
+
+// Test that jobs finished by several compiler workers at the same time all
+// reach the output queue and get installed.
+TEST(ConcurrentRecompilationWithSeveralWorkers) {
+  FLAG_allow_natives_syntax = true;
+  FLAG_concurrent_recompilation_threads = 4;
+  FLAG_block_concurrent_recompilation = true;
+  CcTest::InitializeVM();
+  if (!FLAG_concurrent_recompilation) return;
+  if (!CcTest::i_isolate()->use_crankshaft()) return;
+  if (FLAG_always_opt || FLAG_deopt_every_n_times) return;
+  v8::HandleScope scope(CcTest::isolate());
+  LocalContext env;
+  CompileRun("var fs = [];"
+             "for (var i = 0; i < 16; i++) {"
+             "  var f = new Function('x', 'return x + ' + i + ';');"
+             "  f(1);"
+             "  f(2);"
+             "  %OptimizeFunctionOnNextCall(f, 'concurrent');"
+             "  f(3);"
+             "  fs.push(f);"
+             "}");
+  // All jobs are queued and blocked.  Release them at once so that the
+  // workers race to enqueue their results.
+  CcTest::i_isolate()->optimizing_compiler_thread()->Unblock();
+  v8::Local<v8::Value> optimized =
+      CompileRun("var optimized = 0;"
+                 "for (var i = 0; i < fs.length; i++) {"
+                 "  if (%GetOptimizationStatus(fs[i]) == 1) optimized++;"
+                 "}"
+                 "optimized;");
+  CHECK_EQ(16, optimized->Int32Value());
+}
+
+
 #ifdef ENABLE_DISASSEMBLER
 static Handle<JSFunction> GetJSFunction(v8::Handle<v8::Object> obj,
                                  const char* property_name) {
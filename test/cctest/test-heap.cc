@@ -34,6 +34,7 @@
 #include "factory.h"
 #include "macro-assembler.h"
 #include "global-handles.h"
+#include "snapshot.h"
 #include "stub-cache.h"
 #include "cctest.h"
 
@@ -3516,3 +3517,914 @@ TEST(IncrementalMarkingStepMakesBigProgressWithLargeObjects) {
   marking->Step(100 * MB, IncrementalMarking::NO_GC_VIA_STACK_GUARD);
   ASSERT(marking->IsComplete());
 }
+
+
+TEST(ParallelScavenge) {
+  i::FLAG_parallel_scavenging = true;
+  i::FLAG_scavenger_threads = 2;
+  // The tasks do not run while incremental marking is in progress.
+  i::FLAG_incremental_marking = false;
+#ifdef VERIFY_HEAP
+  i::FLAG_verify_heap = true;
+#endif
+  CcTest::InitializeVM();
+  Isolate* isolate = CcTest::i_isolate();
+  Factory* factory = isolate->factory();
+  Heap* heap = isolate->heap();
+  v8::HandleScope scope(CcTest::isolate());
+
+  // Each round, old space arrays are filled with pointers to young arrays,
+  // which gives the tasks plenty of objects to evacuate and to share with each
+  // other.  All young arrays point to the same few heap numbers, so the tasks
+  // race to copy them and have to agree on a single forwarding address.
+  static const int kShared = 8;
+  static const int kArrays = 16;
+  static const int kLength = 1024;
+  Handle<FixedArray> arrays = factory->NewFixedArray(kArrays, TENURED);
+  for (int i = 0; i < kArrays; i++) {
+    arrays->set(i, *factory->NewFixedArray(kLength, TENURED));
+  }
+
+  int objects_evacuated_by_helpers = 0;
+  for (int round = 0; round < 4; round++) {
+    v8::HandleScope round_scope(CcTest::isolate());
+    Handle<FixedArray> numbers = factory->NewFixedArray(kShared);
+    for (int i = 0; i < kShared; i++) {
+      numbers->set(i, *factory->NewHeapNumber(round * kShared + i));
+    }
+    for (int i = 0; i < kArrays; i++) {
+      Handle<FixedArray> array(FixedArray::cast(arrays->get(i)));
+      for (int j = 0; j < kLength; j++) {
+        Handle<FixedArray> element = factory->NewFixedArray(2);
+        element->set(0, Smi::FromInt(j));
+        element->set(1, numbers->get(j % kShared));
+        array->set(j, *element);
+      }
+    }
+
+    heap->CollectGarbage(NEW_SPACE);
+    objects_evacuated_by_helpers +=
+        heap->objects_evacuated_by_scavenger_threads();
+#ifdef VERIFY_HEAP
+    heap->Verify();
+#endif
+
+    for (int i = 0; i < kArrays; i++) {
+      FixedArray* array = FixedArray::cast(arrays->get(i));
+      for (int j = 0; j < kLength; j++) {
+        FixedArray* element = FixedArray::cast(array->get(j));
+        CHECK_EQ(j, Smi::cast(element->get(0))->value());
+        CHECK_EQ(numbers->get(j % kShared), element->get(1));
+      }
+    }
+    for (int i = 0; i < kShared; i++) {
+      CHECK_EQ(static_cast<double>(round * kShared + i),
+               HeapNumber::cast(numbers->get(i))->value());
+    }
+  }
+
+  // The helper threads did part of the work.
+  CHECK_GT(objects_evacuated_by_helpers, 0);
+}
+
+
+TEST(ParallelMarking) {
+  i::FLAG_parallel_marking = true;
+  i::FLAG_marking_threads = 2;
+  // Objects marked incrementally are not marked again by the tasks.
+  i::FLAG_incremental_marking = false;
+#ifdef VERIFY_HEAP
+  i::FLAG_verify_heap = true;
+#endif
+  CcTest::InitializeVM();
+  Heap* heap = CcTest::heap();
+  MarkCompactCollector* collector = heap->mark_compact_collector();
+  v8::HandleScope scope(CcTest::isolate());
+
+  // Marking the wide array puts enough objects on the marking stack for a
+  // parallel phase, and they are split among all tasks.  The binary tree is
+  // reachable from a single root only, so the task that marks the root holds
+  // all of its work and the other tasks can only take part by stealing.
+  CompileRun("var wide = [];"
+             "for (var i = 0; i < 4096; i++) wide.push({ value: i });"
+             "function Node(depth) {"
+             "  this.left = depth > 0 ? new Node(depth - 1) : null;"
+             "  this.right = depth > 0 ? new Node(depth - 1) : null;"
+             "}"
+             "function count(node) {"
+             "  return node ? 1 + count(node.left) + count(node.right) : 0;"
+             "}"
+             "var tree = new Node(14);"
+             "var garbage = [];"
+             "for (var i = 0; i < 10000; i++) garbage.push({ value: i });"
+             "garbage = null;");
+
+  for (int i = 0; i < 3; i++) {
+    heap->CollectAllGarbage(Heap::kNoGCFlags);
+    // The helper threads did part of the marking.
+    CHECK_GT(collector->objects_marked_by_marking_threads(), 0);
+  }
+
+  CHECK_EQ((1 << 15) - 1, CompileRun("count(tree)")->Int32Value());
+  CHECK_EQ(8386560, CompileRun("var sum = 0;"
+                               "for (var i = 0; i < wide.length; i++) {"
+                               "  sum += wide[i].value;"
+                               "}"
+                               "sum")->Int32Value());
+}
+
+
+TEST(ParallelCompaction) {
+  i::FLAG_parallel_compaction = true;
+  i::FLAG_compaction_threads = 2;
+  i::FLAG_stress_compaction = true;
+#ifdef VERIFY_HEAP
+  i::FLAG_verify_heap = true;
+#endif
+  CcTest::InitializeVM();
+  Isolate* isolate = CcTest::i_isolate();
+  Factory* factory = isolate->factory();
+  Heap* heap = isolate->heap();
+  v8::HandleScope scope(CcTest::isolate());
+
+  // Live arrays that point to each other, interleaved with garbage, spread
+  // over many old space pages.  Stress compaction picks about every other
+  // page as an evacuation candidate.
+  static const int kLength = 2048;
+  Handle<FixedArray> array = factory->NewFixedArray(kLength, TENURED);
+  for (int i = 0; i < kLength; i++) {
+    factory->NewFixedArray(1000, TENURED);
+    Handle<FixedArray> element = factory->NewFixedArray(4, TENURED);
+    element->set(0, Smi::FromInt(i));
+    if (i > 0) element->set(1, array->get(i - 1));
+    array->set(i, *element);
+  }
+
+  ScopedVector<Address> old_addresses(kLength);
+  for (int i = 0; i < kLength; i++) {
+    old_addresses[i] = HeapObject::cast(array->get(i))->address();
+  }
+
+  heap->CollectAllGarbage(Heap::kNoGCFlags);
+
+  // Pages are evacuated as a whole: the live objects of an evacuated page all
+  // moved to other pages, those of the other pages all stayed where they were.
+  int moved = 0;
+  for (int i = 0; i < kLength; i++) {
+    FixedArray* element = FixedArray::cast(array->get(i));
+    CHECK_EQ(i, Smi::cast(element->get(0))->value());
+    if (i > 0) CHECK_EQ(array->get(i - 1), element->get(1));
+    bool element_moved = element->address() != old_addresses[i];
+    if (element_moved) {
+      moved++;
+      CHECK(Page::FromAddress(element->address()) !=
+            Page::FromAddress(old_addresses[i]));
+    }
+    if (i > 0 && Page::FromAddress(old_addresses[i]) ==
+                 Page::FromAddress(old_addresses[i - 1])) {
+      bool previous_moved =
+          array->get(i - 1) != HeapObject::FromAddress(old_addresses[i - 1]);
+      CHECK(previous_moved == element_moved);
+    }
+  }
+  CHECK_GT(moved, 0);
+
+  // Without room to expand old pointer space the tasks give up evacuation.
+  // The candidates they did not get to are left intact and can be compacted
+  // by the next collection.
+  heap->old_pointer_space()->SetMaxCapacity(0);
+  heap->CollectAllGarbage(Heap::kNoGCFlags);
+#ifdef VERIFY_HEAP
+  heap->Verify();
+#endif
+  heap->old_pointer_space()->SetMaxCapacity(heap->MaxOldGenerationSize());
+  heap->CollectAllGarbage(Heap::kNoGCFlags);
+  for (int i = 0; i < kLength; i++) {
+    FixedArray* element = FixedArray::cast(array->get(i));
+    CHECK_EQ(i, Smi::cast(element->get(0))->value());
+    if (i > 0) CHECK_EQ(array->get(i - 1), element->get(1));
+  }
+}
+
+
+
+TEST(ConcurrentMarking) {
+  i::FLAG_concurrent_marking = true;
+#ifdef VERIFY_HEAP
+  i::FLAG_verify_heap = true;
+#endif
+  CcTest::InitializeVM();
+  if (!i::FLAG_incremental_marking) return;
+  v8::HandleScope scope(CcTest::isolate());
+  Heap* heap = CcTest::heap();
+
+  CompileRun("var objects = [];"
+             "for (var i = 0; i < 20000; i++) {"
+             "  objects.push({ index: i, name: 'o' + i, next: null });"
+             "}"
+             "var queue = objects.slice(0);"
+             "var round = 0;");
+  // Promote everything, so that the objects are eligible for scanning on the
+  // marking thread.  Sweeping precisely lets marking start right away.
+  heap->CollectAllGarbage(Heap::kNoGCFlags);
+  heap->CollectAllGarbage(Heap::kMakeHeapIterableMask);
+
+  MarkCompactCollector* collector = heap->mark_compact_collector();
+  if (collector->IsConcurrentSweepingInProgress()) {
+    collector->WaitUntilSweepingCompleted();
+  }
+  // Objects are handed off to the marking thread only when not compacting.
+  IncrementalMarking* marking = heap->incremental_marking();
+  CHECK(marking->IsStopped());
+  marking->Start(IncrementalMarking::PREVENT_COMPACTION);
+  CHECK(marking->IsMarking());
+
+  // Mutate objects while they may be scanned on the marking thread: store
+  // new objects into them and left trim the backing store of an array.
+  do {
+    CompileRun("for (var i = 0; i < 100; i++) {"
+               "  var o = objects[(round * 100 + i) % objects.length];"
+               "  o.next = { value: 'n' + o.index };"
+               "}"
+               "queue.shift();"
+               "round++;");
+    marking->Step(MB, IncrementalMarking::NO_GC_VIA_STACK_GUARD);
+  } while (!marking->IsComplete());
+  heap->CollectAllGarbage(Heap::kNoGCFlags);
+
+  v8::Handle<v8::Value> result = CompileRun(
+      "var ok = true;"
+      "for (var i = 0; i < objects.length; i++) {"
+      "  var o = objects[i];"
+      "  if (o.index != i || o.name != 'o' + i) ok = false;"
+      "  if (o.next !== null && o.next.value != 'n' + i) ok = false;"
+      "}"
+      "ok && queue.length == Math.max(0, objects.length - round);");
+  CHECK(result->BooleanValue());
+}
+
+
+TEST(SweepingOnDemand) {
+  i::FLAG_concurrent_sweeping = true;
+  i::FLAG_sweeper_threads = 2;
+  CcTest::InitializeVM();
+  Isolate* isolate = CcTest::i_isolate();
+  Factory* factory = isolate->factory();
+  Heap* heap = isolate->heap();
+  MarkCompactCollector* collector = heap->mark_compact_collector();
+  v8::HandleScope scope(CcTest::isolate());
+
+  // Fill several old space pages with mostly garbage so that there is
+  // something left for the sweeper threads after the collection.
+  static const int kLength = 4096;
+  Handle<FixedArray> array = factory->NewFixedArray(kLength, TENURED);
+  for (int i = 0; i < kLength; i++) {
+    array->set(i, *factory->NewFixedArray(16, TENURED));
+    for (int j = 0; j < 8; j++) {
+      factory->NewFixedArray(16, TENURED);
+      factory->NewHeapNumber(j, TENURED);
+    }
+  }
+
+  for (int i = 0; i < 3; i++) {
+    heap->CollectAllGarbage(Heap::kNoGCFlags);
+    if (collector->IsConcurrentSweepingInProgress()) {
+      // Sweep whatever the sweeper threads have not claimed yet on the main
+      // thread. Pages are never swept twice.
+      collector->SweepOnDemand(heap->old_pointer_space(), kMaxInt);
+      collector->SweepOnDemand(heap->old_data_space(), kMaxInt);
+      CHECK(collector->SweepOnDemand(heap->old_pointer_space(), 1) == 0);
+      CHECK(collector->SweepOnDemand(heap->old_data_space(), 1) == 0);
+      collector->WaitUntilSweepingCompleted();
+    }
+    CHECK(!collector->IsConcurrentSweepingInProgress());
+    PageIterator it(heap->old_pointer_space());
+    while (it.has_next()) {
+      Page* p = it.next();
+      CHECK(p->parallel_sweeping() == 0);
+      CHECK(p->WasSwept());
+    }
+  }
+
+  for (int i = 0; i < kLength; i++) {
+    CHECK_EQ(16, FixedArray::cast(array->get(i))->length());
+  }
+}
+
+
+TEST(RememberedSetOfLargeObject) {
+#ifdef VERIFY_HEAP
+  i::FLAG_verify_heap = true;
+#endif
+  CcTest::InitializeVM();
+  Isolate* isolate = CcTest::i_isolate();
+  Factory* factory = isolate->factory();
+  Heap* heap = isolate->heap();
+  v8::HandleScope scope(CcTest::isolate());
+
+  // The array spans several pages of the large object space and far more of
+  // its slots point to new space than fit into the store buffer.
+  static const int kLength = 3 * Page::kPageSize / kPointerSize;
+  Handle<FixedArray> array = factory->NewFixedArray(kLength, TENURED);
+  CHECK(heap->lo_space()->Contains(*array));
+  for (int i = 0; i < kLength; i += 7) {
+    Handle<HeapNumber> number = factory->NewHeapNumber(i);
+    CHECK(heap->InNewSpace(*number));
+    array->set(i, *number);
+  }
+
+  for (int i = 0; i < 3; i++) {
+    heap->CollectGarbage(NEW_SPACE);
+  }
+
+  for (int i = 0; i < kLength; i++) {
+    if (i % 7 == 0) {
+      CHECK_EQ(static_cast<double>(i),
+               HeapNumber::cast(array->get(i))->value());
+    } else {
+      CHECK(array->get(i)->IsUndefined());
+    }
+  }
+}
+
+
+TEST(GCIdleTimeHandler) {
+  GCIdleTimeHandler handler;
+  GCIdleTimeHandler::HeapState state;
+  state.size_of_objects = 10 * MB;
+  state.new_space_size = 0;
+  state.new_space_capacity = 1 * MB;
+  state.contexts_disposed = 0;
+  state.remaining_mark_sweeps_in_idle_round = 7;
+  state.incremental_marking_stopped = true;
+  state.incremental_marking_complete = false;
+  state.can_start_incremental_marking = true;
+  state.sweeping_in_progress = false;
+
+  // Without history the conservative marking speed determines the step.
+  GCIdleTimeAction action = handler.Compute(10, state);
+  CHECK_EQ(GCIdleTimeAction::DO_INCREMENTAL_MARKING, action.type());
+  CHECK(action.parameter() == GCIdleTimeHandler::EstimateMarkingStepSize(
+      10, GCIdleTimeHandler::kInitialConservativeMarkingSpeed));
+
+  // Observed marking steps replace the initial estimate.
+  handler.NotifyIncrementalMarkingStep(1 * MB, 1);
+  action = handler.Compute(10, state);
+  CHECK_EQ(GCIdleTimeAction::DO_INCREMENTAL_MARKING, action.type());
+  CHECK(action.parameter() ==
+        GCIdleTimeHandler::EstimateMarkingStepSize(10, 1 * MB));
+
+  // A nearly full new space is scavenged if the scavenge fits.
+  state.new_space_size = state.new_space_capacity;
+  handler.NotifyScavenge(1 * MB, 1);
+  CHECK_EQ(GCIdleTimeAction::DO_SCAVENGE, handler.Compute(10, state).type());
+  CHECK_EQ(GCIdleTimeAction::DO_INCREMENTAL_MARKING,
+           handler.Compute(0.5, state).type());
+  state.new_space_size = 0;
+
+  // Finalizing marking has to fit into the idle time.
+  state.incremental_marking_stopped = false;
+  state.incremental_marking_complete = true;
+  handler.NotifyFinalizeMarkCompact(10 * MB, 5);
+  CHECK_EQ(GCIdleTimeAction::DO_FULL_GC, handler.Compute(10, state).type());
+  CHECK_EQ(GCIdleTimeAction::DO_NOTHING, handler.Compute(1, state).type());
+
+  // Towards the end of an idle round a memory reducing GC is scheduled.
+  state.incremental_marking_stopped = true;
+  state.incremental_marking_complete = false;
+  state.remaining_mark_sweeps_in_idle_round = 2;
+  handler.NotifyMarkCompact(10 * MB, 20);
+  CHECK_EQ(GCIdleTimeAction::DO_FULL_GC, handler.Compute(100, state).type());
+  CHECK_EQ(GCIdleTimeAction::DO_INCREMENTAL_MARKING,
+           handler.Compute(10, state).type());
+
+  state.remaining_mark_sweeps_in_idle_round = 0;
+  CHECK_EQ(GCIdleTimeAction::DONE, handler.Compute(10, state).type());
+}
+
+
+TEST(HeapController) {
+  // At 50% overhead the mutator runs as long as the GC.
+  CHECK_EQ(2.0, HeapController::HeapGrowingFactor(0.5, 1 * MB, 1 * MB));
+  CHECK(1 * MB == HeapController::NewSpaceCapacity(0.5, 1 * MB, 1));
+  // At 5% overhead it runs 19 times as long.
+  CHECK_EQ(HeapController::kMinHeapGrowingFactor,
+           HeapController::HeapGrowingFactor(0.05, 1 * KB, 1 * MB));
+  CHECK_EQ(HeapController::kMaxHeapGrowingFactor,
+           HeapController::HeapGrowingFactor(0.05, 1 * MB, 1 * MB));
+  intptr_t capacity = HeapController::NewSpaceCapacity(0.05, 1 * MB, 1);
+  CHECK(capacity > 18 * MB && capacity <= 19 * MB);
+
+  HeapController controller;
+  controller.set_target_gc_overhead_percent(0);
+  CHECK(!controller.IsEnabled());
+  CHECK_EQ(0.0, controller.HeapGrowingFactor(1 * MB));
+  controller.set_target_gc_overhead_percent(5);
+  CHECK(controller.IsEnabled());
+  // Nothing is known before the first collections were observed.
+  CHECK_EQ(0.0, controller.HeapGrowingFactor(1 * MB));
+  CHECK(controller.NewSpaceCapacity(1 * MB) == 0);
+
+  // A scavenge copies 1000 KB in 10 ms.  Until the next scavenge 10 ms later
+  // the mutator allocates 1000 KB in new space and the old generation grows
+  // by 100 KB.
+  controller.NotifyGCStart(1000, 1000 * KB, 10 * MB);
+  controller.NotifyGCEnd(SCAVENGER, 1010, 10, 1000 * KB, 0, 10 * MB);
+  controller.NotifyGCStart(1020, 1000 * KB, 10 * MB + 100 * KB);
+  CHECK(controller.NewSpaceAllocationRateInBytesPerMs() == 100 * KB);
+  CHECK(controller.OldGenerationAllocationRateInBytesPerMs() == 5 * KB);
+  CHECK(controller.SurvivorScavengeSpeedInBytesPerMs() == 100 * KB);
+  CHECK(controller.NewSpaceCapacity(1000 * KB) ==
+        HeapController::NewSpaceCapacity(0.05, 100 * KB, 10));
+  CHECK_EQ(HeapController::HeapGrowingFactor(0.05, 5 * KB, 128 * KB),
+           controller.HeapGrowingFactor(128 * KB));
+}
+
+
+TEST(HeapControllerSetByResourceConstraints) {
+  v8::Isolate* isolate = v8::Isolate::New();
+  v8::ResourceConstraints constraints;
+  constraints.set_target_gc_overhead_percent(7);
+  CHECK(v8::SetResourceConstraints(isolate, &constraints));
+  Isolate* i_isolate = reinterpret_cast<Isolate*>(isolate);
+  CHECK_EQ(7, i_isolate->heap()->heap_controller()->
+                  target_gc_overhead_percent());
+  constraints.set_target_gc_overhead_percent(
+      HeapController::kMaxTargetGCOverheadPercent + 1);
+  CHECK(!v8::SetResourceConstraints(isolate, &constraints));
+  isolate->Dispose();
+}
+
+
+// Full GCs age RegExp code by moving it to the saved code slot.
+static bool HasRegExpCode(JSRegExp* re) {
+  return re->DataAt(JSRegExp::code_index(true))->IsCode() ||
+         re->DataAt(JSRegExp::saved_code_index(true))->IsCode();
+}
+
+
+TEST(MemoryPressureNotification) {
+  i::FLAG_expose_gc = false;
+  CcTest::InitializeVM();
+  Heap* heap = CcTest::heap();
+  NewSpace* new_space = heap->new_space();
+  v8::HandleScope scope(CcTest::isolate());
+
+  v8::Local<v8::Value> result = CompileRun("var re = /a(b|c)d/;"
+                                           "re.exec('abd');"
+                                           "re");
+  Handle<JSRegExp> re = Handle<JSRegExp>::cast(
+      v8::Utils::OpenHandle(*v8::Local<v8::Object>::Cast(result)));
+  CHECK(HasRegExpCode(*re));
+
+  heap->CollectAllGarbage(Heap::kAbortIncrementalMarkingMask);
+  CHECK(heap->incremental_marking()->IsStopped());
+  new_space->Grow();
+  CHECK_GT(new_space->Capacity(), new_space->InitialCapacity());
+
+  // Moderate pressure gives back new space and starts compacting
+  // incrementally, but leaves compiled code alone.
+  CcTest::isolate()->MemoryPressureNotification(v8::kMemoryPressureModerate);
+  CHECK(new_space->Capacity() == new_space->InitialCapacity());
+  CHECK(!heap->incremental_marking()->IsStopped());
+  CHECK(HasRegExpCode(*re));
+
+  // Critical pressure flushes RegExp code immediately.
+  CcTest::isolate()->MemoryPressureNotification(v8::kMemoryPressureCritical);
+  CHECK(heap->incremental_marking()->IsStopped());
+  CHECK(!HasRegExpCode(*re));
+
+  // The RegExp still works and is compiled again.
+  CHECK(CompileRun("re.exec('acd') != null")->BooleanValue());
+  CHECK(HasRegExpCode(*re));
+}
+
+
+TEST(PooledChunksAreReused) {
+  CcTest::InitializeVM();
+  Isolate* isolate = CcTest::i_isolate();
+  Factory* factory = isolate->factory();
+  Heap* heap = isolate->heap();
+  MemoryAllocator* allocator = isolate->memory_allocator();
+  heap->CollectAllAvailableGarbage();
+  CHECK(allocator->PooledSize() == 0);
+
+  // Fill a few pages of old pointer space and let them die.
+  static const int kArrayLength = 1000;
+  int arrays = 8 * Page::kPageSize / FixedArray::SizeFor(kArrayLength);
+  {
+    v8::HandleScope scope(CcTest::isolate());
+    for (int i = 0; i < arrays; i++) {
+      factory->NewFixedArray(kArrayLength, TENURED);
+    }
+  }
+  heap->CollectAllGarbage(Heap::kMakeHeapIterableMask);
+  heap->CollectAllGarbage(Heap::kMakeHeapIterableMask);
+  intptr_t pooled = allocator->PooledSize();
+  CHECK_GT(pooled, 0);
+
+  v8::HeapStatistics stats;
+  CcTest::isolate()->GetHeapStatistics(&stats);
+  CHECK_EQ(pooled, static_cast<intptr_t>(stats.pooled_memory_size()));
+
+  // New pages are taken from the pool.
+  {
+    v8::HandleScope scope(CcTest::isolate());
+    for (int i = 0; i < arrays; i++) {
+      factory->NewFixedArray(kArrayLength, TENURED);
+    }
+  }
+  CHECK_LT(allocator->PooledSize(), pooled);
+
+  heap->CollectAllAvailableGarbage();
+  CHECK(allocator->PooledSize() == 0);
+}
+
+
+TEST(BlackAllocation) {
+  i::FLAG_black_allocation = true;
+  i::FLAG_never_compact = true;
+  CcTest::InitializeVM();
+  Isolate* isolate = CcTest::i_isolate();
+  Heap* heap = isolate->heap();
+  Factory* factory = isolate->factory();
+  v8::HandleScope scope(CcTest::isolate());
+  heap->CollectAllGarbage(Heap::kNoGCFlags);
+  MarkCompactCollector* collector = heap->mark_compact_collector();
+  if (collector->IsConcurrentSweepingInProgress()) {
+    collector->WaitUntilSweepingCompleted();
+  }
+  IncrementalMarking* marking = heap->incremental_marking();
+  marking->Abort();
+  marking->Start();
+  CHECK(marking->IsMarking());
+  CHECK(marking->black_allocation());
+
+  // Tenured objects are allocated black, young objects stay white.
+  Handle<FixedArray> array = factory->NewFixedArray(4, TENURED);
+  Handle<String> string =
+      factory->NewStringFromAscii(CStrVector("black"), TENURED);
+  Handle<JSObject> object = factory->NewJSObjectFromMap(
+      Handle<Map>(isolate->object_function()->initial_map()), TENURED);
+  Handle<FixedArray> young = factory->NewFixedArray(4);
+  CHECK(Marking::IsBlack(Marking::MarkBitFrom(*array)));
+  CHECK(Marking::IsBlack(Marking::MarkBitFrom(*string)));
+  CHECK(Marking::IsBlack(Marking::MarkBitFrom(*object)));
+  CHECK(Marking::IsWhite(Marking::MarkBitFrom(*young)));
+
+  // Values stored into black allocated objects survive the cycle.
+  array->set(0, *young);
+  heap->CollectAllGarbage(Heap::kNoGCFlags);
+  CHECK(!marking->black_allocation());
+  CHECK(array->get(0)->IsFixedArray());
+  CHECK_EQ(*young, array->get(0));
+  heap->CollectAllGarbage(Heap::kNoGCFlags);
+  CHECK(array->get(0)->IsFixedArray());
+}
+
+
+TEST(ScavengesBeforePromotion) {
+  i::FLAG_scavenges_before_promotion = 3;
+#ifdef VERIFY_HEAP
+  i::FLAG_verify_heap = true;
+#endif
+  CcTest::InitializeVM();
+  Isolate* isolate = CcTest::i_isolate();
+  Factory* factory = isolate->factory();
+  Heap* heap = isolate->heap();
+  v8::HandleScope scope(CcTest::isolate());
+  heap->CollectAllGarbage(Heap::kNoGCFlags);
+  CHECK_EQ(3, heap->new_space()->promotion_age());
+
+  // A young array that stays reachable is copied within new space until it
+  // has survived three scavenges.
+  Handle<FixedArray> array = factory->NewFixedArray(4);
+  array->set(0, *factory->NewHeapNumber(1.5));
+  for (int i = 0; i < 3; i++) {
+    heap->CollectGarbage(NEW_SPACE);
+    CHECK(heap->InNewSpace(*array));
+#ifdef VERIFY_HEAP
+    heap->Verify();
+#endif
+  }
+  heap->CollectGarbage(NEW_SPACE);
+  CHECK(!heap->InNewSpace(*array));
+  CHECK_EQ(1.5, HeapNumber::cast(array->get(0))->value());
+  CHECK(heap->promotion_rate() > 0);
+}
+
+
+#if V8_TARGET_ARCH_X64
+TEST(UnboxedDoubleFields) {
+  i::FLAG_unbox_double_fields = true;
+  i::FLAG_track_double_fields = true;
+  i::FLAG_allow_natives_syntax = true;
+#ifdef VERIFY_HEAP
+  i::FLAG_verify_heap = true;
+#endif
+  CcTest::InitializeVM();
+  Heap* heap = CcTest::heap();
+  v8::HandleScope scope(CcTest::isolate());
+
+  v8::Local<v8::Value> res = CompileRun(
+      "function Point(x, y) { this.x = x; this.y = y; this.tag = {}; }"
+      "var p = new Point(1.5, 2.5);"
+      "p;");
+  Handle<JSObject> o =
+      v8::Utils::OpenHandle(*v8::Handle<v8::Object>::Cast(res));
+  CHECK(o->map()->HasUnboxedDoubleFields());
+  CHECK(o->IsUnboxedDoubleField(0));
+  CHECK(o->IsUnboxedDoubleField(1));
+  CHECK(!o->IsUnboxedDoubleField(2));
+  CHECK_EQ(1.5, o->RawFastDoublePropertyAt(0));
+
+  // Raw doubles survive being copied by the scavenger and the full collector.
+  heap->CollectGarbage(NEW_SPACE);
+  heap->CollectGarbage(NEW_SPACE);
+  heap->CollectAllGarbage(Heap::kNoGCFlags);
+  CHECK_EQ(4.0, CompileRun("p.x + p.y")->NumberValue());
+  CHECK(CompileRun("typeof p.tag === 'object'")->BooleanValue());
+
+  // Monomorphic load ICs read the raw double, both on the receiver and on a
+  // prototype holder, and so does optimized code.
+  CompileRun(
+      "function getX(o) { return o.x; }"
+      "function getKeyed(o, key) { return o[key]; }"
+      "var child = Object.create(p);"
+      "function getChildX() { return child.x; }"
+      "var sum = 0;"
+      "for (var i = 0; i < 10; i++) {"
+      "  sum += getX(p) + getKeyed(p, 'y') + getChildX();"
+      "}");
+  CHECK_EQ(55.0, CompileRun("sum")->NumberValue());
+  v8::Local<v8::Value> get_x = CompileRun(
+      "%OptimizeFunctionOnNextCall(getX);"
+      "getX(p);"
+      "getX");
+  CHECK_EQ(1.5, CompileRun("getX(p)")->NumberValue());
+  Handle<JSFunction> get_x_function =
+      v8::Utils::OpenHandle(*v8::Handle<v8::Function>::Cast(get_x));
+  CHECK(!CcTest::i_isolate()->use_crankshaft() ||
+        get_x_function->IsOptimized());
+
+  // Storing a non-number generalizes the field back to a tagged one.
+  CompileRun("p.x = 'x';");
+  CHECK(!o->IsUnboxedDoubleField(0));
+  CHECK_EQ(2.5, CompileRun("p.y")->NumberValue());
+}
+#endif  // V8_TARGET_ARCH_X64
+
+
+TEST(StringDeduplication) {
+  i::FLAG_string_deduplication = true;
+  i::FLAG_always_compact = true;
+#ifdef VERIFY_HEAP
+  i::FLAG_verify_heap = true;
+#endif
+  CcTest::InitializeVM();
+  Isolate* isolate = CcTest::i_isolate();
+  Factory* factory = isolate->factory();
+  Heap* heap = isolate->heap();
+  v8::HandleScope scope(CcTest::isolate());
+
+  // Enough equal tenured strings to fill several old data space pages.
+  static const int kStrings = 50000;
+  const char* payload = "a repeated payload key";
+  Handle<FixedArray> strings = factory->NewFixedArray(kStrings, TENURED);
+  for (int i = 0; i < kStrings; i++) {
+    Handle<String> string =
+        factory->NewStringFromAscii(CStrVector(payload), TENURED);
+    CHECK(string->IsSeqOneByteString());
+    strings->set(i, *string);
+  }
+  CHECK(strings->get(kStrings - 1) != strings->get(kStrings - 2));
+
+  heap->CollectAllGarbage(Heap::kNoGCFlags);
+
+  // Duplicates on evacuated pages now share a single copy.
+  CHECK(strings->get(kStrings - 1) == strings->get(kStrings - 2));
+  String* merged = String::cast(strings->get(kStrings - 1));
+  CHECK(merged->IsUtf8EqualTo(CStrVector(payload)));
+}
+
+
+TEST(ParallelStringTablePruning) {
+  i::FLAG_parallel_weak_processing = true;
+  i::FLAG_compaction_threads = 2;
+  CcTest::InitializeVM();
+  Isolate* isolate = CcTest::i_isolate();
+  Factory* factory = isolate->factory();
+  Heap* heap = isolate->heap();
+  v8::HandleScope scope(CcTest::isolate());
+
+  static const int kStrings = 20000;
+  static const int kKept = 100;
+  static const int kStride = kStrings / kKept;
+  Handle<FixedArray> kept = factory->NewFixedArray(kKept);
+  {
+    v8::HandleScope inner_scope(CcTest::isolate());
+    EmbeddedVector<char, 32> buffer;
+    for (int i = 0; i < kStrings; i++) {
+      OS::SNPrintF(buffer, "pruned_string_%d", i);
+      Handle<String> string = factory->InternalizeUtf8String(buffer.start());
+      if (i % kStride == 0) kept->set(i / kStride, *string);
+    }
+  }
+  int capacity = heap->string_table()->Capacity();
+  int elements = heap->string_table()->NumberOfElements();
+
+  heap->CollectAllGarbage(Heap::kNoGCFlags);
+
+  // The dead strings are gone and the sparse table has been shrunk.
+  CHECK_LE(heap->string_table()->NumberOfElements(),
+           elements - kStrings + kKept);
+  CHECK_LT(heap->string_table()->Capacity(), capacity);
+  for (int i = 0; i < kKept; i++) {
+    String* result;
+    String* string = String::cast(kept->get(i));
+    CHECK(heap->string_table()->LookupStringIfExists(string, &result));
+    CHECK_EQ(string, result);
+  }
+}
+
+
+static size_t RaiseHeapLimitOnce(void* data,
+                                 size_t current_heap_limit,
+                                 size_t initial_heap_limit) {
+  int* invocations = reinterpret_cast<int*>(data);
+  (*invocations)++;
+  CHECK(current_heap_limit == initial_heap_limit);
+  return current_heap_limit * 4;
+}
+
+
+TEST(NearHeapLimitCallbackRaisesLimit) {
+  // It's not possible to read a snapshot into a heap with different dimensions.
+  if (Snapshot::IsEnabled()) return;
+  static const int kOldSpaceSize = 16 * MB;
+  v8::ResourceConstraints constraints;
+  constraints.set_max_young_space_size(256 * KB);
+  constraints.set_max_old_space_size(kOldSpaceSize);
+  v8::SetResourceConstraints(CcTest::isolate(), &constraints);
+  CcTest::InitializeVM();
+  Heap* heap = CcTest::heap();
+  v8::HandleScope scope(CcTest::isolate());
+
+  int invocations = 0;
+  intptr_t initial_limit = heap->MaxOldGenerationSize();
+  CcTest::isolate()->AddNearHeapLimitCallback(RaiseHeapLimitOnce,
+                                              &invocations);
+
+  // Keep about twice the initial limit alive.
+  CompileRun("var a = [];"
+             "for (var i = 0; i < 32 * 1024; i++) a.push(new Array(128));");
+  CHECK_EQ(1, invocations);
+  CHECK_EQ(4 * initial_limit, heap->MaxOldGenerationSize());
+
+  // The limit is only restored once the heap has shrunk below it.
+  CcTest::isolate()->RemoveNearHeapLimitCallback(RaiseHeapLimitOnce,
+                                                 initial_limit);
+  CHECK_EQ(4 * initial_limit, heap->MaxOldGenerationSize());
+  CompileRun("a = null;");
+  heap->CollectAllAvailableGarbage();
+  CcTest::isolate()->AddNearHeapLimitCallback(RaiseHeapLimitOnce,
+                                              &invocations);
+  CcTest::isolate()->RemoveNearHeapLimitCallback(RaiseHeapLimitOnce,
+                                                 initial_limit);
+  CHECK_EQ(initial_limit, heap->MaxOldGenerationSize());
+}
+
+
+TEST(ForcedGCsNearHeapLimitAreNotIneffective) {
+  // It's not possible to read a snapshot into a heap with different dimensions.
+  if (Snapshot::IsEnabled()) return;
+  static const int kOldSpaceSize = 16 * MB;
+  v8::ResourceConstraints constraints;
+  constraints.set_max_young_space_size(256 * KB);
+  constraints.set_max_old_space_size(kOldSpaceSize);
+  v8::SetResourceConstraints(CcTest::isolate(), &constraints);
+  CcTest::InitializeVM();
+  Isolate* isolate = CcTest::i_isolate();
+  Factory* factory = isolate->factory();
+  Heap* heap = isolate->heap();
+  v8::HandleScope scope(CcTest::isolate());
+
+  // Fill the old generation with live arrays until it is close to its limit.
+  Handle<FixedArray> holder = factory->NewFixedArray(16 * KB, TENURED);
+  int length = 0;
+  while (!heap->IsCloseToOutOfMemory()) {
+    CHECK_LT(length, holder->length());
+    holder->set(length++, *factory->NewFixedArray(1024, TENURED));
+  }
+
+  // Back-to-back collections that free nothing, but that no allocation
+  // needed, must not be taken for thrashing.
+  for (int i = 0; i < 8; i++) {
+    heap->CollectAllGarbage(Heap::kNoGCFlags, "forced");
+  }
+  v8::V8::LowMemoryNotification();
+  CcTest::isolate()->MemoryPressureNotification(v8::kMemoryPressureCritical);
+  CHECK(heap->IsCloseToOutOfMemory());
+
+  // Removing a callback that is not registered does nothing.
+  intptr_t limit = heap->MaxOldGenerationSize();
+  CcTest::isolate()->RemoveNearHeapLimitCallback(RaiseHeapLimitOnce, 0);
+  CHECK_EQ(limit, heap->MaxOldGenerationSize());
+}
+
+
+TEST(ArrayBufferTracker) {
+  CcTest::InitializeVM();
+  v8::HandleScope scope(CcTest::isolate());
+  Heap* heap = CcTest::heap();
+  ArrayBufferTracker* tracker = heap->array_buffer_tracker();
+  heap->CollectAllGarbage(Heap::kNoGCFlags);
+  size_t retained = tracker->retained_bytes();
+
+  CompileRun("var live = new ArrayBuffer(1000);"
+             "for (var i = 0; i < 100; i++) new ArrayBuffer(1000);");
+  CHECK(tracker->retained_bytes() == retained + 101 * 1000);
+
+  // A scavenge is enough to free the backing stores of the dead buffers.
+  heap->CollectGarbage(NEW_SPACE);
+  CHECK(tracker->retained_bytes() == retained + 1000);
+  CHECK(tracker->retained_bytes_in_new_space() <= 1000);
+
+  CompileRun("live = null;");
+  heap->CollectAllGarbage(Heap::kNoGCFlags);
+  CHECK(tracker->retained_bytes() == retained);
+  CHECK(tracker->retained_bytes_in_new_space() == 0);
+}
+
+
+TEST(ArrayBufferFreeingNeedsThreadSafeAllocator) {
+  i::FLAG_concurrent_array_buffer_freeing = true;
+  CcTest::InitializeVM();
+  v8::HandleScope scope(CcTest::isolate());
+  Heap* heap = CcTest::heap();
+  ArrayBufferTracker* tracker = heap->array_buffer_tracker();
+  CHECK(CcTest::i_isolate()->unmapper_thread() != NULL);
+  // The cctest allocator does not declare itself thread-safe.
+  CHECK(!V8::ArrayBufferAllocator()->IsThreadSafe());
+
+  CompileRun("for (var i = 0; i < 100; i++) new ArrayBuffer(1000);");
+  heap->CollectGarbage(NEW_SPACE);
+  CHECK(!tracker->has_queued_frees());
+  heap->CollectAllGarbage(Heap::kNoGCFlags);
+  CHECK(!tracker->has_queued_frees());
+}
+
+
+TEST(SweptMemoryForgetsRecordedSlots) {
+  // Dead tenured arrays pointing to a young object leave slots in the
+  // remembered set.  Once the sweeper has freed them, raw fields allocated in
+  // their place must not be taken for pointers by the next scavenge.
+  i::FLAG_never_compact = true;
+  CcTest::InitializeVM();
+  Isolate* isolate = CcTest::i_isolate();
+  Heap* heap = isolate->heap();
+  Factory* factory = isolate->factory();
+  v8::HandleScope scope(CcTest::isolate());
+
+  Handle<HeapNumber> young = factory->NewHeapNumber(1.5);
+  CHECK(heap->InNewSpace(*young));
+
+  // Interleave the dead arrays with live ones so that their pages survive
+  // and the dead arrays end up on the free list.
+  static const int kArrays = 64;
+  static const int kLength = 1024;
+  Handle<FixedArray> live = factory->NewFixedArray(kArrays, TENURED);
+  {
+    v8::HandleScope inner_scope(CcTest::isolate());
+    for (int i = 0; i < kArrays; i++) {
+      Handle<FixedArray> dead = factory->NewFixedArray(kLength, TENURED);
+      for (int j = 0; j < kLength; j++) dead->set(j, *young);
+      live->set(i, *factory->NewFixedArray(1, TENURED));
+    }
+  }
+  // Sweeps precisely and without sweeper threads.
+  heap->CollectAllGarbage(Heap::kMakeHeapIterableMask);
+  CHECK(heap->InNewSpace(*young));
+
+  // Reuse the memory for array buffers whose backing store field holds the
+  // current address of the young object.
+  Handle<Map> map(isolate->native_context()->array_buffer_fun()->initial_map());
+  static const int kBuffers = kArrays * kLength * kPointerSize /
+      JSArrayBuffer::kSizeWithInternalFields;
+  Handle<FixedArray> buffers = factory->NewFixedArray(kBuffers, TENURED);
+  void* young_address = reinterpret_cast<void*>(*young);
+  for (int i = 0; i < kBuffers; i++) {
+    Handle<JSArrayBuffer> buffer = Handle<JSArrayBuffer>::cast(
+        factory->NewJSObjectFromMap(map, TENURED));
+    Runtime::SetupArrayBuffer(isolate, buffer, true, young_address, 0);
+    buffers->set(i, *buffer);
+  }
+
+  heap->CollectGarbage(NEW_SPACE);
+  CHECK(!heap->InNewSpace(*young) ||
+        reinterpret_cast<void*>(*young) != young_address);
+  for (int i = 0; i < kBuffers; i++) {
+    JSArrayBuffer* buffer = JSArrayBuffer::cast(buffers->get(i));
+    CHECK_EQ(young_address, buffer->backing_store());
+  }
+}
@@ -715,6 +715,36 @@ void TestScanRegExp(const char* re_source, const char* expected) {
 }
 
 
+TEST(StreamingPreParse) {
+  v8::V8::Initialize();
+  v8::Isolate* isolate = CcTest::isolate();
+
+  // Chunks of three bytes split the two and three byte UTF-8 sequences.
+  const char* source = "var s = '\xc3\xbc\xe2\x82\xac';\n"
+      "function foo(a) { return a + 1; }\n"
+      "function bar() { return foo(1); }";
+  int length = i::StrLength(source);
+  v8::ScriptData* expected =
+      v8::ScriptData::PreCompile(isolate, source, length);
+
+  v8::ScriptStreamer* streamer =
+      v8::ScriptStreamer::New(v8::ScriptStreamer::UTF8);
+  for (int i = 0; i < length; i += 3) {
+    streamer->AddChunk(source + i, i::Min(3, length - i));
+  }
+  v8::ScriptData* data = streamer->Finish();
+  delete streamer;
+
+  CHECK(data != NULL);
+  CHECK(!data->HasError());
+  CHECK_EQ(expected->Length(), data->Length());
+  CHECK_EQ(0, memcmp(expected->Data(), data->Data(), expected->Length()));
+
+  delete data;
+  delete expected;
+}
+
+
 TEST(RegExpScanning) {
   v8::V8::Initialize();
 
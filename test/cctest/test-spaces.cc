@@ -262,6 +262,49 @@ TEST(MemoryChunk) {
 }
 
 
+TEST(HeapCage) {
+  Isolate* isolate = CcTest::i_isolate();
+  isolate->InitializeLoggingAndCounters();
+  Heap* heap = isolate->heap();
+  CHECK(heap->ConfigureHeapDefault());
+  MemoryAllocator* memory_allocator = new MemoryAllocator(isolate);
+  CHECK(memory_allocator->SetUp(heap->MaxReserved(),
+                                heap->MaxExecutableSize()));
+  TestMemoryAllocatorScope test_allocator_scope(isolate, memory_allocator);
+
+  // The cage is aligned to its size, so offsets into it fit the cage bits.
+  HeapCage* cage = new HeapCage(isolate);
+  const size_t cage_size = 64 * MB;
+  if (!cage->SetUp(cage_size)) return;
+  CHECK(IsAddressAligned(cage->start(), cage_size, 0));
+
+  size_t allocated;
+  Address first = cage->AllocateRawMemory(Page::kPageSize, Page::kPageSize,
+                                          &allocated);
+  CHECK(allocated == static_cast<size_t>(Page::kPageSize));
+  CHECK_EQ(cage->start(), first);
+  Address second = cage->AllocateRawMemory(Page::kPageSize, 0, &allocated);
+  CHECK(cage->contains(second));
+  CHECK_EQ(cage->start() + Page::kPageSize, second);
+
+  // Committed memory in the cage is usable.
+  CHECK(cage->CommitRawMemory(second, Page::kPageSize));
+  Memory::uintptr_at(second) = 42;
+  CHECK(Memory::uintptr_at(second) == 42);
+
+  // Freed blocks are merged and handed out again.
+  cage->FreeRawMemory(first, Page::kPageSize);
+  cage->FreeRawMemory(second, Page::kPageSize);
+  Address large = cage->AllocateRawMemory(cage_size, 0, &allocated);
+  CHECK_EQ(cage->start(), large);
+  CHECK(allocated == cage_size);
+  delete cage;
+
+  memory_allocator->TearDown();
+  delete memory_allocator;
+}
+
+
 TEST(MemoryAllocator) {
   Isolate* isolate = CcTest::i_isolate();
   isolate->InitializeLoggingAndCounters();
@@ -422,3 +465,22 @@ TEST(SizeOfFirstPageIsLargeEnough) {
   // No large objects required to perform the above steps.
   CHECK(isolate->heap()->lo_space()->IsEmpty());
 }
+
+
+#if V8_TARGET_ARCH_X64
+TEST(HeapObjectsAreCaged) {
+  FLAG_heap_cage = true;
+  CcTest::InitializeVM();
+  Isolate* isolate = CcTest::i_isolate();
+  Factory* factory = isolate->factory();
+  v8::HandleScope scope(CcTest::isolate());
+
+  HeapCage* cage = isolate->heap_cage();
+  CHECK(cage != NULL && cage->exists());
+  Handle<FixedArray> young = factory->NewFixedArray(4);
+  Handle<FixedArray> old = factory->NewFixedArray(4, TENURED);
+  CHECK(cage->contains(young->address()));
+  CHECK(cage->contains(old->address()));
+  CHECK(cage->contains(isolate->heap()->meta_map()->address()));
+}
+#endif  // V8_TARGET_ARCH_X64
@@ -49,7 +49,6 @@ static Handle<JSWeakMap> AllocateJSWeakMap(Isolate* isolate) {
   Object* table_obj = ObjectHashTable::Allocate(heap, 1)->ToObjectChecked();
   ObjectHashTable* table = ObjectHashTable::cast(table_obj);
   weakmap->set_table(table);
-  weakmap->set_next(Smi::FromInt(0));
   return weakmap;
 }
 
@@ -248,3 +247,75 @@ TEST(Regress2060b) {
   heap->CollectAllGarbage(Heap::kNoGCFlags);
   heap->CollectAllGarbage(Heap::kNoGCFlags);
 }
+
+
+// Test that values reachable only through a long chain of weak map entries
+// are kept alive as long as the head of the chain is.
+TEST(EphemeronChain) {
+  FLAG_incremental_marking = false;
+  LocalContext context;
+  Isolate* isolate = GetIsolateFrom(&context);
+  Factory* factory = isolate->factory();
+  Heap* heap = isolate->heap();
+  HandleScope scope(isolate);
+  Handle<JSWeakMap> weakmap = AllocateJSWeakMap(isolate);
+  Handle<Map> map = factory->NewMap(JS_OBJECT_TYPE, JSObject::kHeaderSize);
+  static const int kLength = 1000;
+
+  // Entries are added from the tail of the chain on, so that every key is
+  // only reached after the tables have been scanned.
+  {
+    HandleScope scope(isolate);
+    Handle<JSObject> head = factory->NewJSObjectFromMap(map);
+    for (int i = 0; i < kLength; i++) {
+      HandleScope scope(isolate);
+      Handle<JSObject> key = factory->NewJSObjectFromMap(map);
+      PutIntoWeakMap(weakmap, key, head);
+      *head.location() = *key;
+    }
+    heap->CollectAllGarbage(Heap::kNoGCFlags);
+    CHECK_EQ(kLength,
+             ObjectHashTable::cast(weakmap->table())->NumberOfElements());
+  }
+
+  // Dropping the head of the chain frees all of it.
+  heap->CollectAllGarbage(Heap::kNoGCFlags);
+  CHECK_EQ(0, ObjectHashTable::cast(weakmap->table())->NumberOfElements());
+}
+
+
+// Test that incremental marking does not keep entries with unreachable keys
+// alive.
+TEST(IncrementalMarkingWeakness) {
+  if (!FLAG_incremental_marking) return;
+  LocalContext context;
+  Isolate* isolate = GetIsolateFrom(&context);
+  Factory* factory = isolate->factory();
+  Heap* heap = isolate->heap();
+  HandleScope scope(isolate);
+  Handle<JSWeakMap> weakmap = AllocateJSWeakMap(isolate);
+  Handle<Map> map = factory->NewMap(JS_OBJECT_TYPE, JSObject::kHeaderSize);
+  Handle<JSObject> live_key = factory->NewJSObjectFromMap(map);
+  {
+    HandleScope scope(isolate);
+    Handle<JSObject> dead_key = factory->NewJSObjectFromMap(map);
+    PutIntoWeakMap(weakmap, dead_key, factory->NewJSObjectFromMap(map));
+    PutIntoWeakMap(weakmap, live_key, factory->NewJSObjectFromMap(map));
+    heap->CollectAllGarbage(Heap::kAbortIncrementalMarkingMask);
+  }
+  CHECK_EQ(2, ObjectHashTable::cast(weakmap->table())->NumberOfElements());
+
+  MarkCompactCollector* collector = heap->mark_compact_collector();
+  if (collector->IsConcurrentSweepingInProgress()) {
+    collector->WaitUntilSweepingCompleted();
+  }
+  IncrementalMarking* marking = heap->incremental_marking();
+  marking->Start();
+  while (!marking->IsComplete()) {
+    marking->Step(MB, IncrementalMarking::NO_GC_VIA_STACK_GUARD);
+  }
+  heap->CollectAllGarbage(Heap::kNoGCFlags);
+  CHECK_EQ(1, ObjectHashTable::cast(weakmap->table())->NumberOfElements());
+  CHECK(!ObjectHashTable::cast(weakmap->table())->Lookup(*live_key)->
+        IsTheHole());
+}
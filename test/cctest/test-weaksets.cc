@@ -49,7 +49,6 @@ static Handle<JSWeakSet> AllocateJSWeakSet(Isolate* isolate) {
   Object* table_obj = ObjectHashTable::Allocate(heap, 1)->ToObjectChecked();
   ObjectHashTable* table = ObjectHashTable::cast(table_obj);
   weakset->set_table(table);
-  weakset->set_next(Smi::FromInt(0));
   return weakset;
 }
 
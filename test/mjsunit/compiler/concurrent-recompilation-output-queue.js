@@ -0,0 +1,70 @@
+// Copyright 2013 the V8 project authors. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Google Inc. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+// Flags: --allow-natives-syntax
+// Flags: --concurrent-recompilation --block-concurrent-recompilation
+// Flags: --concurrent-recompilation-threads=4
+// Flags: --concurrent-recompilation-delay=20
+
+if (!%IsConcurrentRecompilationSupported()) {
+  print("Concurrent recompilation is disabled. Skipping this test.");
+  quit();
+}
+
+// Fill the input queue of all four workers.  The delay keeps every worker
+// busy at once, so they finish and hand their jobs to the output queue at
+// about the same time.  A lost job would stay in the recompile queue
+// forever and make the synchronous status checks below hang.
+var functions = [];
+for (var i = 0; i < 32; i++) {
+  functions.push(eval("(function g" + i + "(a) {" +
+                      "  var b = a + " + i + ";" +
+                      "  return b * b;" +
+                      "})"));
+}
+
+for (var round = 0; round < 2; round++) {
+  for (var i = 0; i < functions.length; i++) {
+    %DeoptimizeFunction(functions[i]);
+    functions[i](1);
+    functions[i](2);
+    %OptimizeFunctionOnNextCall(functions[i], "concurrent");
+    functions[i](3);  // Kick off recompilation.
+  }
+
+  for (var i = 0; i < functions.length; i++) {
+    assertUnoptimized(functions[i], "no sync");
+  }
+
+  %UnblockConcurrentRecompilation();
+
+  for (var i = 0; i < functions.length; i++) {
+    assertOptimized(functions[i], "sync");
+    assertEquals((4 + i) * (4 + i), functions[i](4));
+  }
+}
@@ -246,6 +246,8 @@
         '../../src/code.h',
         '../../src/codegen.cc',
         '../../src/codegen.h',
+        '../../src/compaction-thread.cc',
+        '../../src/compaction-thread.h',
         '../../src/compilation-cache.cc',
         '../../src/compilation-cache.h',
         '../../src/compiler.cc',
@@ -312,6 +314,8 @@
         '../../src/full-codegen.h',
         '../../src/func-name-inferrer.cc',
         '../../src/func-name-inferrer.h',
+        '../../src/gc-idle-time-handler.cc',
+        '../../src/gc-idle-time-handler.h',
         '../../src/gdb-jit.cc',
         '../../src/gdb-jit.h',
         '../../src/global-handles.cc',
@@ -321,6 +325,8 @@
         '../../src/handles.cc',
         '../../src/handles.h',
         '../../src/hashmap.h',
+        '../../src/heap-controller.cc',
+        '../../src/heap-controller.h',
         '../../src/heap-inl.h',
         '../../src/heap-profiler.cc',
         '../../src/heap-profiler.h',
@@ -419,6 +425,8 @@
         '../../src/macro-assembler.h',
         '../../src/mark-compact.cc',
         '../../src/mark-compact.h',
+        '../../src/marking-thread.cc',
+        '../../src/marking-thread.h',
         '../../src/messages.cc',
         '../../src/messages.h',
         '../../src/natives.h',
@@ -433,6 +441,8 @@
         '../../src/once.h',
         '../../src/optimizing-compiler-thread.h',
         '../../src/optimizing-compiler-thread.cc',
+        '../../src/parallel-marking-thread.cc',
+        '../../src/parallel-marking-thread.h',
         '../../src/parser.cc',
         '../../src/parser.h',
         '../../src/platform/elapsed-timer.h',
@@ -483,12 +493,15 @@
         '../../src/scanner-character-streams.h',
         '../../src/scanner.cc',
         '../../src/scanner.h',
+        '../../src/scavenger-thread.cc',
+        '../../src/scavenger-thread.h',
         '../../src/scopeinfo.cc',
         '../../src/scopeinfo.h',
         '../../src/scopes.cc',
         '../../src/scopes.h',
         '../../src/serialize.cc',
         '../../src/serialize.h',
+        '../../src/slot-set.h',
         '../../src/small-pointer-list.h',
         '../../src/smart-pointers.h',
         '../../src/snapshot-common.cc',
@@ -499,6 +512,8 @@
         '../../src/store-buffer-inl.h',
         '../../src/store-buffer.cc',
         '../../src/store-buffer.h',
+        '../../src/streaming-preparser.cc',
+        '../../src/streaming-preparser.h',
         '../../src/string-search.cc',
         '../../src/string-search.h',
         '../../src/string-stream.cc',
@@ -526,6 +541,8 @@
         '../../src/unicode.cc',
         '../../src/unicode.h',
         '../../src/unique.h',
+        '../../src/unmapper-thread.cc',
+        '../../src/unmapper-thread.h',
         '../../src/uri.h',
         '../../src/utils-inl.h',
         '../../src/utils.cc',